@@ -0,0 +1,130 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <options/options.hpp>
+#include <parareal/parareal.hpp>
+#include <scenario/scenario.hpp>
+#include <simulation/simulation.hpp>
+#include <step_control/step_control.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+using std::cout, std::cerr;
+
+/// <summary>
+/// Integrates the batch run with parareal, and serially for comparison. Prints the convergence of every iteration,
+/// the speedup over the serial run and how far apart both final states are
+/// </summary>
+static void run_parareal(const SimulationOptions& options, BodyStore& bodies, ThreadPool& thread_pool) {
+	auto make_fine = [&]() {
+		return Integrator(options.integrator, options.kepler_threshold, options.regularization_radius);
+	};
+	BodyStore serial_bodies = bodies;
+	Integrator serial_integrator = make_fine();
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int step = 0; step < options.step_count; ++step) {
+		step_simulation(serial_bodies, options.gravity, serial_integrator, options.delta_time, thread_pool);
+	}
+	const double serial_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	PararealDriver driver(options.parareal);
+	start = std::chrono::steady_clock::now();
+	driver.run(bodies, options.gravity, make_fine, options.delta_time, options.step_count, thread_pool);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const PararealStatistics& statistics = driver.statistics();
+	cout << "parareal slices: " << options.parareal.slice_count << " (coarse " << integrator_name(options.parareal.coarse_integrator)
+		<< ", ratio " << options.parareal.coarse_ratio << ")\n"
+		<< "initial coarse pass: " << statistics.initial_seconds << " s\n";
+	for (unsigned int k = 0; k < statistics.iterations.size(); ++k) {
+		cout << "iteration " << k + 1 << ": change " << statistics.iterations[k].change
+			<< ", " << statistics.iterations[k].seconds << " s\n";
+	}
+	float difference = 0.0f;
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		difference = std::max(difference, glm::length(bodies.positions[i] - serial_bodies.positions[i]));
+	}
+	cout << (statistics.converged ? "converged" : "not converged") << "\n"
+		<< "serial elapsed: " << serial_seconds << " s\n"
+		<< "parareal elapsed: " << seconds << " s\n"
+		<< "speedup: " << (seconds > 0.0 ? serial_seconds / seconds : 0.0) << "\n"
+		<< "largest position difference from serial: " << difference << "\n"
+		<< "body force evaluations: " << statistics.fine_evaluations << " fine, " << statistics.coarse_evaluations
+		<< " coarse, " << serial_integrator.evaluations() << " serial\n";
+}
+
+/// <summary>
+/// Runs a simulation without a window, as fast as possible, and writes the final state to disk.
+/// Takes the same arguments as parse_simulation_options.
+/// </summary>
+int main(int argc, char* argv[])
+{
+	SimulationOptions options;
+	options.scenario = ScenarioKind::cloud;
+	if (!parse_simulation_options(argc, argv, options)) {
+		return 1;
+	}
+	ThreadPool thread_pool(options.thread_count);
+	BodyStore bodies = make_scenario(options);
+	TracerStore tracers = make_scenario_tracers(options, bodies);
+	Integrator integrator(options.integrator, options.kepler_threshold, options.regularization_radius);
+	StepController step_controller(options.step_control, options.delta_time);
+
+	cout << "scenario: " << scenario_name(options.scenario) << "\n"
+		<< "bodies: " << bodies.size() << "\n"
+		<< "tracers: " << tracers.size() << "\n"
+		<< "solver: " << solver_name(options.gravity.solver) << "\n"
+		<< "simd: " << simd_level_name(options.gravity.simd_level) << "\n"
+		<< "integrator: " << integrator_name(options.integrator) << "\n"
+		<< "threads: " << thread_pool.size() << "\n"
+		<< "dt: " << options.delta_time << (options.step_control.adaptive ? " (adaptive)" : "") << "\n"
+		<< "steps: " << options.step_count << "\n";
+
+	if (options.parareal.slice_count > 0) {
+		// Fixed steps only, tracers are left where they are
+		run_parareal(options, bodies, thread_pool);
+		return !options.output_path.empty() && !write_state_csv(bodies, options.output_path) ? 1 : 0;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	if (options.step_control.adaptive && tracers.size() == 0) {
+		// The same simulated time as the fixed steps would cover
+		step_controller.advance(bodies, options.gravity, integrator, static_cast<double>(options.step_count) * options.delta_time, thread_pool);
+	}
+	else if (options.step_control.adaptive) {
+		// Tracers follow in steps of dt, the bodies take as many adaptive steps as they need in between
+		for (unsigned int step = 0; step < options.step_count; ++step) {
+			tracers.begin_step(bodies, options.gravity, options.delta_time, thread_pool);
+			step_controller.advance(bodies, options.gravity, integrator, options.delta_time, thread_pool);
+			tracers.finish_step(bodies, options.gravity, options.delta_time, thread_pool);
+		}
+	}
+	else {
+		for (unsigned int step = 0; step < options.step_count; ++step) {
+			step_simulation(bodies, tracers, options.gravity, integrator, options.delta_time, thread_pool);
+		}
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const double seconds = std::chrono::duration<double>(end - start).count();
+	const unsigned long long steps_taken = options.step_control.adaptive ? step_controller.statistics().accepted : options.step_count;
+	const double steps_per_second = seconds > 0.0 ? steps_taken / seconds : 0.0;
+	if (options.step_control.adaptive) {
+		const StepStatistics& statistics = step_controller.statistics();
+		cout << "simulated time: " << statistics.simulated_time << "\n"
+			<< "accepted steps: " << statistics.accepted << " (" << options.step_count << " at fixed dt)\n"
+			<< "rejected steps: " << statistics.rejected << "\n"
+			<< "step range: " << statistics.smallest_step << " to " << statistics.largest_step << "\n";
+	}
+	cout << "elapsed: " << seconds << " s\n"
+		<< "steps per second: " << steps_per_second << "\n"
+		<< "body steps per second: " << steps_per_second * bodies.size() << "\n"
+		<< "body force evaluations: " << integrator.evaluations() << "\n";
+	if (tracers.size() > 0) {
+		cout << "tracer steps per second: " << (seconds > 0.0 ? static_cast<double>(options.step_count) * tracers.size() / seconds : 0.0) << "\n";
+	}
+
+	if (!options.output_path.empty() && !write_state_csv(bodies, options.output_path)) {
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+struct OctreeNode {
+	// Geometric center and half of the side length of the cubic cell
+	glm::vec3 center;
+	float half_size;
+	// Aggregated mass of every body inside the cell
+	glm::vec3 center_of_mass;
+	float mass;
+	// Index of the first of the 8 contiguous children, 0 if the node is a leaf
+	unsigned int first_child;
+	// Range of Octree::order covered by this node
+	unsigned int begin, end;
+};
+
+class Octree {
+public:
+	std::vector<OctreeNode> nodes;
+	// Body indices, sorted so that every node covers a contiguous range
+	std::vector<unsigned int> order;
+	// Position and mass of the bodies, stored in the same order as Octree::order
+	std::vector<glm::vec3> positions;
+	std::vector<float> masses;
+	unsigned int leaf_capacity;
+
+	explicit Octree(const unsigned int leaf_capacity = 8);
+	/// <summary>
+	/// Rebuilds the tree from the current positions and masses of the bodies
+	/// </summary>
+	void build(const BodyStore& bodies);
+	/// <summary>
+	/// Computes the gravitational force and torque acting on a body. Cells that satisfy the opening criterion
+	/// are approximated as point masses located at their center of mass.
+	/// </summary>
+	/// <param name="position">Position of the body being acted upon</param>
+	/// <param name="mass">Mass of the body being acted upon</param>
+	/// <param name="world_inertia">World-space inertia tensor of the body being acted upon</param>
+	/// <param name="index">Index of the body in the store the tree was built from, so it can skip itself</param>
+	/// <param name="G">The gravitational constant</param>
+	/// <param name="opening_angle">The Barnes-Hut opening angle (theta)</param>
+	/// <param name="force">Output force</param>
+	/// <param name="torque">Output torque</param>
+	void evaluate(const glm::vec3& position, const float mass, const glm::mat3& world_inertia, const unsigned int index, const float G, const float opening_angle,
+		glm::vec3& force, glm::vec3& torque) const;
+	/// <summary>
+	/// Adds the gravitational force and torque acting on every body to forces and torques.
+	/// The tree must have been built from the same store. Traversals are split in blocks across the thread pool.
+	/// </summary>
+	void accumulate_gravity(BodyStore& bodies, const float G, const float opening_angle, ThreadPool& thread_pool) const;
+private:
+	std::vector<unsigned int> scratch;
+	void subdivide(const unsigned int node_index, const unsigned int depth);
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <rigid_body/rigid_body.hpp>
+#include <mesh_asset/mesh_asset.hpp>
+
+/// <summary>
+/// Per-body data that is never touched by the force and integration loops. The geometry itself lives in the
+/// store's MeshRegistry and is shared by every body referencing the same mesh.
+/// </summary>
+struct BodyShape {
+	MeshHandle mesh;
+	float density;
+};
+
+struct PointView {
+	float& mass;
+	glm::vec3& position;
+	glm::vec3& linear_momentum;
+	glm::vec3& force;
+};
+
+/// <summary>
+/// References to a single body inside a BodyStore, laid out with the same names as RigidBody
+/// </summary>
+struct RigidBodyView {
+	PointView center_of_mass;
+	glm::vec3& angular_momentum;
+	glm::vec3& torque;
+	glm::quat& orientation_quat;
+
+	const float& density;
+	const float& volume;
+	const glm::mat3& inertia_tensor;
+	const glm::mat3& inverse_inertia_tensor;
+	const glm::vec3& principal_moments;
+	const glm::quat& principal_frame;
+
+	glm::vec3& velocity;
+	glm::vec3& angular_velocity;
+	glm::mat3& world_inertia;
+	glm::mat3& inverse_world_inertia;
+	glm::mat3& rotation_matrix;
+
+	const std::vector<glm::vec3>& vertices;
+};
+
+/// <summary>
+/// Structure-of-arrays storage of rigid bodies. Every vector holds one entry per body, so the force loops only
+/// pull the fields they read (position, mass, world_inertia) through the cache.
+/// </summary>
+class BodyStore {
+public:
+	// State variables
+	std::vector<glm::vec3> positions, linear_momenta, forces;
+	std::vector<float> masses;
+	std::vector<glm::vec3> angular_momenta, torques;
+	std::vector<glm::quat> orientations;
+
+	//Auxiliary variables
+	std::vector<glm::vec3> velocities, angular_velocities;
+	std::vector<glm::mat3> world_inertias, inverse_world_inertias, rotation_matrices;
+
+	// Constants
+	std::vector<glm::mat3> inertia_tensors, inverse_inertia_tensors;
+	std::vector<glm::vec3> principal_moments;
+	std::vector<glm::quat> principal_frames;
+	std::vector<BodyShape> shapes;
+	MeshRegistry meshes;
+
+	unsigned int size() const;
+	void reserve(const unsigned int capacity);
+	/// <summary>
+	/// Copies a rigid body into the store. Its vertices are registered as a new mesh.
+	/// </summary>
+	/// <returns>The index of the body inside the store</returns>
+	unsigned int add(const RigidBody& body);
+	/// <summary>
+	/// Adds a body built from a registered mesh, at rest and placed like RigidBody would place it.
+	/// Only the mass properties are scaled by density, the geometry is not copied.
+	/// </summary>
+	/// <returns>The index of the body inside the store</returns>
+	unsigned int add(const MeshHandle mesh, const float density);
+	RigidBodyView view(const unsigned int index);
+	/// <summary>
+	/// Same as RigidBody::update_state, for every body in the store
+	/// </summary>
+	/// <param name="delta_time">The time dt in which the simulation happens</param>
+	void update_state(const float delta_time);
+	/// <summary>
+	/// Adds force * delta_time to the linear momentum and torque * delta_time to the angular momentum of every body
+	/// </summary>
+	void kick(const float delta_time);
+	/// <summary>
+	/// Moves every body with its current velocity and rotates it as a free rigid body (rotate_free_body) with its
+	/// current angular momentum. Velocities must be up to date
+	/// </summary>
+	void drift(const float delta_time);
+	/// <summary>
+	/// Sets every force and torque to zero
+	/// </summary>
+	void clear_forces();
+	/// <summary>
+	/// Same as RigidBody::update_auxiliary_variables, for every body in the store
+	/// </summary>
+	void update_auxiliary_variables();
+};
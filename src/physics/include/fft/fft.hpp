@@ -0,0 +1,36 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <thread_pool/thread_pool.hpp>
+
+bool is_power_of_two(const unsigned int n);
+
+/// <summary>
+/// Iterative radix-2 complex FFT of a fixed power-of-two length. Twiddle factors and the bit reversal permutation
+/// are computed once, in double precision and then rounded, when the plan is created.
+/// </summary>
+class FftPlan {
+public:
+	explicit FftPlan(const unsigned int length);
+	unsigned int size() const;
+	/// <summary>
+	/// Transforms length contiguous values in place. The inverse transform is scaled by 1 / length,
+	/// so forward followed by inverse returns the input.
+	/// </summary>
+	void transform(std::complex<float>* data, const bool inverse) const;
+private:
+	unsigned int length;
+	std::vector<unsigned int> reversed;
+	std::vector<std::complex<float>> twiddles;
+};
+
+/// <summary>
+/// In-place 3D FFT of a cubic grid of side n stored x-fastest (index = (z * n + y) * n + x).
+/// Every axis is transformed line by line, with lines split in blocks across the thread pool.
+/// </summary>
+/// <param name="extent">For zero padded grids. When not 0, the forward transform assumes only nodes with every
+/// coordinate below extent are non-zero, and the inverse transform only computes those nodes; the rest are left
+/// with partial results</param>
+void fft_3d(std::vector<std::complex<float>>& grid, const unsigned int n, const bool inverse, ThreadPool& thread_pool,
+	const unsigned int extent = 0);
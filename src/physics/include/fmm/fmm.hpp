@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+#include <barnes_hut/barnes_hut.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <gravity_simd/gravity_simd.hpp>
+
+// Lowest and highest expansion orders accepted by the fast multipole solver. Order 2 is needed for the tidal torque
+constexpr unsigned int min_multipole_order = 2;
+constexpr unsigned int max_multipole_order = 8;
+// Cells with more bodies than this are split into several tasks of the parallel passes. Fixed so results do not
+// depend on the amount of threads
+constexpr unsigned int multipole_task_size = 2048;
+
+/// <summary>
+/// Term of an operator that moves an expansion to another center: low += binomial * high * d^difference
+/// </summary>
+struct ShiftTerm {
+	unsigned int high, low, difference;
+	double binomial;
+};
+
+/// <summary>
+/// Term of the multipole to local conversion: local += binomial * multipole * derivative
+/// </summary>
+struct InteractionTerm {
+	unsigned int local, multipole, derivative;
+	double binomial;
+};
+
+/// <summary>
+/// Multi-indices (x, y, z) of a Cartesian expansion up to a given total order, in graded order, together with the
+/// index lists the expansion operators iterate over. Index 0 is the monopole, 1-3 the first order, 4-9 the second.
+/// </summary>
+class MultiIndexTable {
+public:
+	unsigned int order, size;
+	std::vector<std::array<unsigned int, 3>> indices;
+	std::vector<unsigned int> degrees;
+	// Terms of the M2M and L2L operators, with low <= high component-wise
+	std::vector<ShiftTerm> shift_terms;
+	// Subset of shift_terms that produces first and second order terms, used to evaluate fields and tidal tensors
+	std::vector<ShiftTerm> evaluation_terms;
+	// Terms of the M2L operator, sorted by local coefficient. Those of coefficient k are in [interaction_begin[k], interaction_begin[k + 1])
+	std::vector<InteractionTerm> interaction_terms;
+	std::vector<unsigned int> interaction_begin;
+
+	explicit MultiIndexTable(const unsigned int order);
+	unsigned int index(const unsigned int x, const unsigned int y, const unsigned int z) const;
+	/// <summary>
+	/// Writes d^n for every multi-index n
+	/// </summary>
+	void powers(const double d[3], double* out) const;
+	/// <summary>
+	/// Writes the Taylor coefficients of 1/|R|, that is the derivative of order n divided by n!, for every multi-index n
+	/// </summary>
+	void derivatives(const double R[3], double* out) const;
+private:
+	std::vector<unsigned int> lookup;
+	// Index of the multi-index with one (below) or two (below_twice) units less on an axis, size if there is none
+	std::array<std::vector<unsigned int>, 3> below, below_twice;
+	// A non-zero axis of every multi-index and the index it is reached from, used to build powers incrementally
+	std::vector<unsigned int> power_parent, power_axis;
+	// (2|n| - 1) / |n| and (|n| - 1) / |n|, the factors of the derivative recurrence
+	std::vector<double> first_factor, second_factor;
+};
+
+/// <summary>
+/// Fast multipole gravity solver using Cartesian Taylor expansions on top of the Barnes-Hut octree.
+/// Moments are taken around every cell's center of mass. A dual tree traversal converts the moments of well separated
+/// cells into local expansions, which are shifted down the tree and evaluated at every body for both the field and
+/// the tidal tensor, so the force and the torque come from the same expansion. Close leaves are evaluated directly with
+/// the batched gravity kernels. The cost is O(N) for a fixed order and opening angle.
+/// </summary>
+class FastMultipole {
+public:
+	Octree octree;
+	MultiIndexTable table;
+	// Expansion coefficients of every octree node, table.size per node
+	std::vector<double> multipoles, locals;
+	// Distance from every node's center of mass to its furthest body
+	std::vector<float> radii;
+
+	/// <param name="order">Expansion order, clamped to [min_multipole_order, max_multipole_order]</param>
+	/// <param name="leaf_capacity">Maximum amount of bodies in an octree leaf</param>
+	explicit FastMultipole(const unsigned int order = 4, const unsigned int leaf_capacity = 8);
+	/// <summary>
+	/// Builds the tree and the expansions from the current state, then adds the gravitational force and torque acting on
+	/// every body to forces and torques. Auxiliary variables must be up to date.
+	/// </summary>
+	/// <param name="opening_angle">Cells A and B interact through expansions when r_A + r_B &lt; theta * distance.
+	/// Values of 1 or more would accept overlapping cells, so they are clamped below 1</param>
+	/// <param name="simd_level">Widest instruction set used for the near field</param>
+	void accumulate_gravity(BodyStore& bodies, const float G, const float opening_angle, const SimdLevel simd_level, ThreadPool& thread_pool);
+private:
+	// Roots of the subtrees handled by a single task, and the nodes above them
+	std::vector<unsigned int> tasks, top_nodes;
+	// Per body data in tree order
+	std::vector<glm::mat3> world_inertias;
+	std::vector<glm::vec3> forces, torques;
+
+	// The passes below take a scratch buffer of table.size values for the powers of an offset
+	bool is_leaf(const unsigned int node) const;
+	void split_tasks();
+	void upward_pass(const unsigned int node, const float G, double* powers);
+	void combine_children(const unsigned int node, double* powers);
+	void interact(const unsigned int root, const float G, const float opening_angle, const GravityKernel kernel);
+	void downward_pass(const unsigned int node, double* powers);
+	void multipole_to_local(const unsigned int target, const unsigned int source, double* derivatives);
+	void direct_interaction(const unsigned int target, const std::vector<unsigned int>& source_leaves, const float G, const GravityKernel kernel);
+	void evaluate_locals(const unsigned int leaf, double* powers);
+};
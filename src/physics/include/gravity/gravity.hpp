@@ -0,0 +1,138 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <rigid_body/rigid_body.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <gravity/gravity_kernels.hpp>
+#include <gravity_simd/gravity_simd.hpp>
+
+// Amount of target bodies handled by a single task of the parallel force phase
+constexpr unsigned int force_block_size = 64;
+// Side of the tiles visited by the symmetric solver, a multiple of gravity_source_padding. Two tiles of positions, masses
+// and accumulators fit in L1
+constexpr unsigned int symmetric_tile_size = 256;
+
+enum class GravitySolver {
+	direct,
+	symmetric,
+	barnes_hut,
+	fmm,
+	particle_mesh,
+	p3m
+};
+
+enum class MeshBoundary {
+	// The grid is one cell of an infinite periodic lattice
+	periodic,
+	// The bodies are alone in empty space. The grid is zero padded to twice its size
+	isolated
+};
+
+enum class MassAssignment {
+	// Cloud in cell, 2 cells per axis
+	cic,
+	// Triangular shaped cloud, 3 cells per axis
+	tsc
+};
+
+struct GravitySettings {
+	float G = 1.0f;
+	GravitySolver solver = GravitySolver::direct;
+	// Barnes-Hut opening angle (theta). A node of side s at distance d is approximated
+	// as a point mass when s / d < theta. theta = 0 reproduces the direct solver.
+	// The fast multipole solver reuses it for its own criterion, r_A + r_B < theta * d.
+	float opening_angle = 0.5f;
+	// Expansion order of the fast multipole solver, from 2 to 8. Higher orders are more accurate and more expensive
+	unsigned int multipole_order = 4;
+	// Leaf capacity of the fast multipole solver. Larger than the Barnes-Hut one because its near field runs on the
+	// batched kernels, while every extra cell adds expansion work
+	unsigned int multipole_leaf_capacity = 32;
+	// Cells per side of the particle-mesh and P3M grid, a power of two of at least 16
+	unsigned int mesh_size = 64;
+	MeshBoundary mesh_boundary = MeshBoundary::isolated;
+	MassAssignment mass_assignment = MassAssignment::cic;
+	// Side of the periodic box, centered at the origin. 0 fits the box to the bodies on every evaluation.
+	// Isolated grids are always fitted to the bodies
+	float mesh_box_size = 0.0f;
+	// Radius, in mesh cells, at which the P3M solver hands gravity from the direct short-range sum over to the mesh.
+	// Larger radii are more accurate and spend more time in the short-range sum
+	float p3m_split_radius = 1.25f;
+	// Maximum amount of bodies stored in an octree leaf before it is subdivided
+	unsigned int leaf_capacity = 8;
+	// Widest instruction set the direct solver may use. Levels the CPU does not support fall back to narrower ones
+	SimdLevel simd_level = detect_simd_level();
+	// Highest order of the mesh mass moments nearby bodies interact through, from 2 to 8. 0 keeps every body a point mass
+	// source with a quadrupole torque, whatever the distance
+	unsigned int mesh_multipole_order = 0;
+	// Bodies closer than this many times the sum of their bounding radii interact through their mesh multipoles
+	float mesh_multipole_range = 4.0f;
+	// Bodies and tracers closer than this many bounding radii to a body whose mesh has a polyhedron model feel the exact
+	// field of its constant density polyhedron instead of a point mass (accumulate_polyhedron_gravity). 0 disables it
+	float polyhedron_range = 0.0f;
+};
+
+/// <summary>
+/// Tidal torque exerted on a rigid body by a point mass located at r (relative to the body's center of mass)
+/// </summary>
+/// <param name="rb">The body being acted upon. Its world_inertia must be up to date</param>
+/// <param name="r">Position of the source relative to the body</param>
+/// <param name="mu">Gravitational parameter (G * M) of the source</param>
+glm::vec3 gravity_torque(const RigidBody& rb, const glm::vec3& r, const float mu);
+glm::vec3 gravity_torque(const glm::mat3& world_inertia, const glm::vec3& r, const float mu);
+
+/// <summary>
+/// Torque exerted on a rigid body by a tidal tensor, that is the gradient of the gravitational field at its center of mass.
+/// For a single point source it equals gravity_torque.
+/// </summary>
+/// <param name="tidal">Symmetric tidal tensor</param>
+/// <param name="world_inertia">World-space inertia tensor of the body</param>
+glm::vec3 tidal_torque(const glm::mat3& tidal, const glm::mat3& world_inertia);
+
+/// <summary>
+/// Gravitational force exerted on a rigid body by a point mass located at r (relative to the body's center of mass)
+/// </summary>
+/// <param name="rb">The body being acted upon</param>
+/// <param name="r">Position of the source relative to the body</param>
+/// <param name="mu">Gravitational parameter (G * M) of the source</param>
+glm::vec3 gravity_force(const RigidBody& rb, const glm::vec3& r, const float mu);
+glm::vec3 gravity_force(const float mass, const glm::vec3& r, const float mu);
+
+/// <summary>
+/// Adds the gravitational force and torque every body exerts on every other body to forces and torques,
+/// evaluating every ordered pair with the batched kernel of the requested SIMD level. Auxiliary variables must be up to date.
+/// Target bodies are split in blocks across the thread pool; every body's sum is formed in the same order
+/// regardless of the amount of threads, so results are reproducible.
+/// </summary>
+void accumulate_gravity_direct(BodyStore& bodies, const float G, const SimdLevel simd_level, ThreadPool& thread_pool);
+
+/// <summary>
+/// Same result as accumulate_gravity_direct, but every unordered pair is visited once inside cache-sized tiles by the
+/// symmetric kernel of the requested SIMD level, and applies equal and opposite forces. The torques are summed as one tidal
+/// term per body, turned into a torque with its own world inertia by tidal_torque. Tile pairs run in rounds that never share
+/// a tile, so a single set of accumulators is enough and sums are formed in a fixed order.
+/// </summary>
+void accumulate_gravity_symmetric(BodyStore& bodies, const float G, const SimdLevel simd_level, ThreadPool& thread_pool);
+
+/// <summary>
+/// Whether target feels the polyhedron field of source: source has a polyhedron model (MeshRegistry::set_polyhedron_models),
+/// target is closer than settings.polyhedron_range bounding radii of source and small enough to be taken as a point
+/// (polyhedron_point_ratio)
+/// </summary>
+bool polyhedron_pair(const BodyStore& bodies, const GravitySettings& settings, const unsigned int source, const unsigned int target);
+
+/// <summary>
+/// Replaces the point mass force of every polyhedron_pair by the exact field of the source's polyhedron at the target's
+/// center of mass, and gives the source the opposite force and its torque. The point mass force and gravity_torque each
+/// solver gives to such pairs are subtracted, so this runs after the solver. The target keeps its point mass tidal torque.
+/// Pairs are searched directly in O(n^2) over the thread pool. Auxiliary variables must be up to date.
+/// </summary>
+void accumulate_polyhedron_gravity(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool);
+
+/// <summary>
+/// Adds the gravitational force and torque acting on every body to forces and torques,
+/// using the solver selected in settings, then the mesh multipole correction of nearby bodies
+/// (accumulate_mesh_multipole_gravity) and the polyhedron field of close small bodies (accumulate_polyhedron_gravity)
+/// when enabled. Auxiliary variables must be up to date.
+/// </summary>
+void accumulate_gravity(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool);
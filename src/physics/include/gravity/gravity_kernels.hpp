@@ -0,0 +1,162 @@
+#pragma once
+
+// This header is included by the translation units compiled with ISA-specific flags (AVX2, AVX-512...).
+// It must not pull in glm or the standard library: inline functions instantiated there could be merged by the
+// linker into code that runs on CPUs without those instructions.
+
+constexpr float EPSILON = 0.005f;
+
+/// <summary>
+/// Sources of a batched gravity evaluation in structure-of-arrays form. Arrays hold padded_count elements;
+/// the entries past count are zero and are masked out by the kernels.
+/// </summary>
+struct GravitySourceArrays {
+	const float* x;
+	const float* y;
+	const float* z;
+	// Gravitational parameter (G * M) of every source
+	const float* mu;
+	unsigned int count;
+	unsigned int padded_count;
+};
+
+struct GravityTarget {
+	float position[3];
+	float mass;
+	// Column-major world inertia tensor, same layout as glm::mat3
+	float world_inertia[9];
+	// Index of the target inside the sources, skipped by the kernels. Use a value >= count if it is not a source
+	unsigned int skip_index;
+};
+
+/// <summary>
+/// Sums gravity_force and gravity_torque of every source acting on the target.
+/// </summary>
+typedef void (*GravityKernel)(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]);
+
+// Sources are padded to a multiple of the widest kernel
+constexpr unsigned int gravity_source_padding = 16;
+
+/// <summary>
+/// Sets the acceleration every source gives to count massless tracers (gravity_force per unit mass). Tracers are given as
+/// structure of arrays, padded to a multiple of gravity_source_padding. Tracers sitting exactly on a source get nothing from it.
+/// </summary>
+typedef void (*TracerKernel)(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az);
+
+void gravity_kernel_scalar(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]);
+void gravity_kernel_sse42(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]);
+void gravity_kernel_avx2(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]);
+void gravity_kernel_avx512(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]);
+
+/// <summary>
+/// Bodies read by the symmetric kernels, as structure of arrays holding padded_count elements. The entries past count
+/// are zero and are masked out by the kernels.
+/// </summary>
+struct SymmetricBodyArrays {
+	const float* x;
+	const float* y;
+	const float* z;
+	const float* mass;
+	unsigned int count;
+	unsigned int padded_count;
+};
+
+/// <summary>
+/// Sums written by the symmetric kernels, in the layout of SymmetricBodyArrays: the force, and the sum of
+/// 3 G m r r^T / r^5 over the other bodies, which tidal_torque turns into gravity_torque summed over the other bodies.
+/// A multiple of the identity exerts no torque, so the latter is stored without its zz entry as xx - zz, yy - zz, xy, xz, yz.
+/// </summary>
+struct SymmetricAccumulators {
+	float* force[3];
+	float* tidal[5];
+};
+
+/// <summary>
+/// Visits every pair of bodies i in [i_begin, i_end), j in [j_begin, j_end) with i &lt; j once and adds gravity_force
+/// to both, j getting the opposite one, and the tidal term of each body on the other. j_begin and j_end are multiples of
+/// gravity_source_padding, at most padded_count. Threads running the kernel at the same time must not share bodies.
+/// </summary>
+typedef void (*SymmetricGravityKernel)(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators);
+
+void symmetric_gravity_kernel_scalar(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators);
+void symmetric_gravity_kernel_sse42(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators);
+void symmetric_gravity_kernel_avx2(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators);
+void symmetric_gravity_kernel_avx512(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators);
+
+void tracer_kernel_scalar(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az);
+void tracer_kernel_sse42(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az);
+void tracer_kernel_avx2(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az);
+void tracer_kernel_avx512(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az);
+
+/// <summary>
+/// Edge of a polyhedron as read by the polyhedron kernels: its two vertices, its length and its dyad
+/// E = n_A n_A,e^T + n_B n_B,e^T (Werner and Scheeres), built from the normals of the two faces sharing it and their
+/// outward normals to the edge. The dyad is symmetric and stored as xx, yy, zz, xy, xz, yz, followed by the dyad
+/// applied to the first vertex. 48 bytes, so a cache line holds whole edges.
+/// </summary>
+struct PolyhedronEdge {
+	unsigned int first, second;
+	float length;
+	float dyad[6];
+	float dyad_first[3];
+};
+
+/// <summary>
+/// Face of a polyhedron as read by the polyhedron kernels: its vertices in counterclockwise order seen from outside,
+/// its outward unit normal and the offset of its plane (normal . vertex). The face dyad F = n n^T is never formed
+/// </summary>
+struct PolyhedronFace {
+	unsigned int vertices[3];
+	float normal[3];
+	float offset;
+	float padding;
+};
+
+/// <summary>
+/// Closed polyhedron of constant density, in its own frame, with vertices shared by their edges and faces
+/// </summary>
+struct PolyhedronArrays {
+	const float* vertex_x;
+	const float* vertex_y;
+	const float* vertex_z;
+	unsigned int vertex_count;
+	const PolyhedronEdge* edges;
+	unsigned int edge_count;
+	const PolyhedronFace* faces;
+	unsigned int face_count;
+	// G times the density
+	float mu_density;
+};
+
+// Floats of scratch the polyhedron kernels need per vertex: offset and distance of every vertex for a vector of points
+constexpr unsigned int polyhedron_scratch_per_vertex = 4 * gravity_source_padding;
+
+/// <summary>
+/// Sets the exact acceleration of the polyhedron at count field points (Werner and Scheeres 1997):
+/// a = -G rho sum_e E_e r_e L_e + G rho sum_f F_f r_f omega_f, where r_e and r_f go from the point to the edge and face,
+/// L_e = ln((a + b + e) / (a + b - e)) with a, b the distances to the edge ends and e its length, and omega_f is the
+/// solid angle of the face. Valid inside and outside the polyhedron. Points are given as structure of arrays, padded to a
+/// multiple of gravity_source_padding; the edges a point sits on are left out of its sum.
+/// </summary>
+/// <param name="scratch">polyhedron_scratch_per_vertex * vertex_count floats</param>
+typedef void (*PolyhedronKernel)(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az);
+
+void polyhedron_kernel_scalar(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az);
+void polyhedron_kernel_sse42(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az);
+void polyhedron_kernel_avx2(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az);
+void polyhedron_kernel_avx512(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az);
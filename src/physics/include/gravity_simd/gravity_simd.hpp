@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <gravity/gravity_kernels.hpp>
+
+enum class SimdLevel {
+	scalar,
+	sse42,
+	avx2,
+	avx512
+};
+
+/// <summary>
+/// Detects the widest instruction set supported by both the CPU and the operating system.
+/// The result is computed once and cached.
+/// </summary>
+SimdLevel detect_simd_level();
+const char* simd_level_name(const SimdLevel level);
+/// <summary>
+/// Returns the kernel for the requested level, falling back to narrower ones when the CPU does not support it
+/// </summary>
+GravityKernel select_gravity_kernel(const SimdLevel level);
+/// <summary>
+/// Same as select_gravity_kernel, for the symmetric pair kernels
+/// </summary>
+SymmetricGravityKernel select_symmetric_gravity_kernel(const SimdLevel level);
+/// <summary>
+/// Same as select_gravity_kernel, for the massless tracer kernels
+/// </summary>
+TracerKernel select_tracer_kernel(const SimdLevel level);
+/// <summary>
+/// Same as select_gravity_kernel, for the polyhedron field kernels
+/// </summary>
+PolyhedronKernel select_polyhedron_kernel(const SimdLevel level);
+
+/// <summary>
+/// Owns the padded structure-of-arrays copy of the sources consumed by the batched kernels
+/// </summary>
+class GravitySources {
+public:
+	std::vector<float> x, y, z, mu;
+	unsigned int count = 0;
+
+	void assign(const std::vector<glm::vec3>& positions, const std::vector<float>& masses, const float G);
+	GravitySourceArrays arrays() const;
+};
+
+/// <summary>
+/// Owns the padded structure-of-arrays copy of the bodies and the accumulators used by the symmetric kernels
+/// </summary>
+class SymmetricBodies {
+public:
+	unsigned int count = 0;
+	unsigned int padded_count = 0;
+
+	/// <summary>
+	/// Copies the bodies and clears the accumulators
+	/// </summary>
+	void assign(const std::vector<glm::vec3>& positions, const std::vector<float>& masses);
+	SymmetricBodyArrays arrays() const;
+	SymmetricAccumulators accumulators();
+	glm::vec3 force(const unsigned int index) const;
+	/// <summary>
+	/// Accumulated tidal term of a body as a symmetric matrix, for tidal_torque
+	/// </summary>
+	glm::mat3 tidal_tensor(const unsigned int index) const;
+private:
+	// x, y, z, mass, the force and the tidal term back to back, each array starting on a cache line so that the
+	// widest kernels never split a load or a store across two lines
+	std::vector<float> storage;
+	unsigned int offset = 0;
+
+	const float* array(const unsigned int index) const;
+	float* array(const unsigned int index);
+};
+
+GravityTarget make_gravity_target(const glm::vec3& position, const float mass, const glm::mat3& world_inertia, const unsigned int skip_index);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+// Deepest block level. Steps go from delta_time down to delta_time / 2^hermite_max_level
+constexpr unsigned int hermite_max_level = 20;
+// Aarseth's accuracy parameter eta of the step criterion, and the smaller one used for the first step
+constexpr float hermite_accuracy = 0.02f;
+constexpr float hermite_initial_accuracy = 0.01f;
+
+/// <summary>
+/// Fourth order Hermite predictor-corrector with individual block time steps. Every body has its own step, a power of
+/// two fraction of delta_time chosen with Aarseth's criterion from the acceleration, jerk and their interpolated
+/// higher derivatives. Each substep predicts every body to the next block time and only evaluates the bodies whose
+/// step ends there (the active block), by direct summation of acceleration and jerk over the predicted sources.
+/// Rotation follows a kick-rotate-kick of the body's own step, using the torques of its evaluations and rotate_free_body.
+/// </summary>
+class HermiteIntegrator {
+public:
+	/// <summary>
+	/// Advances every body by delta_time, the largest block step. All bodies are synchronized again when it returns,
+	/// with forces and torques holding their last evaluation and auxiliary variables up to date
+	/// </summary>
+	void step(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Forgets the accelerations, jerks and steps. The next step starts again from a full evaluation
+	/// </summary>
+	void reset();
+	/// <summary>
+	/// Amount of single body evaluations (one body against every source) since construction
+	/// </summary>
+	unsigned long long evaluations() const;
+private:
+	// Per-body state at the body's own time, which is counted in ticks of delta_time / 2^hermite_max_level
+	std::vector<glm::vec3> accelerations, jerks, torques;
+	std::vector<unsigned int> times, levels;
+	// Every body predicted to the current block time
+	std::vector<glm::vec3> predicted_positions, predicted_velocities;
+	std::vector<unsigned int> active;
+	float step_delta_time = 0.0f;
+	bool initialized = false;
+	unsigned long long evaluation_count = 0;
+
+	void initialize(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool);
+	void predict(const BodyStore& bodies, const unsigned int time, const float delta_time);
+	/// <summary>
+	/// Acceleration, jerk and torque of body i from the predicted state of every other body
+	/// </summary>
+	void evaluate(const BodyStore& bodies, const unsigned int i, const float G, const glm::mat3& world_inertia,
+		glm::vec3& acceleration, glm::vec3& jerk, glm::vec3& torque) const;
+	/// <summary>
+	/// Block level of a step of at most step_size, aligned to time
+	/// </summary>
+	unsigned int level_for(const float step_size, const unsigned int current_level, const unsigned int time) const;
+};
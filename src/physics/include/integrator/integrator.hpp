@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <body_store/body_store.hpp>
+#include <gravity/gravity.hpp>
+#include <hermite/hermite.hpp>
+#include <kepler/kepler.hpp>
+#include <regularization/regularization.hpp>
+#include <wisdom_holman/wisdom_holman.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+enum class IntegratorKind {
+	// First order update of RigidBody::update_state. One force evaluation per step
+	euler,
+	// Kick-drift-kick leapfrog, second order. One force evaluation per step
+	leapfrog,
+	// Yoshida's triple jump of kick-drift-kick leapfrogs, fourth order. Three force evaluations per step
+	yoshida4,
+	// Yoshida's seven stage composition (solution A), sixth order. Seven force evaluations per step
+	yoshida6,
+	// Forest and Ruth's fourth order method: the triple jump built on drift-kick-drift leapfrog. Three force evaluations per step
+	forest_ruth,
+	// Fourth order Hermite predictor-corrector with individual block steps of at most delta_time (HermiteIntegrator).
+	// Only the bodies whose step ends are evaluated, always by direct summation
+	hermite,
+	// Wisdom-Holman mapping around the most massive body (WisdomHolmanIntegrator), second order. Keplerian motion is
+	// solved exactly, so steps can be a sizeable fraction of an orbit. One direct evaluation per step
+	wisdom_holman
+};
+
+/// <summary>
+/// One operation of a splitting method: a kick (momenta += force * weight * dt) or a drift (positions and
+/// orientations advance by weight * dt)
+/// </summary>
+struct SplittingStep {
+	bool kick;
+	double weight;
+};
+
+// Stage weights of the compositions, each stage being a leapfrog step of weight * dt
+constexpr double yoshida4_weights[3] = { 1.3512071919596576, -1.7024143839193153, 1.3512071919596576 };
+constexpr double yoshida6_weights[7] = {
+	0.78451361047755726, 0.23557321335935813, -1.17767998417887100, 1.31518632068391121,
+	-1.17767998417887100, 0.23557321335935813, 0.78451361047755726
+};
+
+/// <summary>
+/// Operations of a composition of kick-drift-kick leapfrogs, with the kicks between consecutive stages merged
+/// </summary>
+std::vector<SplittingStep> kick_drift_kick(const double* weights, const unsigned int stage_count);
+/// <summary>
+/// Operations of a composition of drift-kick-drift leapfrogs, with the drifts between consecutive stages merged
+/// </summary>
+std::vector<SplittingStep> drift_kick_drift(const double* weights, const unsigned int stage_count);
+/// <summary>
+/// Operations of one step of a symplectic integrator. Empty for euler, hermite and wisdom_holman, which do not use them
+/// </summary>
+std::vector<SplittingStep> splitting_steps(const IntegratorKind kind);
+
+/// <summary>
+/// Advances a BodyStore in time with one of the integrators above. Both translation and rotation follow the same
+/// kicks and drifts; the orientation drift is the free rigid body rotation of rotate_free_body, so compositions keep their
+/// order for the rotation too.
+/// Forces are evaluated right before a kick when a drift has moved the bodies since the last evaluation, so the forces
+/// that end a kick-drift-kick step are reused by the first kick of the next one.
+/// With a positive kepler_threshold, isolated bound pairs (KeplerPairs) are found before every step and put back on
+/// their exact orbits after it. An isolated two-body system skips the numerical step altogether, so any delta_time works.
+/// With a positive regularization_radius, bodies about to come within it of each other are grouped before every step
+/// (RegularizedGroups) and their internal motion is integrated unsoftened, in regularized coordinates. They take precedence
+/// over the Kepler pairs. A system made of a single pair or group skips the numerical step as well.
+/// Steps that moved a pair or a group do not keep their forces for the next one.
+/// </summary>
+class Integrator {
+public:
+	/// <param name="kepler_threshold">Largest tidal perturbation, relative to their own attraction, of the pairs advanced
+	/// analytically. 0 integrates every body numerically</param>
+	/// <param name="regularization_radius">Distance below which close encounters are regularized, 0 to never regularize them</param>
+	explicit Integrator(const IntegratorKind kind = IntegratorKind::leapfrog, const float kepler_threshold = 0.0f,
+		const float regularization_radius = 0.0f);
+	IntegratorKind kind() const;
+	/// <summary>
+	/// Advances every body by delta_time. With the splitting methods, forces and torques hold the last evaluation afterwards
+	/// </summary>
+	void step(BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Forgets the forces kept from the last step. Call it when the bodies or the gravity settings change between steps
+	/// </summary>
+	void reset();
+	/// <summary>
+	/// Makes forces and torques hold the gravity of the current state, evaluating it only if the last evaluation is
+	/// stale. The next step reuses it. Hermite and Wisdom-Holman keep their own evaluations and are left untouched, and
+	/// so is a system the last step advanced as a single pair or group, which needs no forces at all
+	/// </summary>
+	void ensure_forces(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool);
+	/// <summary>
+	/// Amount of single body force evaluations since construction. A full evaluation of n bodies counts n
+	/// </summary>
+	unsigned long long evaluations() const;
+	/// <summary>
+	/// Whether the body was advanced by a Kepler pair or a regularized group during the last step. Its acceleration from
+	/// the solver does not describe its motion: pair orbits are exact and group members are softened by the solver
+	/// </summary>
+	bool analytic(const unsigned int index) const;
+private:
+	IntegratorKind integrator_kind;
+	std::vector<SplittingStep> steps;
+	HermiteIntegrator hermite;
+	WisdomHolmanIntegrator wisdom_holman;
+	float kepler_threshold;
+	KeplerPairs kepler_pairs;
+	float regularization_radius;
+	RegularizedGroups regularized_groups;
+	// Members of the pairs and groups of the last step
+	std::vector<bool> analytic_bodies;
+	// The last step advanced the whole system as one pair or group
+	bool analytic_system = false;
+	bool forces_current = false;
+	unsigned long long evaluation_count = 0;
+
+	void evaluate_forces(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool);
+	/// <summary>
+	/// One step of the integrator itself, without the Kepler pairs and regularized groups
+	/// </summary>
+	void integrate(BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool);
+};
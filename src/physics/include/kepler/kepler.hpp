@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+// Iterations of the universal Kepler equation solver before it settles for its current estimate
+constexpr unsigned int kepler_max_iterations = 32;
+// Amount of orbits handled by a single task of the batched drift, and of bodies of the pair search
+constexpr unsigned int kepler_block_size = 256;
+// A pair is only isolated when every other body is at least this many apocenter distances away from its center of mass
+constexpr float kepler_isolation_ratio = 2.0f;
+
+/// <summary>
+/// Stumpff functions C(z) = (1 - cos sqrt(z)) / z and S(z) = (sqrt(z) - sin sqrt(z)) / z^(3/2), continued to z <= 0
+/// </summary>
+void stumpff(const double z, double& c, double& s);
+
+/// <summary>
+/// Advances a body on the Keplerian orbit of gravitational parameter mu by delta_time, exactly up to rounding, with the
+/// universal variable formulation (Lagrange f and g functions). Works for elliptic, parabolic and hyperbolic orbits and
+/// any delta_time: whole periods of elliptic orbits are removed before solving. Computed in double precision.
+/// </summary>
+/// <param name="position">Position relative to the attracting center</param>
+/// <param name="velocity">Velocity relative to the attracting center</param>
+void kepler_drift(glm::vec3& position, glm::vec3& velocity, const float mu, const float delta_time);
+
+/// <summary>
+/// kepler_drift of positions[i] and velocities[i] with mus[i], for every i, spread over the thread pool
+/// </summary>
+void kepler_drift(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& velocities, const std::vector<float>& mus,
+	const float delta_time, ThreadPool& thread_pool);
+
+struct KeplerPair {
+	unsigned int first, second;
+};
+
+/// <summary>
+/// Bound pairs of bodies that move as an unperturbed two-body problem, advanced analytically instead of numerically.
+/// A pair is two mutual nearest neighbours with negative orbital energy, whose relative orbit feels a tidal acceleration
+/// from the other bodies smaller than threshold times their own attraction, both taken at apocenter.
+/// Around a numerical step, save records the pairs' relative orbits and apply replaces the relative motion the
+/// integrator produced with the exact orbit, keeping the center of mass it computed, which carries the external field.
+/// Pair members rotate freely (rotate_free_body): the tidal torques within the pair are left out.
+/// </summary>
+class KeplerPairs {
+public:
+	std::vector<KeplerPair> pairs;
+
+	/// <summary>
+	/// Finds the pairs of the current state. The nearest neighbour search is a direct O(n^2) pass over the thread pool
+	/// </summary>
+	void detect(const BodyStore& bodies, const float G, const float threshold, ThreadPool& thread_pool);
+	/// <summary>
+	/// Records the relative orbit, orientations and angular momenta of every pair. Velocities must be up to date
+	/// </summary>
+	void save(const BodyStore& bodies);
+	/// <summary>
+	/// Puts every pair member back on the exact orbit delta_time after save, around the current center of mass of the pair
+	/// </summary>
+	void apply(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool);
+private:
+	std::vector<unsigned int> nearest;
+	std::vector<glm::vec3> relative_positions, relative_velocities, saved_angular_momenta;
+	std::vector<glm::quat> saved_orientations;
+	std::vector<float> mus;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/// <summary>
+/// Mass properties of a closed triangle mesh for a density of 1
+/// </summary>
+struct MeshProperties {
+	float volume;
+	// Center of mass in the coordinates the vertices were given in
+	glm::vec3 center_of_mass;
+	// Inertia tensor around the center of mass and its inverse
+	glm::mat3 unit_inertia_tensor, unit_inverse_inertia_tensor;
+	// Eigenvalues of the inertia tensor, and the rotation taking the principal axes to the vertex coordinates
+	glm::vec3 unit_principal_moments;
+	glm::quat principal_frame;
+};
+
+/// <summary>
+/// Mass properties of a body made of a mesh with a given density
+/// </summary>
+struct MassProperties {
+	float mass, volume;
+	glm::vec3 center_of_mass;
+	glm::mat3 inertia_tensor, inverse_inertia_tensor;
+	glm::vec3 principal_moments;
+	glm::quat principal_frame;
+};
+
+/// <summary>
+/// Computes the volume, center of mass and inertia tensor of a closed triangle list.
+/// This is the expensive path, every other function here goes through the cache.
+/// </summary>
+MeshProperties compute_mesh_properties(const std::vector<glm::vec3>& vertices);
+/// <summary>
+/// Diagonalizes a symmetric tensor with Jacobi rotations: tensor = R * diag(moments) * transpose(R), with R the
+/// proper rotation of frame
+/// </summary>
+void principal_axes(const glm::mat3& tensor, glm::vec3& moments, glm::quat& frame);
+/// <summary>
+/// Scales unit density properties to a body of the given density
+/// </summary>
+MassProperties scale_mass_properties(const MeshProperties& properties, const float density);
+
+/// <summary>
+/// Content-hashed cache of mesh mass properties. Identical vertex lists are only integrated once, whatever their
+/// density. Entries keep their vertices, which a hit is compared against, so meshes whose hashes collide get their
+/// own properties. The cache can be saved to and loaded from disk so repeated runs skip the computation entirely.
+/// Every method is thread safe.
+/// </summary>
+class MassPropertyCache {
+public:
+	/// <summary>
+	/// Returns the unit density properties of the mesh, computing them on a miss
+	/// </summary>
+	MeshProperties get(const std::vector<glm::vec3>& vertices);
+	MassProperties get(const std::vector<glm::vec3>& vertices, const float density);
+	unsigned int size() const;
+	unsigned int hits() const;
+	unsigned int misses() const;
+	void clear();
+	/// <summary>
+	/// Merges the entries of a file written by save into the cache
+	/// </summary>
+	/// <returns>false if the file can't be read or is not a cache file. The error is printed to cerr</returns>
+	bool load(const std::string& path);
+	/// <returns>false if the file can't be written. The error is printed to cerr</returns>
+	bool save(const std::string& path) const;
+private:
+	struct Key {
+		std::uint64_t hash;
+		std::uint32_t vertex_count;
+		bool operator==(const Key& other) const;
+	};
+	struct KeyHash {
+		std::size_t operator()(const Key& key) const;
+	};
+	struct Entry {
+		std::vector<glm::vec3> vertices;
+		MeshProperties properties;
+	};
+	static Key make_key(const std::vector<glm::vec3>& vertices);
+	/// <summary>
+	/// The entry of these exact vertices among those sharing their key, or nullptr. Called with the mutex held
+	/// </summary>
+	const Entry* find(const Key& key, const std::vector<glm::vec3>& vertices) const;
+
+	mutable std::mutex mutex;
+	// Every mesh seen with a key, almost always a single one
+	std::unordered_map<Key, std::vector<Entry>, KeyHash> entries;
+	unsigned int entry_count = 0;
+	unsigned int hit_count = 0, miss_count = 0;
+};
+
+/// <summary>
+/// The cache shared by RigidBody and MeshRegistry
+/// </summary>
+MassPropertyCache& mass_property_cache();
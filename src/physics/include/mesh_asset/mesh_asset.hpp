@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <mass_properties/mass_properties.hpp>
+#include <polyhedron_gravity/polyhedron_gravity.hpp>
+
+typedef unsigned int MeshHandle;
+
+/// <summary>
+/// Immutable triangle mesh shared by every body built from it. The mass properties are stored for a
+/// density of 1; a body only scales them by its own density.
+/// </summary>
+struct MeshAsset {
+	// Triangle list shifted so the center of mass sits at the origin
+	std::vector<glm::vec3> vertices;
+	// properties.center_of_mass is where the center of mass was in the coordinates the mesh was registered with
+	MeshProperties properties;
+	// Distance from the center of mass to the furthest vertex
+	float bounding_radius = 0.0f;
+	// Mass moments for a density of 1 around the center of mass (compute_mesh_multipoles), up to multipole_order.
+	// Empty until MeshRegistry::set_multipole_order asks for them
+	std::vector<double> multipoles;
+	unsigned int multipole_order = 0;
+	// Exact constant density gravity of the mesh for a density of 1. Empty until MeshRegistry::set_polyhedron_models
+	// asks for it, and for meshes that are not closed
+	PolyhedronModel polyhedron;
+};
+
+/// <summary>
+/// Distance from the origin to the furthest vertex
+/// </summary>
+float mesh_bounding_radius(const std::vector<glm::vec3>& vertices);
+
+/// <summary>
+/// Builds a mesh asset, taking its mass properties from mass_property_cache()
+/// </summary>
+MeshAsset make_mesh_asset(const std::vector<glm::vec3>& vertices);
+
+/// <summary>
+/// Owns the mesh assets of a simulation. Handles are indices and stay valid for the lifetime of the registry.
+/// </summary>
+class MeshRegistry {
+public:
+	unsigned int size() const;
+	/// <summary>
+	/// Looks up the mass properties of the triangle list and stores it
+	/// </summary>
+	/// <returns>The handle used by bodies to reference the mesh</returns>
+	MeshHandle add(const std::vector<glm::vec3>& vertices);
+	/// <summary>
+	/// Stores a mesh whose mass properties are already known
+	/// </summary>
+	MeshHandle add(MeshAsset asset);
+	const MeshAsset& get(const MeshHandle handle) const;
+	/// <summary>
+	/// Computes the mass moments of every mesh up to order, and of every mesh added afterwards. Meshes that already
+	/// have them are left alone
+	/// </summary>
+	void set_multipole_order(const unsigned int order);
+	/// <summary>
+	/// Builds the polyhedron model of every mesh, and of every mesh added afterwards
+	/// </summary>
+	void set_polyhedron_models(const bool enabled);
+private:
+	std::vector<MeshAsset> assets;
+	unsigned int multipole_order = 0;
+	bool polyhedron_models = false;
+
+	void compute_multipoles(MeshAsset& asset) const;
+	void compute_polyhedron(MeshAsset& asset) const;
+};
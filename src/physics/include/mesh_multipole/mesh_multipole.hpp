@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <fmm/fmm.hpp>
+#include <gravity/gravity.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+/// <summary>
+/// Mass moments of a closed triangle list for a density of 1, the integral of x^n over its volume for every multi-index
+/// n of MultiIndexTable(order), in the same order. Exact: every triangle spans a tetrahedron with the origin, whose
+/// monomials are integrated in barycentric coordinates. Moments are taken around the origin of the vertices, which
+/// should be the center of mass.
+/// </summary>
+std::vector<double> compute_mesh_multipoles(const std::vector<glm::vec3>& vertices, const unsigned int order);
+
+/// <summary>
+/// Moments of the same mass distribution after a rotation: the moments of rotation * x, for every order of the table
+/// </summary>
+/// <param name="scratch">Reused buffer of table.size^2 values</param>
+void rotate_multipoles(const MultiIndexTable& table, const glm::mat3& rotation, const double* moments, double* rotated,
+	std::vector<double>& scratch);
+
+/// <summary>
+/// Replaces the point mass interaction of every pair of nearby bodies by the mutual expansion of their mesh multipoles
+/// up to settings.mesh_multipole_order, for both force and torque. A pair is nearby when its distance lies between the
+/// sum of the bounding radii, where the expansion stops converging, and settings.mesh_multipole_range times that sum.
+/// The point mass force and gravity_torque each solver gives to such pairs are subtracted, so this runs after the solver.
+/// Bodies whose mesh has no moments of that order (MeshRegistry::set_multipole_order) stay point masses, and
+/// polyhedron_pair pairs are left to accumulate_polyhedron_gravity.
+/// Pairs are searched directly in O(n^2) over the thread pool. Auxiliary variables must be up to date.
+/// </summary>
+void accumulate_mesh_multipole_gravity(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool);
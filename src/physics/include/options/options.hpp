@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <gravity/gravity.hpp>
+#include <integrator/integrator.hpp>
+#include <parareal/parareal.hpp>
+#include <step_control/step_control.hpp>
+
+enum class ScenarioKind {
+	two_body,
+	cloud,
+	// A heavy central body and body_count light satellites on near circular orbits
+	planetary
+};
+
+struct SimulationOptions {
+	GravitySettings gravity;
+	IntegratorKind integrator = IntegratorKind::leapfrog;
+	// Amount of threads used by the force phase, 0 for the hardware concurrency
+	unsigned int thread_count = 0;
+	ScenarioKind scenario = ScenarioKind::two_body;
+	unsigned int body_count = 1000;
+	unsigned int seed = 1;
+	// Massless particles added around the bodies of the scenario
+	unsigned int tracer_count = 0;
+	float delta_time = 0.005f;
+	// Largest tidal perturbation of the isolated bound pairs advanced on exact Kepler orbits, 0 to disable them
+	float kepler_threshold = 0.0f;
+	// Distance below which close encounters are integrated in regularized coordinates, 0 to disable it
+	float regularization_radius = 0.0f;
+	// Adaptive step control. delta_time is then the first step tried
+	StepControlSettings step_control;
+	// Parallel-in-time integration of batch runs, off while its slice_count is 0
+	PararealSettings parareal;
+	unsigned int step_count = 1000;
+	// Simulated seconds per wall-clock second when physics runs on its own thread
+	float time_scale = 1.0f;
+	std::string output_path = "simulation_output.csv";
+	// File the mass property cache is loaded from and saved to when building a scenario, empty to keep it in memory
+	std::string mass_cache_path;
+};
+
+const char* solver_name(const GravitySolver solver);
+const char* integrator_name(const IntegratorKind integrator);
+const char* scenario_name(const ScenarioKind scenario);
+
+/// <summary>
+/// Reads "--key value" pairs from the command line into options. Accepted arguments are
+/// - --solver direct|symmetric|barnes-hut|fmm|pm|p3m
+/// - --theta (opening angle of the Barnes-Hut and fast multipole solvers)
+/// - --order (expansion order of the fast multipole solver)
+/// - --mesh-order (order of the mesh multipoles nearby bodies interact through, 0 for point masses)
+/// - --mesh-range (distance, in sums of bounding radii, below which bodies interact through their mesh multipoles)
+/// - --polyhedron (distance, in bounding radii, below which tracers and small bodies feel the exact polyhedron field
+///   of a body, 0 to disable)
+/// - --mesh (cells per side of the particle-mesh and P3M grid, a power of two of at least 16)
+/// - --boundary periodic|isolated (boundary conditions of the particle-mesh and P3M solvers)
+/// - --assignment cic|tsc (mass assignment window of the particle-mesh and P3M solvers)
+/// - --box (side of the periodic particle-mesh box, 0 to fit it to the bodies)
+/// - --split (split radius of the P3M solver, in mesh cells)
+/// - --threads (amount of threads used by the force phase, 0 for the hardware concurrency, at most max_thread_count)
+/// - --simd scalar|sse4.2|avx2|avx512 (widest instruction set used by the direct solver)
+/// - --scenario two-body|cloud|planetary
+/// - --bodies (amount of bodies of the cloud scenario, or of satellites of the planetary one)
+/// - --seed (random seed of the cloud and planetary scenarios)
+/// - --tracers (amount of massless tracer particles moving in the field of the bodies)
+/// - --integrator euler|leapfrog|yoshida4|yoshida6|forest-ruth|hermite|wisdom-holman
+/// - --kepler (perturbation threshold below which isolated bound pairs follow exact Kepler orbits, 0 to disable)
+/// - --regularize (distance below which close encounters are integrated in regularized coordinates, 0 to disable)
+/// - --dt (time step, or first step of the adaptive control)
+/// - --adaptive (tolerance of the adaptive step control, the largest relative change of an acceleration over a step)
+/// - --min-dt, --max-dt (bounds of the adaptive step, a max-dt of 0 for none)
+/// - --steps (amount of steps of a batch run)
+/// - --parareal (amount of time slices a batch run is integrated over in parallel, 0 to integrate serially)
+/// - --parareal-tolerance (relative change of the slice boundaries at which parareal stops iterating)
+/// - --coarse-ratio (length of the coarse parareal steps, in steps)
+/// - --coarse-integrator (integrator of the coarse parareal propagator, same names as --integrator)
+/// - --time-scale (simulated seconds per wall-clock second of the real-time viewer, positive)
+/// - --output (path of the file the final state is written to)
+/// - --mass-cache (path of the file mesh mass properties are cached in between runs)
+/// </summary>
+/// <returns>false if an argument is unknown or malformed. The error is printed to cerr</returns>
+bool parse_simulation_options(const int argc, char* argv[], SimulationOptions& options);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <gravity/gravity.hpp>
+#include <particle_mesh/particle_mesh.hpp>
+
+// Pairs further apart than this many split radii are left to the mesh. The short-range force factor is below 0.6% there
+constexpr float p3m_cutoff_ratio = 5.0f;
+// Cells of the cell-linked list are at least cutoff / p3m_cell_reach wide, so the short-range sum visits the cells up
+// to p3m_cell_reach away. Smaller cells fit the cutoff sphere more tightly
+constexpr unsigned int p3m_cell_reach = 2;
+// Amount of cells of the cell-linked list handled by a single task of the short-range sum
+constexpr unsigned int p3m_cell_block_size = 4;
+
+/// <summary>
+/// Particle-particle particle-mesh gravity solver. The potential of every body is split as
+/// -G m / r = -G m erf(r / 2 r_s) / r - G m erfc(r / 2 r_s) / r. The smooth long-range part comes from a particle-mesh
+/// solve; the short-range part is summed directly over the pairs within p3m_cutoff_ratio r_s, found with a cell-linked
+/// list. The short-range sum scales gravity_force and gravity_torque by the share of the force and of the tidal
+/// tensor that the erfc term carries, so close pairs get the exact point mass interaction.
+/// </summary>
+class ParticleParticleMesh {
+public:
+	ParticleMesh mesh;
+	// Split radius and cutoff of the short-range sum, in world units. Set by accumulate_gravity
+	float split_radius, cutoff;
+	// Cell-linked list. Bodies of cell c are cell_bodies[cell_begin[c]] to cell_bodies[cell_begin[c + 1] - 1], in index order.
+	// Their positions and masses are copied in the same order
+	glm::vec3 cell_origin;
+	float cell_side;
+	unsigned int cell_counts[3];
+	std::vector<unsigned int> cell_begin, cell_bodies;
+	std::vector<glm::vec3> cell_positions;
+	std::vector<float> cell_masses;
+
+	/// <param name="split_radius">Split radius r_s in mesh cells. Larger values move work from the mesh to the
+	/// short-range sum, and reduce the error of the mesh part</param>
+	ParticleParticleMesh(const unsigned int mesh_size, const MeshBoundary boundary, const MassAssignment assignment,
+		const float box_size = 0.0f, const float split_radius = 1.25f);
+	/// <summary>
+	/// Adds the gravitational force and torque acting on every body to forces and torques.
+	/// Auxiliary variables must be up to date.
+	/// </summary>
+	void accumulate_gravity(BodyStore& bodies, const float G, ThreadPool& thread_pool);
+private:
+	void build_cells(const BodyStore& bodies);
+	void cell_coordinates(const glm::vec3& position, int coordinates[3]) const;
+	void accumulate_short_range(BodyStore& bodies, const float G, ThreadPool& thread_pool) const;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <body_store/body_store.hpp>
+#include <gravity/gravity.hpp>
+#include <integrator/integrator.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+struct PararealSettings {
+	// Amount of time slices integrated concurrently, 0 to integrate serially
+	unsigned int slice_count = 0;
+	// Parareal is exact after slice_count iterations, 0 allows all of them
+	unsigned int max_iterations = 0;
+	// Largest change of a slice boundary between two iterations, relative to the size and velocity dispersion of the
+	// system, below which the iteration stops. Single precision states drift apart by around 1e-5 over a few hundred
+	// orbits whatever the integrator, so much smaller tolerances only converge on the last iteration
+	float tolerance = 1e-4f;
+	IntegratorKind coarse_integrator = IntegratorKind::leapfrog;
+	// Coarse steps are this many fine steps long
+	unsigned int coarse_ratio = 10;
+};
+
+struct PararealIteration {
+	// Largest relative change of a slice boundary during the iteration
+	double change;
+	// Wall-clock time of the iteration, in seconds
+	double seconds;
+};
+
+struct PararealStatistics {
+	std::vector<PararealIteration> iterations;
+	bool converged = false;
+	// Wall-clock time of the initial coarse pass, in seconds
+	double initial_seconds = 0.0;
+	unsigned long long fine_evaluations = 0, coarse_evaluations = 0;
+};
+
+/// <summary>
+/// Positions, momenta and orientations of every body, the part of a BodyStore that parareal corrects
+/// </summary>
+struct PararealState {
+	std::vector<glm::vec3> positions, linear_momenta, angular_momenta;
+	std::vector<glm::quat> orientations;
+
+	void capture(const BodyStore& bodies);
+	/// <summary>
+	/// Writes the state into bodies and updates their auxiliary variables
+	/// </summary>
+	void restore(BodyStore& bodies) const;
+};
+
+/// <summary>
+/// Parallel-in-time integration (Lions, Maday and Turinici 2001) for systems too small to spread over threads in space.
+/// The interval is cut into slices. A cheap coarse propagator G runs over them in sequence, then the fine integrator F
+/// runs over every slice concurrently from the current boundaries, each on one thread, and the boundaries are corrected
+/// U(n+1) = G(U'(n)) + F(U(n)) - G(U(n)) until they stop changing. Iteration k makes the first k slices exact, so the
+/// result matches the serial fine integration once converged; the speedup is at most slice_count / iterations.
+/// Orientations are corrected component-wise and renormalized.
+/// </summary>
+class PararealDriver {
+public:
+	explicit PararealDriver(const PararealSettings& settings);
+	/// <summary>
+	/// Advances bodies by step_count fine steps of delta_time, split evenly between the slices
+	/// </summary>
+	/// <param name="make_fine">Builds the fine integrator of a slice</param>
+	void run(BodyStore& bodies, const GravitySettings& gravity, const std::function<Integrator()>& make_fine,
+		const float delta_time, const unsigned int step_count, ThreadPool& thread_pool);
+	const PararealStatistics& statistics() const;
+private:
+	PararealSettings settings;
+	PararealStatistics stats;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <gravity/gravity.hpp>
+
+// Smallest grid accepted by the particle-mesh solver. Isolated grids keep mesh_margin empty cells on every side
+constexpr unsigned int min_mesh_size = 16;
+constexpr unsigned int mesh_margin = 4;
+
+struct MeshGreenFunction;
+
+/// <summary>
+/// Particle-mesh gravity solver. Masses are deposited on a regular grid with the CIC or TSC window, the Poisson
+/// equation is solved with FFTs and the field, obtained from the potential with a 4-point difference, is interpolated
+/// back to every body with the same window. The gradient of the interpolated field is the tidal tensor used for the
+/// torque, once the body's own contribution is removed. Forces are softened at the scale of a cell, so this solver suits dense, roughly uniform distributions.
+/// </summary>
+class ParticleMesh {
+public:
+	// Nodes per side of the physical grid and of the grid the FFT runs on (twice as large with isolated boundaries)
+	unsigned int size, fft_size;
+	MeshBoundary boundary;
+	MassAssignment assignment;
+	float split_radius;
+	// Position of node (0, 0, 0) and side of a cell
+	glm::vec3 origin;
+	float cell_size;
+	// Mass per node of the FFT grid, turned in place into its spectrum and then into the potential
+	std::vector<std::complex<float>> grid;
+	// Gravitational field at the nodes of the physical grid
+	std::vector<float> field_x, field_y, field_z;
+
+	/// <param name="size">Nodes per side, rounded up to a power of two no smaller than min_mesh_size</param>
+	/// <param name="box_size">Side of the periodic box centered at the origin, 0 to fit it to the bodies</param>
+	/// <param name="split_radius">In cells. When positive only the long-range part of gravity, -G m erf(r / 2 split) / r,
+	/// is computed, for a short-range sum to complete it. 0 computes all of it</param>
+	ParticleMesh(const unsigned int size, const MeshBoundary boundary, const MassAssignment assignment, const float box_size = 0.0f,
+		const float split_radius = 0.0f);
+	/// <summary>
+	/// Adds the gravitational force and torque acting on every body to forces and torques.
+	/// Auxiliary variables must be up to date.
+	/// </summary>
+	void accumulate_gravity(BodyStore& bodies, const float G, ThreadPool& thread_pool);
+private:
+	float box_size;
+	// Cached response of the FFT grid to a unit mass, set by solve_potential
+	const MeshGreenFunction* green = nullptr;
+
+	unsigned int grid_index(const int x, const int y, const int z) const;
+	unsigned int field_index(const int x, const int y, const int z) const;
+	void fit_grid(const BodyStore& bodies);
+	void deposit(const BodyStore& bodies, ThreadPool& thread_pool);
+	void solve_potential(const float G, ThreadPool& thread_pool);
+	void compute_field(ThreadPool& thread_pool);
+	void interpolate(BodyStore& bodies, const float G, ThreadPool& thread_pool) const;
+};
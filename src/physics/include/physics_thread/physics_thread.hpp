@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <body_store/body_store.hpp>
+#include <options/options.hpp>
+#include <triple_buffer/triple_buffer.hpp>
+
+// Upper bound of steps taken to catch up after a stall. Time beyond it is dropped instead of spiralling
+constexpr unsigned int max_steps_per_update = 16;
+
+/// <summary>
+/// The last two states computed by the physics thread, which the renderer interpolates between
+/// </summary>
+struct SimulationFrame {
+	std::vector<glm::vec3> previous_positions, positions;
+	std::vector<glm::quat> previous_orientations, orientations;
+	double time = 0.0;
+	unsigned long long step = 0;
+	// Wall-clock time at which the frame was published
+	std::chrono::steady_clock::time_point published_at;
+
+	glm::vec3 interpolated_position(const unsigned int index, const float alpha) const;
+	glm::quat interpolated_orientation(const unsigned int index, const float alpha) const;
+};
+
+/// <summary>
+/// Advances a BodyStore on its own thread with a fixed time step, driven by an accumulator of elapsed wall time,
+/// and publishes every batch of steps through a triple buffer.
+/// </summary>
+class PhysicsThread {
+public:
+	/// <param name="bodies">The bodies to simulate. They are owned by the thread until it is destroyed</param>
+	/// <param name="options">Gravity settings, integrator, thread count, delta_time and time_scale</param>
+	PhysicsThread(BodyStore bodies, const SimulationOptions& options);
+	PhysicsThread(const PhysicsThread&) = delete;
+	PhysicsThread& operator=(const PhysicsThread&) = delete;
+	~PhysicsThread();
+
+	void start();
+	void stop();
+	/// <summary>
+	/// Changes the solver used from the next batch of steps on. Safe to call from any thread
+	/// </summary>
+	void set_solver(const GravitySolver solver);
+	/// <summary>
+	/// Returns the most recent frame. Must only be called from a single reader thread
+	/// </summary>
+	const SimulationFrame& latest_frame();
+	/// <summary>
+	/// How far the renderer should be between the frame's previous and current states right now, in [0, 1].
+	/// The renderer stays one step behind the physics so it always has two states to interpolate.
+	/// </summary>
+	float interpolation_factor(const SimulationFrame& frame) const;
+private:
+	BodyStore bodies;
+	SimulationOptions options;
+	TripleBuffer<SimulationFrame> frames;
+	std::atomic<GravitySolver> solver;
+	std::atomic<bool> running = false;
+	std::thread worker;
+
+	void run();
+	void publish(const double time, const unsigned long long step);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <gravity/gravity_kernels.hpp>
+#include <gravity_simd/gravity_simd.hpp>
+
+// A body only feels the polyhedron field of another one when its bounding radius is at most this fraction of the
+// other's: it is then small enough to be taken as a point
+constexpr float polyhedron_point_ratio = 0.25f;
+
+/// <summary>
+/// Exact gravity field of a closed triangle mesh of constant density (Werner and Scheeres 1997), for field points close
+/// to or inside the mesh where multipoles do not converge. The edge and face dyads are computed once by build and stored
+/// as fixed size records (PolyhedronEdge, PolyhedronFace) that the polyhedron kernels read in sequence, with the
+/// vertices they share kept apart so every vertex offset is computed once per field point.
+/// Evaluations cost one logarithm per edge and one arctangent per face, and are vectorized across field points.
+/// </summary>
+class PolyhedronModel {
+public:
+	std::vector<float> vertex_x, vertex_y, vertex_z;
+	std::vector<PolyhedronEdge> edges;
+	std::vector<PolyhedronFace> faces;
+
+	/// <summary>
+	/// Builds the model of a triangle list. Triangles share a vertex when their coordinates are exactly equal, and every
+	/// edge must be shared by exactly two triangles. Triangles wound clockwise seen from outside are turned around as a whole
+	/// </summary>
+	/// <returns>false, leaving the model empty, when the mesh is not closed</returns>
+	bool build(const std::vector<glm::vec3>& vertices);
+	bool empty() const;
+	/// <param name="mu_density">G times the density of the polyhedron</param>
+	PolyhedronArrays arrays(const float mu_density) const;
+	/// <summary>
+	/// Sets the acceleration at count field points given in the frame of the vertices, padded to a multiple of
+	/// gravity_source_padding, with the kernel of the requested SIMD level
+	/// </summary>
+	/// <param name="scratch">Reused buffer, resized as needed</param>
+	void field(const float mu_density, const float* x, const float* y, const float* z, const unsigned int count,
+		float* ax, float* ay, float* az, const SimdLevel simd_level, std::vector<float>& scratch) const;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <body_store/body_store.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+// Largest group integrated in regularized coordinates. Bigger clusters of close bodies are left to the integrator
+constexpr unsigned int regularization_max_group = 8;
+// Fictitious time steps per orbit of the tightest pair of a group
+constexpr unsigned int regularization_steps_per_orbit = 64;
+// Fictitious time steps a group may take in one step of the rest of the system. Longer steps are taken beyond it
+constexpr unsigned int regularization_max_substeps = 1 << 16;
+// Bodies whose tidal acceleration on a group is below this fraction of the group's own attraction do not perturb it
+constexpr float regularization_perturbation_floor = 1e-7f;
+// Amount of bodies handled by a single task of the close pair search
+constexpr unsigned int regularization_block_size = 256;
+
+struct RegularizedGroup {
+	// Indices of the bodies of the group, in increasing order
+	std::vector<unsigned int> members;
+	// Bodies outside the group whose tidal field is integrated along with it
+	std::vector<unsigned int> perturbers;
+};
+
+/// <summary>
+/// Close encounters of pairs and small groups, integrated with algorithmic regularization (Mikkola and Tanikawa 1999,
+/// Preto and Tremaine 1999) instead of the softened forces of the solvers. Their internal motion is a leapfrog in the
+/// fictitious time s of the logarithmic Hamiltonian, dt = ds / U with U the group's potential energy, composed into
+/// Yoshida's fourth order triple jump. Unperturbed two-body orbits come out exact up to a phase error, collisions
+/// included, and the steps shrink on their own near pericenter: the forces are never softened.
+/// Around a numerical step of the whole system, save records the groups and apply replaces the internal motion the
+/// integrator produced, keeping the center of mass it computed like KeplerPairs. The field of the perturbers moves
+/// linearly between their positions at both ends of the step. Members rotate freely (rotate_free_body).
+/// </summary>
+class RegularizedGroups {
+public:
+	std::vector<RegularizedGroup> groups;
+
+	/// <summary>
+	/// Groups the bodies that come within radius of each other during the next delta_time, extrapolating their current
+	/// relative motion in straight lines. The search is a direct O(n^2) pass over the thread pool
+	/// </summary>
+	void detect(const BodyStore& bodies, const float radius, const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Records the state of the members and perturbers of every group. Velocities must be up to date
+	/// </summary>
+	void save(const BodyStore& bodies);
+	/// <summary>
+	/// Integrates every group over delta_time from its saved state, then puts its members back around the current center
+	/// of mass of the group
+	/// </summary>
+	void apply(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Whether the body is a member of one of the groups of the last detect
+	/// </summary>
+	bool contains(const unsigned int index) const;
+private:
+	std::vector<std::vector<unsigned int>> close;
+	std::vector<unsigned int> parents;
+	std::vector<int> group_of;
+	std::vector<glm::vec3> saved_positions, saved_velocities, saved_angular_momenta, end_positions;
+	std::vector<glm::quat> saved_orientations;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <mass_properties/mass_properties.hpp>
+
+typedef struct Point {
+	float mass;
+	glm::vec3 position;
+	glm::vec3 linear_momentum;
+	glm::vec3 force;
+} Point;
+
+constexpr Point null_point{ 0.0f,glm::vec3(0.0f,0.0f,0.0f),glm::vec3(0.0f,0.0f,0.0f),glm::vec3(0.0f,0.0f,0.0f) };
+
+/// <summary>
+/// Rotates a torque free rigid body for delta_time. The rotational kinetic energy is split into the rotations about the
+/// three principal axes, each solved exactly, composed symmetrically as X(dt/2) Y(dt/2) Z(dt) Y(dt/2) X(dt/2).
+/// The angular momentum is conserved exactly and the energy to second order without drift, even at large dt.
+/// </summary>
+/// <param name="orientation">Rotation from body to world coordinates</param>
+/// <param name="angular_momentum">Angular momentum in world coordinates, unchanged by the rotation</param>
+/// <param name="principal_frame">Rotation from the principal axes to body coordinates</param>
+/// <returns>The normalized orientation after delta_time</returns>
+glm::quat rotate_free_body(const glm::quat& orientation, const glm::vec3& angular_momentum,
+	const glm::vec3& principal_moments, const glm::quat& principal_frame, const float delta_time);
+
+class RigidBody {
+public:
+	// State variables
+	Point center_of_mass;
+	glm::vec3 angular_momentum, torque;
+	glm::quat orientation_quat;
+
+	// Constants
+	float density, volume;
+	glm::mat3 inertia_tensor, inverse_inertia_tensor;
+	glm::vec3 principal_moments;
+	glm::quat principal_frame;
+
+	//Auxiliary variables
+	glm::vec3 velocity, angular_velocity;
+	glm::mat3 world_inertia, inverse_world_inertia, rotation_matrix;
+
+	std::vector<glm::vec3> vertices;
+	/// <summary>
+	/// Builds a body from a closed triangle list. The mass properties come from mass_property_cache(), so constructing
+	/// many bodies from the same vertices only integrates the mesh once. The vertices are shifted to the center of mass.
+	/// </summary>
+	RigidBody(const float density, const std::vector<glm::vec3>& vertices,
+		const glm::quat orientation_quat = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+		const glm::vec3 linear_momentum = glm::vec3(0.0f, 0.0f, 0.0f),
+		const glm::vec3 angular_momentum = glm::vec3(0.0f, 0.0f, 0.0f));
+	/// <summary>
+	/// Updates the state of the rigid body. Variables considered as "state" are
+	/// - center_of_mass.position (x)
+	/// - center_of_mass.linear_momentum (p)
+	/// - angular_momentum (P)
+	/// - orientation_quat (q)
+	/// The rotation is the free rigid body rotation of rotate_free_body with the angular momentum after the torque kick.
+	/// </summary>
+	/// <param name="delta_time">The time dt in which the simulation happens</param>
+	void update_state(const float delta_time);
+	/// <summary>
+	/// Updates auxiliary variables used for calculations. The auxiliary variables are:
+	/// - velocity (v)
+	/// - rotation_matrix (R)
+	/// - world_inertia (I)
+	/// - inverse world_inertia (I^-1)
+	/// - angular_velocity (omega)
+	/// </summary>
+	void update_auxiliary_variables();
+};
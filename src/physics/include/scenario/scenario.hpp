@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <options/options.hpp>
+#include <tracers/tracers.hpp>
+
+// Triangle list of the tetrahedron used by the demo scenarios
+extern const std::vector<glm::vec3> tetrahedron_verts;
+
+// Densities of the central body and of the satellites of the planetary scenario. The mass ratio keeps the satellites'
+// Hill spheres small, so they rarely scatter each other
+constexpr float planetary_central_density = 1000.0f;
+constexpr float planetary_satellite_density = 0.01f;
+// Orbital radii of the satellites of the planetary scenario
+constexpr float planetary_inner_radius = 10.0f;
+constexpr float planetary_outer_radius = 40.0f;
+
+/// <summary>
+/// The original demo: two tetrahedra orbiting each other
+/// </summary>
+BodyStore make_two_body_scenario();
+/// <summary>
+/// A roughly uniform sphere of tetrahedra with random orientations, slow random velocities and spins.
+/// Every body shares a single registered tetrahedron mesh.
+/// </summary>
+BodyStore make_cloud_scenario(const unsigned int body_count, const unsigned int seed);
+/// <summary>
+/// A dense central tetrahedron with satellite_count light ones on near circular (for G = 1), slightly inclined orbits between
+/// planetary_inner_radius and planetary_outer_radius. The total momentum is zero.
+/// </summary>
+BodyStore make_planetary_scenario(const unsigned int satellite_count, const unsigned int seed);
+/// <summary>
+/// options.tracer_count tracers for the bodies of the scenario selected in options. The planetary scenario gets a
+/// debris disk on circular orbits around its central body, between planetary_inner_radius and planetary_outer_radius;
+/// the others a uniform sphere around the center of mass of the bodies, as wide as they are, moving with it.
+/// </summary>
+TracerStore make_scenario_tracers(const SimulationOptions& options, const BodyStore& bodies);
+/// <summary>
+/// Builds the scenario selected in options. When options.mass_cache_path is set, the mass property cache is
+/// loaded from it beforehand and saved back afterwards.
+/// </summary>
+BodyStore make_scenario(const SimulationOptions& options);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <body_store/body_store.hpp>
+#include <gravity/gravity.hpp>
+#include <integrator/integrator.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <tracers/tracers.hpp>
+
+/// <summary>
+/// Advances every body by one time step of the given integrator, evaluating gravity as many times as it needs
+/// </summary>
+void step_simulation(BodyStore& bodies, const GravitySettings& settings, Integrator& integrator, const float delta_time, ThreadPool& thread_pool);
+/// <summary>
+/// Same as above, and advances the tracers by the same delta_time in the field of the moving bodies
+/// </summary>
+void step_simulation(BodyStore& bodies, TracerStore& tracers, const GravitySettings& settings, Integrator& integrator, const float delta_time, ThreadPool& thread_pool);
+
+/// <summary>
+/// Writes the state of every body as CSV: index, mass, position, velocity, orientation and angular momentum
+/// </summary>
+/// <returns>false if the file could not be written</returns>
+bool write_state_csv(const BodyStore& bodies, const std::string& path);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <body_store/body_store.hpp>
+#include <gravity/gravity.hpp>
+#include <integrator/integrator.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+// The next step aims at this fraction of the tolerance, so it is rarely rejected
+constexpr float step_safety = 0.9f;
+// Bounds of the factor a step can change by from one step to the next
+constexpr float step_max_growth = 2.0f;
+constexpr float step_max_shrink = 0.2f;
+// Accelerations smaller than this fraction of the mean acceleration are compared against it instead, so bodies
+// sitting where the field cancels do not drive the step
+constexpr float step_acceleration_floor = 0.01f;
+
+struct StepControlSettings {
+	// Steps of fixed delta_time when false
+	bool adaptive = false;
+	// Largest relative change of any body's acceleration over one accepted step
+	float tolerance = 0.02f;
+	// Bounds of the adaptive step. A max_step of 0 lets a step cover the whole interval being advanced
+	float min_step = 1e-6f;
+	float max_step = 0.0f;
+};
+
+struct StepStatistics {
+	unsigned long long accepted = 0, rejected = 0;
+	double simulated_time = 0.0;
+	float smallest_step = std::numeric_limits<float>::max(), largest_step = 0.0f;
+};
+
+/// <summary>
+/// Adaptive global time step. Every step is checked against the change of each body's acceleration between its start
+/// and its end, the first order Aarseth criterion dt = eta |a| / |da/dt|. Steps whose change exceeds the tolerance are
+/// rolled back and retried with a smaller step; accepted ones set the next step from the same estimate.
+/// The integrators that end their steps with a force evaluation (euler, leapfrog, yoshida4, yoshida6) get both
+/// accelerations for free, forest-ruth pays one extra evaluation per step. Hermite picks its own block steps and
+/// Wisdom-Holman needs a fixed step to stay symplectic, so both are only advanced in steps of the initial step.
+/// </summary>
+class StepController {
+public:
+	/// <param name="initial_step">First step tried, and the fixed step when the control is not adaptive</param>
+	StepController(const StepControlSettings& settings, const float initial_step);
+	/// <summary>
+	/// Advances every body by duration with as many steps as the tolerance needs. The last step is shortened to end
+	/// exactly at duration
+	/// </summary>
+	void advance(BodyStore& bodies, const GravitySettings& gravity, Integrator& integrator, const double duration, ThreadPool& thread_pool);
+	/// <summary>
+	/// The step the next advance starts with
+	/// </summary>
+	float current_step() const;
+	const StepStatistics& statistics() const;
+private:
+	StepControlSettings settings;
+	float step;
+	StepStatistics stats;
+	// State at the start of the step being tried, restored when it is rejected
+	std::vector<glm::vec3> saved_positions, saved_linear_momenta, saved_angular_momenta, start_accelerations;
+	std::vector<glm::quat> saved_orientations;
+
+	void save(const BodyStore& bodies);
+	void restore(BodyStore& bodies) const;
+	/// <summary>
+	/// Largest relative change of acceleration over the step, in units of the tolerance. Accepted when at most 1.
+	/// Bodies the integrator advanced in a Kepler pair or a regularized group are left out
+	/// </summary>
+	float step_error(const BodyStore& bodies, const Integrator& integrator) const;
+	void record(const float step_size);
+};
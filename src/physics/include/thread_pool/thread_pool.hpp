@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads a pool may run per hardware thread. Oversubscribing further only adds context switches
+constexpr unsigned int max_threads_per_core = 4;
+
+/// <summary>
+/// Largest thread count a ThreadPool accepts, max_threads_per_core times the hardware concurrency
+/// </summary>
+unsigned int max_thread_count();
+
+/// <summary>
+/// A fixed set of worker threads that execute indexed tasks. The calling thread takes part in the work,
+/// so a pool of size 1 runs everything inline.
+/// </summary>
+class ThreadPool {
+public:
+	/// <param name="thread_count">Total amount of threads, including the caller. 0 uses the hardware concurrency, and counts
+	/// above max_thread_count are capped to it</param>
+	explicit ThreadPool(const unsigned int thread_count = 0);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	unsigned int size() const;
+	/// <summary>
+	/// Runs task(index) for every index in [0, task_count) and blocks until all of them are done.
+	/// Tasks are handed out dynamically, so which thread runs a given index is not deterministic.
+	/// </summary>
+	void run(const unsigned int task_count, const std::function<void(unsigned int)>& task);
+	/// <summary>
+	/// Splits [0, n) into consecutive blocks of block_size elements and runs task(begin, end) for each one.
+	/// The blocks only depend on n and block_size, never on the amount of threads.
+	/// </summary>
+	void parallel_for(const unsigned int n, const unsigned int block_size, const std::function<void(unsigned int, unsigned int)>& task);
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start_condition, done_condition;
+	const std::function<void(unsigned int)>* current_task = nullptr;
+	unsigned int task_count = 0;
+	std::atomic<unsigned int> next_task = 0;
+	unsigned int active_workers = 0;
+	unsigned int generation = 0;
+	bool stopping = false;
+
+	void worker_loop();
+	void drain();
+};
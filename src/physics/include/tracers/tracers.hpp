@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <gravity/gravity.hpp>
+#include <gravity_simd/gravity_simd.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+// Tracer arrays are padded to a whole amount of the widest kernel's vectors
+constexpr unsigned int tracer_padding = gravity_source_padding;
+// Amount of tracers handled by a single task of the thread pool, a multiple of tracer_padding
+constexpr unsigned int tracer_block_size = 1024;
+
+/// <summary>
+/// Massless particles (debris, dust, flow markers) that feel the gravity of the bodies and exert none. They only carry a
+/// position and a velocity, stored as padded structure of arrays, so that the tracer kernels can stream over them
+/// with the bodies as broadcast sources. Tracers advance with their own kick-drift-kick leapfrog around each body step:
+/// begin_step kicks and drifts them in the field of the bodies at the start of the step, finish_step kicks them in the
+/// field at its end. Padding tracers sit at the origin and are never reported.
+/// </summary>
+class TracerStore {
+public:
+	std::vector<float> x, y, z, vx, vy, vz, ax, ay, az;
+
+	unsigned int size() const;
+	void reserve(const unsigned int count);
+	void add(const glm::vec3& position, const glm::vec3& velocity);
+	glm::vec3 position(const unsigned int index) const;
+	glm::vec3 velocity(const unsigned int index) const;
+
+	/// <summary>
+	/// Sets the accelerations to the gravity of the bodies at their current positions. Tracers closer than
+	/// settings.polyhedron_range bounding radii to a body with a polyhedron model feel its exact field instead of a point mass
+	/// </summary>
+	void evaluate(const BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool);
+	/// <summary>
+	/// First half of a step: half kick with the accelerations of the current body positions, evaluated first if the
+	/// last finish_step did not leave them, then a full drift
+	/// </summary>
+	void begin_step(const BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Second half of a step, once the bodies have been advanced by delta_time: half kick with their new field
+	/// </summary>
+	void finish_step(const BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Forgets the accelerations kept from the last step, for when the bodies were moved by something else
+	/// </summary>
+	void reset();
+	/// <summary>
+	/// Amount of single tracer accelerations computed so far, padding included
+	/// </summary>
+	unsigned long long evaluations() const;
+private:
+	unsigned int count = 0;
+	GravitySources sources;
+	// Tracers close to the polyhedron being evaluated, and their positions and accelerations in its frame
+	std::vector<unsigned int> near_indices;
+	std::vector<float> local_x, local_y, local_z, local_ax, local_ay, local_az;
+	bool accelerations_current = false;
+	unsigned long long evaluation_count = 0;
+
+	void kick(const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Swaps the point mass acceleration of every body with a polyhedron model for its exact field, on the tracers within range
+	/// </summary>
+	void add_polyhedron_gravity(const BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool);
+};
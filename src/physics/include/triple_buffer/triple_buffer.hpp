@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+/// <summary>
+/// Lock-free single producer, single consumer triple buffer. The writer fills write_buffer() and publishes it;
+/// the reader picks up the most recently published buffer with update(). Neither side ever blocks, and
+/// intermediate publications the reader did not see are dropped.
+/// </summary>
+template <typename T>
+class TripleBuffer {
+public:
+	T& write_buffer() {
+		return buffers[back];
+	}
+	/// <summary>
+	/// Hands the write buffer over to the reader and takes back the buffer in the middle slot
+	/// </summary>
+	void publish() {
+		back = middle.exchange(back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+	}
+	/// <summary>
+	/// Swaps in the last published buffer, if there is one the reader has not seen yet
+	/// </summary>
+	/// <returns>true if read_buffer() changed</returns>
+	bool update() {
+		if ((middle.load(std::memory_order_relaxed) & fresh_bit) == 0) return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+		return true;
+	}
+	const T& read_buffer() const {
+		return buffers[front];
+	}
+private:
+	static constexpr unsigned int index_mask = 3;
+	static constexpr unsigned int fresh_bit = 4;
+
+	T buffers[3];
+	// Only touched by the writer
+	unsigned int back = 0;
+	// Only touched by the reader
+	unsigned int front = 1;
+	// Index of the shared buffer, plus fresh_bit when it holds a publication the reader has not taken
+	std::atomic<unsigned int> middle = 2;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <body_store/body_store.hpp>
+#include <gravity_simd/gravity_simd.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+/// <summary>
+/// Wisdom-Holman mapping in democratic heliocentric coordinates, for systems dominated by one central body (the most
+/// massive one). Satellites are described by their position relative to the central body and their barycentric
+/// velocity. Each step is interaction(dt/2) jump(dt/2) kepler(dt) jump(dt/2) interaction(dt/2):
+/// - kepler moves every satellite exactly along its orbit around the central body (kepler_drift), and rotates every
+///   body with rotate_free_body
+/// - jump shifts the satellites by the momentum they carry together, divided by the central mass
+/// - interaction kicks the satellites with the gravity they exert on each other, summed with the batched direct kernel,
+///   and kicks every angular momentum with all the tidal torques, including those between satellites and central body
+/// Energy errors stay bounded at steps of around a twentieth of the shortest orbital period.
+/// </summary>
+class WisdomHolmanIntegrator {
+public:
+	/// <summary>
+	/// Advances every body by delta_time. Forces and torques hold the interaction part of the last evaluation afterwards
+	/// </summary>
+	void step(BodyStore& bodies, const float G, const SimdLevel simd_level, const float delta_time, ThreadPool& thread_pool);
+	/// <summary>
+	/// Forgets the interactions kept from the last step
+	/// </summary>
+	void reset();
+	unsigned long long evaluations() const;
+private:
+	// Democratic heliocentric coordinates of the step in progress. The central body stays at the origin with no velocity
+	std::vector<glm::vec3> heliocentric_positions, barycentric_velocities;
+	std::vector<float> kepler_mus, source_masses;
+	std::vector<glm::vec3> interaction_forces, interaction_torques;
+	GravitySources sources;
+	unsigned int central = 0;
+	bool forces_current = false;
+	unsigned long long evaluation_count = 0;
+
+	void evaluate_interactions(BodyStore& bodies, const float G, const SimdLevel simd_level, ThreadPool& thread_pool);
+	void kick(BodyStore& bodies, const float delta_time);
+	void jump(const BodyStore& bodies, const float delta_time);
+};
@@ -0,0 +1,177 @@
+#include <barnes_hut/barnes_hut.hpp>
+#include <gravity/gravity.hpp>
+#include <algorithm>
+
+using std::vector;
+using glm::mat3, glm::vec3;
+
+constexpr unsigned int max_octree_depth = 32;
+
+Octree::Octree(const unsigned int leaf_capacity) {
+	this->leaf_capacity = std::max(leaf_capacity, 1u);
+}
+
+void Octree::build(const BodyStore& bodies) {
+	const unsigned int n = bodies.size();
+	nodes.clear();
+	order.resize(n);
+	scratch.resize(n);
+	positions.resize(n);
+	masses.resize(n);
+	if (n == 0) return;
+
+	vec3 lower = bodies.positions[0];
+	vec3 upper = lower;
+	for (unsigned int i = 0; i < n; ++i) {
+		order[i] = i;
+		lower = glm::min(lower, bodies.positions[i]);
+		upper = glm::max(upper, bodies.positions[i]);
+	}
+	const vec3 extent = upper - lower;
+	// Slightly enlarge the root so that bodies on the upper boundary fall strictly inside it
+	const float half_size = 0.5f * std::max({ extent.x, extent.y, extent.z, 1e-6f }) * 1.001f;
+
+	OctreeNode root;
+	root.center = 0.5f * (lower + upper);
+	root.half_size = half_size;
+	root.first_child = 0;
+	root.begin = 0;
+	root.end = n;
+	nodes.reserve(2 * n / leaf_capacity + 8);
+	nodes.push_back(root);
+
+	// Positions and masses are gathered in tree order after subdivision, but partitioning needs them by body index
+	std::copy(bodies.positions.begin(), bodies.positions.end(), positions.begin());
+	std::copy(bodies.masses.begin(), bodies.masses.end(), masses.begin());
+	subdivide(0, 0);
+
+	vector<vec3> sorted_positions(n);
+	vector<float> sorted_masses(n);
+	for (unsigned int k = 0; k < n; ++k) {
+		sorted_positions[k] = positions[order[k]];
+		sorted_masses[k] = masses[order[k]];
+	}
+	positions = std::move(sorted_positions);
+	masses = std::move(sorted_masses);
+}
+
+void Octree::subdivide(const unsigned int node_index, const unsigned int depth) {
+	const unsigned int begin = nodes[node_index].begin;
+	const unsigned int end = nodes[node_index].end;
+
+	if (end - begin <= leaf_capacity || depth >= max_octree_depth) {
+		float mass = 0.0f;
+		vec3 weighted_position = vec3(0.0f);
+		for (unsigned int k = begin; k < end; ++k) {
+			mass += masses[order[k]];
+			weighted_position += masses[order[k]] * positions[order[k]];
+		}
+		OctreeNode& node = nodes[node_index];
+		node.mass = mass;
+		node.center_of_mass = mass > 0.0f ? weighted_position / mass : node.center;
+		return;
+	}
+
+	const vec3 center = nodes[node_index].center;
+	const float child_half = 0.5f * nodes[node_index].half_size;
+
+	// Counting sort of the node's bodies into the 8 octants
+	unsigned int count[9] = { 0 };
+	auto octant = [&](const unsigned int body) {
+		const vec3& p = positions[body];
+		return (p.x >= center.x ? 1u : 0u) | (p.y >= center.y ? 2u : 0u) | (p.z >= center.z ? 4u : 0u);
+	};
+	for (unsigned int k = begin; k < end; ++k) {
+		++count[octant(order[k]) + 1];
+	}
+	for (unsigned int c = 0; c < 8; ++c) {
+		count[c + 1] += count[c];
+	}
+	unsigned int offset[8];
+	std::copy(count, count + 8, offset);
+	for (unsigned int k = begin; k < end; ++k) {
+		scratch[begin + offset[octant(order[k])]++] = order[k];
+	}
+	std::copy(scratch.begin() + begin, scratch.begin() + end, order.begin() + begin);
+
+	const unsigned int first_child = nodes.size();
+	nodes[node_index].first_child = first_child;
+	for (unsigned int c = 0; c < 8; ++c) {
+		OctreeNode child;
+		child.center = center + child_half * vec3(c & 1u ? 1.0f : -1.0f, c & 2u ? 1.0f : -1.0f, c & 4u ? 1.0f : -1.0f);
+		child.half_size = child_half;
+		child.first_child = 0;
+		child.begin = begin + count[c];
+		child.end = begin + count[c + 1];
+		nodes.push_back(child);
+	}
+
+	float mass = 0.0f;
+	vec3 weighted_position = vec3(0.0f);
+	for (unsigned int c = 0; c < 8; ++c) {
+		if (nodes[first_child + c].begin == nodes[first_child + c].end) {
+			nodes[first_child + c].mass = 0.0f;
+			nodes[first_child + c].center_of_mass = nodes[first_child + c].center;
+			continue;
+		}
+		subdivide(first_child + c, depth + 1);
+		mass += nodes[first_child + c].mass;
+		weighted_position += nodes[first_child + c].mass * nodes[first_child + c].center_of_mass;
+	}
+	OctreeNode& node = nodes[node_index];
+	node.mass = mass;
+	node.center_of_mass = mass > 0.0f ? weighted_position / mass : node.center;
+}
+
+void Octree::evaluate(const vec3& position, const float mass, const mat3& world_inertia, const unsigned int index,
+	const float G, const float opening_angle, vec3& force, vec3& torque) const {
+	force = vec3(0.0f);
+	torque = vec3(0.0f);
+	if (nodes.empty()) return;
+
+	const float theta2 = opening_angle * opening_angle;
+	unsigned int stack[8 * max_octree_depth + 8];
+	unsigned int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0) {
+		const OctreeNode& node = nodes[stack[--stack_size]];
+		if (node.mass == 0.0f) continue;
+
+		if (node.first_child == 0) {
+			for (unsigned int k = node.begin; k < node.end; ++k) {
+				if (order[k] == index) continue;
+				const vec3 r = positions[k] - position;
+				const float mu = masses[k] * G;
+				force += gravity_force(mass, r, mu);
+				torque += gravity_torque(world_inertia, r, mu);
+			}
+			continue;
+		}
+
+		const vec3 r = node.center_of_mass - position;
+		const vec3 offset = glm::abs(position - node.center);
+		const bool contains_body = offset.x <= node.half_size && offset.y <= node.half_size && offset.z <= node.half_size;
+		const float size = 2.0f * node.half_size;
+		if (!contains_body && size * size < theta2 * glm::dot(r, r)) {
+			const float mu = node.mass * G;
+			force += gravity_force(mass, r, mu);
+			torque += gravity_torque(world_inertia, r, mu);
+			continue;
+		}
+		for (unsigned int c = 0; c < 8; ++c) {
+			stack[stack_size++] = node.first_child + c;
+		}
+	}
+}
+
+void Octree::accumulate_gravity(BodyStore& bodies, const float G, const float opening_angle, ThreadPool& thread_pool) const {
+	thread_pool.parallel_for(bodies.size(), force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			vec3 force, torque;
+			evaluate(bodies.positions[i], bodies.masses[i], bodies.world_inertias[i], i, G, opening_angle, force, torque);
+			bodies.forces[i] += force;
+			bodies.torques[i] += torque;
+		}
+	});
+}
@@ -0,0 +1,143 @@
+#include <body_store/body_store.hpp>
+#include <algorithm>
+#include <utility>
+
+using glm::mat3, glm::vec3, glm::quat;
+
+unsigned int BodyStore::size() const {
+	return positions.size();
+}
+
+void BodyStore::reserve(const unsigned int capacity) {
+	positions.reserve(capacity);
+	linear_momenta.reserve(capacity);
+	forces.reserve(capacity);
+	masses.reserve(capacity);
+	angular_momenta.reserve(capacity);
+	torques.reserve(capacity);
+	orientations.reserve(capacity);
+	velocities.reserve(capacity);
+	angular_velocities.reserve(capacity);
+	world_inertias.reserve(capacity);
+	inverse_world_inertias.reserve(capacity);
+	rotation_matrices.reserve(capacity);
+	inertia_tensors.reserve(capacity);
+	inverse_inertia_tensors.reserve(capacity);
+	principal_moments.reserve(capacity);
+	principal_frames.reserve(capacity);
+	shapes.reserve(capacity);
+}
+
+unsigned int BodyStore::add(const RigidBody& body) {
+	positions.push_back(body.center_of_mass.position);
+	linear_momenta.push_back(body.center_of_mass.linear_momentum);
+	forces.push_back(body.center_of_mass.force);
+	masses.push_back(body.center_of_mass.mass);
+	angular_momenta.push_back(body.angular_momentum);
+	torques.push_back(body.torque);
+	orientations.push_back(body.orientation_quat);
+
+	velocities.push_back(body.velocity);
+	angular_velocities.push_back(body.angular_velocity);
+	world_inertias.push_back(body.world_inertia);
+	inverse_world_inertias.push_back(body.inverse_world_inertia);
+	rotation_matrices.push_back(body.rotation_matrix);
+
+	inertia_tensors.push_back(body.inertia_tensor);
+	inverse_inertia_tensors.push_back(body.inverse_inertia_tensor);
+	principal_moments.push_back(body.principal_moments);
+	principal_frames.push_back(body.principal_frame);
+	MeshAsset asset;
+	// RigidBody already shifted its vertices to the center of mass
+	asset.vertices = body.vertices;
+	asset.bounding_radius = mesh_bounding_radius(asset.vertices);
+	asset.properties = MeshProperties{
+		body.volume,
+		vec3(0.0f),
+		body.inertia_tensor / body.density,
+		body.inverse_inertia_tensor * body.density,
+		body.principal_moments / body.density,
+		body.principal_frame
+	};
+	shapes.push_back(BodyShape{ meshes.add(std::move(asset)), body.density });
+	return size() - 1;
+}
+
+unsigned int BodyStore::add(const MeshHandle mesh, const float density) {
+	const MassProperties properties = scale_mass_properties(meshes.get(mesh).properties, density);
+	positions.push_back(properties.center_of_mass);
+	linear_momenta.push_back(vec3(0.0f));
+	forces.push_back(vec3(0.0f));
+	masses.push_back(properties.mass);
+	angular_momenta.push_back(vec3(0.0f));
+	torques.push_back(vec3(0.0f));
+	orientations.push_back(quat(1.0f, 0.0f, 0.0f, 0.0f));
+
+	velocities.push_back(vec3(0.0f));
+	angular_velocities.push_back(vec3(0.0f));
+	world_inertias.push_back(mat3(0.0f));
+	inverse_world_inertias.push_back(mat3(0.0f));
+	rotation_matrices.push_back(mat3(1.0f));
+
+	inertia_tensors.push_back(properties.inertia_tensor);
+	inverse_inertia_tensors.push_back(properties.inverse_inertia_tensor);
+	principal_moments.push_back(properties.principal_moments);
+	principal_frames.push_back(properties.principal_frame);
+	shapes.push_back(BodyShape{ mesh, density });
+	return size() - 1;
+}
+
+RigidBodyView BodyStore::view(const unsigned int index) {
+	return RigidBodyView{
+		PointView{ masses[index], positions[index], linear_momenta[index], forces[index] },
+		angular_momenta[index], torques[index], orientations[index],
+		shapes[index].density, meshes.get(shapes[index].mesh).properties.volume, inertia_tensors[index], inverse_inertia_tensors[index],
+		principal_moments[index], principal_frames[index],
+		velocities[index], angular_velocities[index], world_inertias[index], inverse_world_inertias[index], rotation_matrices[index],
+		meshes.get(shapes[index].mesh).vertices
+	};
+}
+
+void BodyStore::update_state(const float delta_time) {
+	kick(delta_time);
+	drift(delta_time);
+	clear_forces();
+}
+
+void BodyStore::kick(const float delta_time) {
+	const unsigned int n = size();
+	for (unsigned int i = 0; i < n; ++i) {
+		angular_momenta[i] += torques[i] * delta_time;
+		linear_momenta[i] += forces[i] * delta_time;
+	}
+}
+
+void BodyStore::drift(const float delta_time) {
+	const unsigned int n = size();
+	for (unsigned int i = 0; i < n; ++i) {
+		positions[i] += velocities[i] * delta_time;
+	}
+	for (unsigned int i = 0; i < n; ++i) {
+		orientations[i] = rotate_free_body(orientations[i], angular_momenta[i], principal_moments[i], principal_frames[i], delta_time);
+	}
+}
+
+void BodyStore::clear_forces() {
+	std::fill(forces.begin(), forces.end(), vec3(0.0f));
+	std::fill(torques.begin(), torques.end(), vec3(0.0f));
+}
+
+void BodyStore::update_auxiliary_variables() {
+	const unsigned int n = size();
+	for (unsigned int i = 0; i < n; ++i) {
+		velocities[i] = linear_momenta[i] / masses[i];
+	}
+	for (unsigned int i = 0; i < n; ++i) {
+		const mat3 rotation = glm::mat3_cast(orientations[i]);
+		const mat3 rotation_t = glm::transpose(rotation);
+		rotation_matrices[i] = rotation;
+		inverse_world_inertias[i] = rotation * inverse_inertia_tensors[i] * rotation_t;
+		world_inertias[i] = rotation * inertia_tensors[i] * rotation_t;
+		angular_velocities[i] = inverse_world_inertias[i] * angular_momenta[i];
+	}
+}
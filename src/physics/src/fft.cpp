@@ -0,0 +1,130 @@
+#include <fft/fft.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using std::complex, std::vector;
+
+// Amount of grid lines transformed by a single task of fft_3d
+constexpr unsigned int fft_line_block_size = 64;
+// Amount of neighbouring strided lines gathered and transformed together
+constexpr unsigned int fft_tile_width = 16;
+
+// Product with a twiddle factor, or with its conjugate for the inverse transform. Written out because the
+// standard complex product checks for infinities and NaNs, which dominates the transform
+static complex<float> multiply(const complex<float> value, const complex<float> twiddle, const bool conjugate) {
+	const float re = twiddle.real();
+	const float im = conjugate ? -twiddle.imag() : twiddle.imag();
+	return complex<float>(value.real() * re - value.imag() * im, value.real() * im + value.imag() * re);
+}
+
+bool is_power_of_two(const unsigned int n) {
+	return n != 0 && (n & (n - 1)) == 0;
+}
+
+FftPlan::FftPlan(const unsigned int length) {
+	this->length = length;
+	unsigned int bits = 0;
+	while ((1u << bits) < length) ++bits;
+	reversed.resize(length);
+	for (unsigned int i = 0; i < length; ++i) {
+		unsigned int r = 0;
+		for (unsigned int b = 0; b < bits; ++b) {
+			r |= ((i >> b) & 1u) << (bits - 1 - b);
+		}
+		reversed[i] = r;
+	}
+	// twiddles[k] = exp(-2 pi i k / length) for k < length / 2; every stage reads them with a stride
+	const double pi = 3.14159265358979323846;
+	twiddles.resize(length / 2);
+	for (unsigned int k = 0; k < length / 2; ++k) {
+		const double angle = -2.0 * pi * k / length;
+		twiddles[k] = complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+	}
+}
+
+unsigned int FftPlan::size() const {
+	return length;
+}
+
+void FftPlan::transform(complex<float>* data, const bool inverse) const {
+	for (unsigned int i = 0; i < length; ++i) {
+		if (i < reversed[i]) std::swap(data[i], data[reversed[i]]);
+	}
+	for (unsigned int half = 1; half < length; half *= 2) {
+		const unsigned int stride = length / (2 * half);
+		for (unsigned int start = 0; start < length; start += 2 * half) {
+			for (unsigned int k = 0; k < half; ++k) {
+				const complex<float> even = data[start + k];
+				const complex<float> odd = multiply(data[start + k + half], twiddles[k * stride], inverse);
+				data[start + k] = even + odd;
+				data[start + k + half] = even - odd;
+			}
+		}
+	}
+	if (inverse) {
+		const float scale = 1.0f / length;
+		for (unsigned int i = 0; i < length; ++i) {
+			data[i] *= scale;
+		}
+	}
+}
+
+/// <summary>
+/// Transforms the lines along an axis whose other two coordinates, in increasing axis order, are below
+/// first_count and second_count
+/// </summary>
+static void transform_lines(vector<complex<float>>& grid, const FftPlan& plan, const unsigned int axis, const unsigned int first_count,
+	const unsigned int second_count, const bool inverse, ThreadPool& thread_pool) {
+	const unsigned int n = plan.size();
+	const size_t stride = axis == 0 ? 1 : axis == 1 ? n : static_cast<size_t>(n) * n;
+	// Line l has first coordinate l % first_count and second coordinate l / first_count
+	const auto line_base = [&](const unsigned int l) {
+		const size_t first = l % first_count, second = l / first_count;
+		return axis == 0 ? (second * n + first) * n : axis == 1 ? second * n * n + first : second * n + first;
+	};
+	thread_pool.parallel_for(first_count * second_count, fft_line_block_size, [&](const unsigned int begin, const unsigned int end) {
+		if (stride == 1) {
+			for (unsigned int l = begin; l < end; ++l) {
+				plan.transform(&grid[line_base(l)], inverse);
+			}
+			return;
+		}
+		// Lines along y and z are strided. Neighbouring lines (consecutive x) are gathered together in tiles, so every
+		// cache line read from the grid is fully used. x spans the whole axis here, so tiles never wrap
+		const unsigned int tile = std::min(n, fft_tile_width);
+		vector<complex<float>> lines(static_cast<size_t>(tile) * n);
+		for (unsigned int l = begin; l < end; l += tile) {
+			const size_t base = line_base(l);
+			for (unsigned int i = 0; i < n; ++i) {
+				for (unsigned int t = 0; t < tile; ++t) {
+					lines[static_cast<size_t>(t) * n + i] = grid[base + i * stride + t];
+				}
+			}
+			for (unsigned int t = 0; t < tile; ++t) {
+				plan.transform(&lines[static_cast<size_t>(t) * n], inverse);
+			}
+			for (unsigned int i = 0; i < n; ++i) {
+				for (unsigned int t = 0; t < tile; ++t) {
+					grid[base + i * stride + t] = lines[static_cast<size_t>(t) * n + i];
+				}
+			}
+		}
+	});
+}
+
+void fft_3d(vector<complex<float>>& grid, const unsigned int n, const bool inverse, ThreadPool& thread_pool, const unsigned int extent) {
+	const FftPlan plan(n);
+	// Lines that only hold zeros (forward) or only feed unused nodes (inverse) are skipped
+	const unsigned int used = extent == 0 ? n : extent;
+	if (!inverse) {
+		transform_lines(grid, plan, 0, used, used, inverse, thread_pool);
+		transform_lines(grid, plan, 1, n, used, inverse, thread_pool);
+		transform_lines(grid, plan, 2, n, n, inverse, thread_pool);
+	}
+	else {
+		transform_lines(grid, plan, 2, n, n, inverse, thread_pool);
+		transform_lines(grid, plan, 1, n, used, inverse, thread_pool);
+		transform_lines(grid, plan, 0, used, used, inverse, thread_pool);
+	}
+}
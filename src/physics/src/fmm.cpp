@@ -0,0 +1,384 @@
+#include <fmm/fmm.hpp>
+#include <gravity/gravity.hpp>
+#include <algorithm>
+#include <cmath>
+
+using std::vector;
+using glm::mat3, glm::vec3;
+
+// Largest opening angle used by the traversal, so accepted cells never overlap
+constexpr float max_multipole_opening_angle = 0.999f;
+
+static double binomial(const unsigned int n, const unsigned int k) {
+	double result = 1.0;
+	for (unsigned int i = 1; i <= k; ++i) {
+		result = result * (n - k + i) / i;
+	}
+	return result;
+}
+
+MultiIndexTable::MultiIndexTable(const unsigned int order) {
+	this->order = order;
+	const unsigned int side = order + 1;
+	lookup.assign(side * side * side, 0);
+	for (unsigned int degree = 0; degree <= order; ++degree) {
+		for (int x = degree; x >= 0; --x) {
+			for (int y = degree - x; y >= 0; --y) {
+				const unsigned int z = degree - x - y;
+				lookup[(x * side + y) * side + z] = indices.size();
+				indices.push_back({ static_cast<unsigned int>(x), static_cast<unsigned int>(y), z });
+				degrees.push_back(degree);
+			}
+		}
+	}
+	size = indices.size();
+
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		below[axis].assign(size, size);
+		below_twice[axis].assign(size, size);
+	}
+	power_parent.assign(size, 0);
+	power_axis.assign(size, 0);
+	first_factor.assign(size, 0.0);
+	second_factor.assign(size, 0.0);
+	for (unsigned int n = 1; n < size; ++n) {
+		const double degree = degrees[n];
+		first_factor[n] = (2.0 * degree - 1.0) / degree;
+		second_factor[n] = (degree - 1.0) / degree;
+		bool parent_found = false;
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			std::array<unsigned int, 3> lower = indices[n];
+			if (lower[axis] == 0) continue;
+			--lower[axis];
+			below[axis][n] = index(lower[0], lower[1], lower[2]);
+			if (!parent_found) {
+				power_parent[n] = below[axis][n];
+				power_axis[n] = axis;
+				parent_found = true;
+			}
+			if (lower[axis] == 0) continue;
+			--lower[axis];
+			below_twice[axis][n] = index(lower[0], lower[1], lower[2]);
+		}
+	}
+
+	for (unsigned int high = 0; high < size; ++high) {
+		const auto& h = indices[high];
+		for (unsigned int low = 0; low < size; ++low) {
+			const auto& l = indices[low];
+			if (l[0] > h[0] || l[1] > h[1] || l[2] > h[2]) continue;
+			const ShiftTerm term{ high, low, index(h[0] - l[0], h[1] - l[1], h[2] - l[2]),
+				binomial(h[0], l[0]) * binomial(h[1], l[1]) * binomial(h[2], l[2]) };
+			shift_terms.push_back(term);
+			if (degrees[low] == 1 || degrees[low] == 2) {
+				evaluation_terms.push_back(term);
+			}
+		}
+	}
+
+	for (unsigned int local = 0; local < size; ++local) {
+		interaction_begin.push_back(interaction_terms.size());
+		const auto& k = indices[local];
+		for (unsigned int multipole = 0; multipole < size; ++multipole) {
+			if (degrees[local] + degrees[multipole] > order) continue;
+			const auto& n = indices[multipole];
+			interaction_terms.push_back(InteractionTerm{ local, multipole, index(k[0] + n[0], k[1] + n[1], k[2] + n[2]),
+				binomial(k[0] + n[0], k[0]) * binomial(k[1] + n[1], k[1]) * binomial(k[2] + n[2], k[2]) });
+		}
+	}
+	interaction_begin.push_back(interaction_terms.size());
+}
+
+unsigned int MultiIndexTable::index(const unsigned int x, const unsigned int y, const unsigned int z) const {
+	const unsigned int side = order + 1;
+	return lookup[(x * side + y) * side + z];
+}
+
+void MultiIndexTable::powers(const double d[3], double* out) const {
+	out[0] = 1.0;
+	for (unsigned int n = 1; n < size; ++n) {
+		out[n] = out[power_parent[n]] * d[power_axis[n]];
+	}
+}
+
+void MultiIndexTable::derivatives(const double R[3], double* out) const {
+	// Recurrence for the Taylor coefficients of 1/r:
+	// |n| r^2 a_n = -(2|n| - 1) sum_i R_i a_(n - e_i) - (|n| - 1) sum_i a_(n - 2 e_i)
+	const double r2 = R[0] * R[0] + R[1] * R[1] + R[2] * R[2];
+	const double inv_r2 = 1.0 / r2;
+	out[0] = std::sqrt(inv_r2);
+	for (unsigned int n = 1; n < size; ++n) {
+		double first = 0.0, second = 0.0;
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			if (below[axis][n] != size) first += R[axis] * out[below[axis][n]];
+			if (below_twice[axis][n] != size) second += out[below_twice[axis][n]];
+		}
+		out[n] = -inv_r2 * (first_factor[n] * first + second_factor[n] * second);
+	}
+}
+
+FastMultipole::FastMultipole(const unsigned int order, const unsigned int leaf_capacity)
+	: octree(leaf_capacity), table(std::clamp(order, min_multipole_order, max_multipole_order)) {
+}
+
+bool FastMultipole::is_leaf(const unsigned int node) const {
+	return octree.nodes[node].first_child == 0;
+}
+
+void FastMultipole::accumulate_gravity(BodyStore& bodies, const float G, const float opening_angle, const SimdLevel simd_level, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	if (n == 0) return;
+	octree.build(bodies);
+	const unsigned int node_count = octree.nodes.size();
+	multipoles.assign(node_count * table.size, 0.0);
+	locals.assign(node_count * table.size, 0.0);
+	radii.assign(node_count, 0.0f);
+	world_inertias.resize(n);
+	for (unsigned int k = 0; k < n; ++k) {
+		world_inertias[k] = bodies.world_inertias[octree.order[k]];
+	}
+	forces.assign(n, vec3(0.0f));
+	torques.assign(n, vec3(0.0f));
+
+	split_tasks();
+	thread_pool.run(tasks.size(), [&](const unsigned int task) {
+		vector<double> powers(table.size);
+		upward_pass(tasks[task], G, powers.data());
+	});
+	// Children always come after their parent in the node array, so a descending sweep visits them first
+	vector<double> powers(table.size);
+	for (auto node = top_nodes.rbegin(); node != top_nodes.rend(); ++node) {
+		combine_children(*node, powers.data());
+	}
+
+	const float theta = std::min(opening_angle, max_multipole_opening_angle);
+	const GravityKernel kernel = select_gravity_kernel(simd_level);
+	thread_pool.run(tasks.size(), [&](const unsigned int task) {
+		vector<double> powers(table.size);
+		interact(tasks[task], G, theta, kernel);
+		downward_pass(tasks[task], powers.data());
+	});
+
+	for (unsigned int k = 0; k < n; ++k) {
+		bodies.forces[octree.order[k]] += forces[k];
+		bodies.torques[octree.order[k]] += torques[k];
+	}
+}
+
+void FastMultipole::split_tasks() {
+	tasks.clear();
+	top_nodes.clear();
+	vector<unsigned int> pending{ 0 };
+	while (!pending.empty()) {
+		const unsigned int node = pending.back();
+		pending.pop_back();
+		const OctreeNode& cell = octree.nodes[node];
+		if (cell.begin == cell.end) continue;
+		if (!is_leaf(node) && cell.end - cell.begin > multipole_task_size) {
+			top_nodes.push_back(node);
+			for (unsigned int c = 0; c < 8; ++c) {
+				pending.push_back(cell.first_child + c);
+			}
+			continue;
+		}
+		tasks.push_back(node);
+	}
+	std::sort(top_nodes.begin(), top_nodes.end());
+}
+
+void FastMultipole::upward_pass(const unsigned int node, const float G, double* powers) {
+	const OctreeNode& cell = octree.nodes[node];
+	if (cell.begin == cell.end) return;
+	if (!is_leaf(node)) {
+		for (unsigned int c = 0; c < 8; ++c) {
+			upward_pass(cell.first_child + c, G, powers);
+		}
+		combine_children(node, powers);
+		return;
+	}
+
+	// P2M: moments of the bodies around the center of mass of the leaf
+	double* moments = &multipoles[node * table.size];
+	float radius = 0.0f;
+	for (unsigned int k = cell.begin; k < cell.end; ++k) {
+		const vec3 offset = cell.center_of_mass - octree.positions[k];
+		const double d[3] = { offset.x, offset.y, offset.z };
+		table.powers(d, powers);
+		const double mu = static_cast<double>(octree.masses[k]) * G;
+		for (unsigned int i = 0; i < table.size; ++i) {
+			moments[i] += mu * powers[i];
+		}
+		radius = std::max(radius, glm::length(offset));
+	}
+	radii[node] = radius;
+}
+
+void FastMultipole::combine_children(const unsigned int node, double* powers) {
+	// M2M: moments of every child moved to the center of mass of the parent
+	const OctreeNode& cell = octree.nodes[node];
+	double* moments = &multipoles[node * table.size];
+	float radius = 0.0f;
+	for (unsigned int c = 0; c < 8; ++c) {
+		const unsigned int child = cell.first_child + c;
+		const OctreeNode& child_cell = octree.nodes[child];
+		if (child_cell.begin == child_cell.end) continue;
+		const vec3 offset = cell.center_of_mass - child_cell.center_of_mass;
+		const double d[3] = { offset.x, offset.y, offset.z };
+		table.powers(d, powers);
+		const double* child_moments = &multipoles[child * table.size];
+		for (const ShiftTerm& term : table.shift_terms) {
+			moments[term.high] += term.binomial * child_moments[term.low] * powers[term.difference];
+		}
+		radius = std::max(radius, radii[child] + glm::length(offset));
+	}
+	radii[node] = radius;
+}
+
+void FastMultipole::interact(const unsigned int root, const float G, const float opening_angle, const GravityKernel kernel) {
+	const float theta2 = opening_angle * opening_angle;
+	vector<double> derivatives(table.size);
+	// Leaf pairs that are too close for expansions, evaluated afterwards grouped by target leaf
+	vector<std::pair<unsigned int, unsigned int>> near_pairs;
+	vector<std::pair<unsigned int, unsigned int>> stack{ { root, 0u } };
+	while (!stack.empty()) {
+		const auto [target, source] = stack.back();
+		stack.pop_back();
+		const OctreeNode& a = octree.nodes[target];
+		const OctreeNode& b = octree.nodes[source];
+		if (a.begin == a.end || b.begin == b.end) continue;
+
+		const vec3 r = a.center_of_mass - b.center_of_mass;
+		const float distance2 = glm::dot(r, r);
+		const float radius_sum = radii[target] + radii[source];
+		// Pairs inside the softening length always go through the direct kernel so the EPSILON clamp still applies
+		if (distance2 > EPSILON && radius_sum * radius_sum < theta2 * distance2) {
+			multipole_to_local(target, source, derivatives.data());
+		}
+		else if (is_leaf(target) && is_leaf(source)) {
+			near_pairs.emplace_back(target, source);
+		}
+		else if (!is_leaf(source) && (is_leaf(target) || radii[source] >= radii[target])) {
+			for (unsigned int c = 0; c < 8; ++c) {
+				stack.emplace_back(target, b.first_child + c);
+			}
+		}
+		else {
+			for (unsigned int c = 0; c < 8; ++c) {
+				stack.emplace_back(a.first_child + c, source);
+			}
+		}
+	}
+
+	std::stable_sort(near_pairs.begin(), near_pairs.end(), [](const auto& left, const auto& right) {
+		return left.first < right.first;
+	});
+	vector<unsigned int> source_leaves;
+	for (unsigned int first = 0; first < near_pairs.size();) {
+		const unsigned int target = near_pairs[first].first;
+		source_leaves.clear();
+		unsigned int last = first;
+		for (; last < near_pairs.size() && near_pairs[last].first == target; ++last) {
+			source_leaves.push_back(near_pairs[last].second);
+		}
+		direct_interaction(target, source_leaves, G, kernel);
+		first = last;
+	}
+}
+
+void FastMultipole::multipole_to_local(const unsigned int target, const unsigned int source, double* derivatives) {
+	const vec3 r = octree.nodes[target].center_of_mass - octree.nodes[source].center_of_mass;
+	const double R[3] = { r.x, r.y, r.z };
+	table.derivatives(R, derivatives);
+	const double* moments = &multipoles[source * table.size];
+	double* local = &locals[target * table.size];
+	// Terms are grouped by local coefficient, so each one is summed in registers and stored once.
+	// Two partial sums halve the dependency chain of the additions
+	for (unsigned int k = 0; k < table.size; ++k) {
+		const unsigned int end = table.interaction_begin[k + 1];
+		double even = 0.0, odd = 0.0;
+		unsigned int t = table.interaction_begin[k];
+		for (; t + 1 < end; t += 2) {
+			const InteractionTerm& first = table.interaction_terms[t];
+			const InteractionTerm& second = table.interaction_terms[t + 1];
+			even += first.binomial * moments[first.multipole] * derivatives[first.derivative];
+			odd += second.binomial * moments[second.multipole] * derivatives[second.derivative];
+		}
+		if (t < end) {
+			const InteractionTerm& last = table.interaction_terms[t];
+			even += last.binomial * moments[last.multipole] * derivatives[last.derivative];
+		}
+		local[k] += even + odd;
+	}
+}
+
+void FastMultipole::direct_interaction(const unsigned int target, const vector<unsigned int>& source_leaves, const float G, const GravityKernel kernel) {
+	// The bodies of every near leaf are gathered into one padded list so the batched kernel runs once per target body
+	const OctreeNode& a = octree.nodes[target];
+	vector<vec3> positions;
+	vector<float> masses;
+	unsigned int self_offset = ~0u;
+	for (const unsigned int source : source_leaves) {
+		const OctreeNode& b = octree.nodes[source];
+		if (source == target) self_offset = positions.size();
+		positions.insert(positions.end(), octree.positions.begin() + b.begin, octree.positions.begin() + b.end);
+		masses.insert(masses.end(), octree.masses.begin() + b.begin, octree.masses.begin() + b.end);
+	}
+	GravitySources sources;
+	sources.assign(positions, masses, G);
+	const GravitySourceArrays arrays = sources.arrays();
+	for (unsigned int k = a.begin; k < a.end; ++k) {
+		const unsigned int skip_index = self_offset == ~0u ? arrays.count : self_offset + (k - a.begin);
+		const GravityTarget body = make_gravity_target(octree.positions[k], octree.masses[k], world_inertias[k], skip_index);
+		vec3 force, torque;
+		kernel(arrays, body, &force.x, &torque.x);
+		forces[k] += force;
+		torques[k] += torque;
+	}
+}
+
+void FastMultipole::downward_pass(const unsigned int node, double* powers) {
+	const OctreeNode& cell = octree.nodes[node];
+	if (cell.begin == cell.end) return;
+	if (is_leaf(node)) {
+		evaluate_locals(node, powers);
+		return;
+	}
+	// L2L: the local expansion of the parent moved to the center of mass of every child
+	const double* local = &locals[node * table.size];
+	for (unsigned int c = 0; c < 8; ++c) {
+		const unsigned int child = cell.first_child + c;
+		const OctreeNode& child_cell = octree.nodes[child];
+		if (child_cell.begin == child_cell.end) continue;
+		const vec3 offset = child_cell.center_of_mass - cell.center_of_mass;
+		const double d[3] = { offset.x, offset.y, offset.z };
+		table.powers(d, powers);
+		double* child_local = &locals[child * table.size];
+		for (const ShiftTerm& term : table.shift_terms) {
+			child_local[term.low] += term.binomial * local[term.high] * powers[term.difference];
+		}
+		downward_pass(child, powers);
+	}
+}
+
+void FastMultipole::evaluate_locals(const unsigned int leaf, double* powers) {
+	// L2P: only the first and second order terms at the body are needed, they are the field and the tidal tensor
+	const OctreeNode& cell = octree.nodes[leaf];
+	const double* local = &locals[leaf * table.size];
+	for (unsigned int k = cell.begin; k < cell.end; ++k) {
+		const vec3 offset = octree.positions[k] - cell.center_of_mass;
+		const double d[3] = { offset.x, offset.y, offset.z };
+		table.powers(d, powers);
+		double shifted[10] = { 0.0 };
+		for (const ShiftTerm& term : table.evaluation_terms) {
+			shifted[term.low] += term.binomial * local[term.high] * powers[term.difference];
+		}
+		const vec3 field = vec3(shifted[1], shifted[2], shifted[3]);
+		// Second order coefficients are (xx, xy, xz, yy, yz, zz); diagonal terms carry a 1/2 from the Taylor series
+		const mat3 tidal = mat3(
+			2.0 * shifted[4], shifted[5], shifted[6],
+			shifted[5], 2.0 * shifted[7], shifted[8],
+			shifted[6], shifted[8], 2.0 * shifted[9]);
+		forces[k] += octree.masses[k] * field;
+		torques[k] += tidal_torque(tidal, world_inertias[k]);
+	}
+}
@@ -0,0 +1,91 @@
+#include <gravity/gravity.hpp>
+#include <barnes_hut/barnes_hut.hpp>
+#include <fmm/fmm.hpp>
+#include <mesh_multipole/mesh_multipole.hpp>
+#include <particle_mesh/particle_mesh.hpp>
+#include <p3m/p3m.hpp>
+
+using glm::mat3, glm::vec3;
+
+vec3 gravity_torque(const mat3& world_inertia, const vec3& r, const float mu) {
+	float dist2 = glm::dot(r, r);
+	if (dist2 < EPSILON) dist2 = EPSILON;
+	const float inv_r = glm::inversesqrt(dist2);
+	const float inv_r2 = inv_r * inv_r;
+	return 3.0f * mu * inv_r2 * inv_r2 * inv_r * glm::cross(r, world_inertia * r);
+}
+
+vec3 gravity_torque(const RigidBody& rb, const vec3& r, const float mu) {
+	return gravity_torque(rb.world_inertia, r, mu);
+}
+
+vec3 tidal_torque(const mat3& tidal, const mat3& world_inertia) {
+	// tau_i = e_ijk (T I)_jk. glm indexes [column][row]
+	const mat3 product = tidal * world_inertia;
+	return vec3(product[2][1] - product[1][2], product[0][2] - product[2][0], product[1][0] - product[0][1]);
+}
+
+vec3 gravity_force(const float mass, const vec3& r, const float mu) {
+	float dist2 = glm::dot(r, r);
+	if (dist2 < EPSILON) dist2 = EPSILON;
+	return mass * mu / dist2 * glm::normalize(r);
+}
+
+vec3 gravity_force(const RigidBody& rb, const vec3& r, const float mu) {
+	return gravity_force(rb.center_of_mass.mass, r, mu);
+}
+
+void accumulate_gravity_direct(BodyStore& bodies, const float G, const SimdLevel simd_level, ThreadPool& thread_pool) {
+	const GravityKernel kernel = select_gravity_kernel(simd_level);
+	GravitySources sources;
+	sources.assign(bodies.positions, bodies.masses, G);
+	const GravitySourceArrays arrays = sources.arrays();
+
+	thread_pool.parallel_for(bodies.size(), force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			const GravityTarget target = make_gravity_target(bodies.positions[i], bodies.masses[i], bodies.world_inertias[i], i);
+			vec3 force, torque;
+			kernel(arrays, target, &force.x, &torque.x);
+			bodies.forces[i] += force;
+			bodies.torques[i] += torque;
+		}
+	});
+}
+
+void accumulate_gravity(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool) {
+	switch (settings.solver) {
+	case GravitySolver::direct:
+		accumulate_gravity_direct(bodies, settings.G, settings.simd_level, thread_pool);
+		break;
+	case GravitySolver::symmetric:
+		accumulate_gravity_symmetric(bodies, settings.G, settings.simd_level, thread_pool);
+		break;
+	case GravitySolver::barnes_hut: {
+		Octree octree(settings.leaf_capacity);
+		octree.build(bodies);
+		octree.accumulate_gravity(bodies, settings.G, settings.opening_angle, thread_pool);
+		break;
+	}
+	case GravitySolver::fmm: {
+		FastMultipole multipole(settings.multipole_order, settings.multipole_leaf_capacity);
+		multipole.accumulate_gravity(bodies, settings.G, settings.opening_angle, settings.simd_level, thread_pool);
+		break;
+	}
+	case GravitySolver::particle_mesh: {
+		ParticleMesh mesh(settings.mesh_size, settings.mesh_boundary, settings.mass_assignment, settings.mesh_box_size);
+		mesh.accumulate_gravity(bodies, settings.G, thread_pool);
+		break;
+	}
+	case GravitySolver::p3m: {
+		ParticleParticleMesh p3m(settings.mesh_size, settings.mesh_boundary, settings.mass_assignment, settings.mesh_box_size, settings.p3m_split_radius);
+		p3m.accumulate_gravity(bodies, settings.G, thread_pool);
+		break;
+	}
+	}
+	if (settings.mesh_multipole_order > 0) {
+		accumulate_mesh_multipole_gravity(bodies, settings, thread_pool);
+	}
+	if (settings.polyhedron_range > 0.0f) {
+		accumulate_polyhedron_gravity(bodies, settings, thread_pool);
+	}
+}
@@ -0,0 +1,293 @@
+#include <gravity/gravity_kernels.hpp>
+#include <immintrin.h>
+
+// Compiled with AVX2 and FMA enabled. Only called after runtime detection confirmed support.
+
+static inline float horizontal_sum(const __m256 v) {
+	const __m128 halves = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	const __m128 pairs = _mm_add_ps(halves, _mm_movehl_ps(halves, halves));
+	return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 0x55)));
+}
+
+void gravity_kernel_avx2(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]) {
+	const __m256 px = _mm256_set1_ps(target.position[0]);
+	const __m256 py = _mm256_set1_ps(target.position[1]);
+	const __m256 pz = _mm256_set1_ps(target.position[2]);
+	const __m256 mass = _mm256_set1_ps(target.mass);
+	const __m256 epsilon = _mm256_set1_ps(EPSILON);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 inv_sqrt_epsilon = _mm256_div_ps(one, _mm256_sqrt_ps(epsilon));
+	const __m256 three = _mm256_set1_ps(3.0f);
+	const float* w = target.world_inertia;
+	const __m256 w0 = _mm256_set1_ps(w[0]), w1 = _mm256_set1_ps(w[1]), w2 = _mm256_set1_ps(w[2]);
+	const __m256 w3 = _mm256_set1_ps(w[3]), w4 = _mm256_set1_ps(w[4]), w5 = _mm256_set1_ps(w[5]);
+	const __m256 w6 = _mm256_set1_ps(w[6]), w7 = _mm256_set1_ps(w[7]), w8 = _mm256_set1_ps(w[8]);
+	const __m256i skip = _mm256_set1_epi32(static_cast<int>(target.skip_index));
+	const __m256i count = _mm256_set1_epi32(static_cast<int>(sources.count));
+	const __m256i step = _mm256_set1_epi32(8);
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	__m256 fx = _mm256_setzero_ps(), fy = _mm256_setzero_ps(), fz = _mm256_setzero_ps();
+	__m256 tx = _mm256_setzero_ps(), ty = _mm256_setzero_ps(), tz = _mm256_setzero_ps();
+	for (unsigned int j = 0; j < sources.padded_count; j += 8) {
+		const __m256 rx = _mm256_sub_ps(_mm256_loadu_ps(sources.x + j), px);
+		const __m256 ry = _mm256_sub_ps(_mm256_loadu_ps(sources.y + j), py);
+		const __m256 rz = _mm256_sub_ps(_mm256_loadu_ps(sources.z + j), pz);
+		const __m256 mu = _mm256_loadu_ps(sources.mu + j);
+		const __m256 r2 = _mm256_fmadd_ps(rx, rx, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rz, rz)));
+		const __m256 valid = _mm256_castsi256_ps(_mm256_andnot_si256(_mm256_cmpeq_epi32(index, skip), _mm256_cmpgt_epi32(count, index)));
+
+		// The clamped inverse distance only differs from the real one inside EPSILON
+		const __m256 inv_length = _mm256_div_ps(one, _mm256_sqrt_ps(r2));
+		const __m256 inv_r = _mm256_blendv_ps(inv_length, inv_sqrt_epsilon, _mm256_cmp_ps(r2, epsilon, _CMP_LT_OQ));
+		const __m256 inv_r2 = _mm256_mul_ps(inv_r, inv_r);
+
+		const __m256 f = _mm256_and_ps(valid, _mm256_mul_ps(_mm256_mul_ps(mass, mu), _mm256_mul_ps(inv_r2, inv_length)));
+		fx = _mm256_fmadd_ps(f, rx, fx);
+		fy = _mm256_fmadd_ps(f, ry, fy);
+		fz = _mm256_fmadd_ps(f, rz, fz);
+
+		const __m256 t = _mm256_and_ps(valid, _mm256_mul_ps(_mm256_mul_ps(three, mu), _mm256_mul_ps(_mm256_mul_ps(inv_r2, inv_r2), inv_r)));
+		const __m256 ix = _mm256_fmadd_ps(w0, rx, _mm256_fmadd_ps(w3, ry, _mm256_mul_ps(w6, rz)));
+		const __m256 iy = _mm256_fmadd_ps(w1, rx, _mm256_fmadd_ps(w4, ry, _mm256_mul_ps(w7, rz)));
+		const __m256 iz = _mm256_fmadd_ps(w2, rx, _mm256_fmadd_ps(w5, ry, _mm256_mul_ps(w8, rz)));
+		tx = _mm256_fmadd_ps(t, _mm256_fmsub_ps(ry, iz, _mm256_mul_ps(rz, iy)), tx);
+		ty = _mm256_fmadd_ps(t, _mm256_fmsub_ps(rz, ix, _mm256_mul_ps(rx, iz)), ty);
+		tz = _mm256_fmadd_ps(t, _mm256_fmsub_ps(rx, iy, _mm256_mul_ps(ry, ix)), tz);
+
+		index = _mm256_add_epi32(index, step);
+	}
+	force[0] = horizontal_sum(fx); force[1] = horizontal_sum(fy); force[2] = horizontal_sum(fz);
+	torque[0] = horizontal_sum(tx); torque[1] = horizontal_sum(ty); torque[2] = horizontal_sum(tz);
+}
+
+void symmetric_gravity_kernel_avx2(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators) {
+	const __m256 epsilon = _mm256_set1_ps(EPSILON);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 inv_sqrt_epsilon = _mm256_div_ps(one, _mm256_sqrt_ps(epsilon));
+	const __m256 three_g = _mm256_set1_ps(3.0f * G);
+	const __m256i step = _mm256_set1_epi32(8);
+	// Kept in locals: stores through them could otherwise alias the accumulator struct and force reloads
+	float* const force_x = accumulators.force[0], * const force_y = accumulators.force[1], * const force_z = accumulators.force[2];
+	float* const tidal_xx = accumulators.tidal[0], * const tidal_yy = accumulators.tidal[1];
+	float* const tidal_xy = accumulators.tidal[2], * const tidal_xz = accumulators.tidal[3], * const tidal_yz = accumulators.tidal[4];
+	const unsigned int i_last = i_end < bodies.count ? i_end : bodies.count;
+	for (unsigned int i = i_begin; i < i_last; ++i) {
+		const __m256 px = _mm256_set1_ps(bodies.x[i]);
+		const __m256 py = _mm256_set1_ps(bodies.y[i]);
+		const __m256 pz = _mm256_set1_ps(bodies.z[i]);
+		const __m256 mass = _mm256_set1_ps(bodies.mass[i]);
+		const __m256 g_mass = _mm256_set1_ps(G * bodies.mass[i]);
+		// Starts at the vector holding i + 1. Lanes are valid when i < j < count, that is when j - i - 1 < count - i - 1
+		// as unsigned numbers: flipping the sign bit of both sides turns this into a single signed comparison
+		const unsigned int first = (i + 1) & ~7u;
+		const unsigned int j_start = first > j_begin ? first : j_begin;
+		const __m256i bound = _mm256_set1_epi32(static_cast<int>((bodies.count - i - 1) ^ 0x80000000u));
+		__m256i offset = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>((j_start - i - 1) ^ 0x80000000u)),
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+		__m256 fx = _mm256_setzero_ps(), fy = _mm256_setzero_ps(), fz = _mm256_setzero_ps();
+		__m256 txx = _mm256_setzero_ps(), tyy = _mm256_setzero_ps();
+		__m256 txy = _mm256_setzero_ps(), txz = _mm256_setzero_ps(), tyz = _mm256_setzero_ps();
+		for (unsigned int j = j_start; j < j_end; j += 8) {
+			const __m256 rx = _mm256_sub_ps(_mm256_loadu_ps(bodies.x + j), px);
+			const __m256 ry = _mm256_sub_ps(_mm256_loadu_ps(bodies.y + j), py);
+			const __m256 rz = _mm256_sub_ps(_mm256_loadu_ps(bodies.z + j), pz);
+			const __m256 other_mass = _mm256_loadu_ps(bodies.mass + j);
+			const __m256 r2 = _mm256_fmadd_ps(rx, rx, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rz, rz)));
+			const __m256 valid = _mm256_castsi256_ps(_mm256_cmpgt_epi32(bound, offset));
+
+			// The clamped inverse distance only differs from the real one inside EPSILON
+			const __m256 inv_length = _mm256_div_ps(one, _mm256_sqrt_ps(r2));
+			const __m256 inv_r = _mm256_blendv_ps(inv_length, inv_sqrt_epsilon, _mm256_cmp_ps(r2, epsilon, _CMP_LT_OQ));
+			const __m256 inv_r2 = _mm256_mul_ps(inv_r, inv_r);
+
+			// Force on i, j gets the opposite
+			const __m256 f = _mm256_and_ps(valid, _mm256_mul_ps(_mm256_mul_ps(g_mass, other_mass), _mm256_mul_ps(inv_r2, inv_length)));
+			fx = _mm256_fmadd_ps(f, rx, fx);
+			fy = _mm256_fmadd_ps(f, ry, fy);
+			fz = _mm256_fmadd_ps(f, rz, fz);
+			_mm256_storeu_ps(force_x + j, _mm256_fnmadd_ps(f, rx, _mm256_loadu_ps(force_x + j)));
+			_mm256_storeu_ps(force_y + j, _mm256_fnmadd_ps(f, ry, _mm256_loadu_ps(force_y + j)));
+			_mm256_storeu_ps(force_z + j, _mm256_fnmadd_ps(f, rz, _mm256_loadu_ps(force_z + j)));
+
+			// The tidal term is even in r, so both bodies share r r^T and the 3G / r^5 factor
+			const __m256 t = _mm256_and_ps(valid, _mm256_mul_ps(three_g, _mm256_mul_ps(_mm256_mul_ps(inv_r2, inv_r2), inv_r)));
+			const __m256 ti = _mm256_mul_ps(t, other_mass);
+			const __m256 tj = _mm256_mul_ps(t, mass);
+			const __m256 zz = _mm256_mul_ps(rz, rz);
+			const __m256 xx = _mm256_fmsub_ps(rx, rx, zz), yy = _mm256_fmsub_ps(ry, ry, zz);
+			const __m256 xy = _mm256_mul_ps(rx, ry), xz = _mm256_mul_ps(rx, rz), yz = _mm256_mul_ps(ry, rz);
+			txx = _mm256_fmadd_ps(ti, xx, txx);
+			tyy = _mm256_fmadd_ps(ti, yy, tyy);
+			txy = _mm256_fmadd_ps(ti, xy, txy);
+			txz = _mm256_fmadd_ps(ti, xz, txz);
+			tyz = _mm256_fmadd_ps(ti, yz, tyz);
+			_mm256_storeu_ps(tidal_xx + j, _mm256_fmadd_ps(tj, xx, _mm256_loadu_ps(tidal_xx + j)));
+			_mm256_storeu_ps(tidal_yy + j, _mm256_fmadd_ps(tj, yy, _mm256_loadu_ps(tidal_yy + j)));
+			_mm256_storeu_ps(tidal_xy + j, _mm256_fmadd_ps(tj, xy, _mm256_loadu_ps(tidal_xy + j)));
+			_mm256_storeu_ps(tidal_xz + j, _mm256_fmadd_ps(tj, xz, _mm256_loadu_ps(tidal_xz + j)));
+			_mm256_storeu_ps(tidal_yz + j, _mm256_fmadd_ps(tj, yz, _mm256_loadu_ps(tidal_yz + j)));
+
+			offset = _mm256_add_epi32(offset, step);
+		}
+		force_x[i] += horizontal_sum(fx); force_y[i] += horizontal_sum(fy); force_z[i] += horizontal_sum(fz);
+		tidal_xx[i] += horizontal_sum(txx); tidal_yy[i] += horizontal_sum(tyy);
+		tidal_xy[i] += horizontal_sum(txy); tidal_xz[i] += horizontal_sum(txz); tidal_yz[i] += horizontal_sum(tyz);
+	}
+}
+
+void tracer_kernel_avx2(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az) {
+	const __m256 epsilon = _mm256_set1_ps(EPSILON);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 inv_sqrt_epsilon = _mm256_div_ps(one, _mm256_sqrt_ps(epsilon));
+	for (unsigned int i = 0; i < count; i += 8) {
+		const __m256 px = _mm256_loadu_ps(x + i);
+		const __m256 py = _mm256_loadu_ps(y + i);
+		const __m256 pz = _mm256_loadu_ps(z + i);
+		__m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps(), sz = _mm256_setzero_ps();
+		// Sources are broadcast one at a time, the lanes hold consecutive tracers
+		for (unsigned int j = 0; j < sources.count; ++j) {
+			const __m256 rx = _mm256_sub_ps(_mm256_broadcast_ss(sources.x + j), px);
+			const __m256 ry = _mm256_sub_ps(_mm256_broadcast_ss(sources.y + j), py);
+			const __m256 rz = _mm256_sub_ps(_mm256_broadcast_ss(sources.z + j), pz);
+			const __m256 r2 = _mm256_fmadd_ps(rx, rx, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rz, rz)));
+			const __m256 inv_length = _mm256_div_ps(one, _mm256_sqrt_ps(r2));
+			const __m256 inv_r = _mm256_blendv_ps(inv_length, inv_sqrt_epsilon, _mm256_cmp_ps(r2, epsilon, _CMP_LT_OQ));
+			const __m256 a = _mm256_and_ps(_mm256_cmp_ps(r2, zero, _CMP_GT_OQ),
+				_mm256_mul_ps(_mm256_broadcast_ss(sources.mu + j), _mm256_mul_ps(_mm256_mul_ps(inv_r, inv_r), inv_length)));
+			sx = _mm256_fmadd_ps(a, rx, sx);
+			sy = _mm256_fmadd_ps(a, ry, sy);
+			sz = _mm256_fmadd_ps(a, rz, sz);
+		}
+		_mm256_storeu_ps(ax + i, sx);
+		_mm256_storeu_ps(ay + i, sy);
+		_mm256_storeu_ps(az + i, sz);
+	}
+}
+
+// Natural logarithm of positive normal floats, Cephes logf: the mantissa is brought to [sqrt(1/2), sqrt(2)) and the
+// logarithm of 1 + m follows from a polynomial
+static inline __m256 log_ps(const __m256 x) {
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256i bits = _mm256_castps_si256(x);
+	__m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+	const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+	exponent = _mm256_sub_ps(exponent, _mm256_and_ps(small, one));
+	m = _mm256_add_ps(_mm256_sub_ps(m, one), _mm256_and_ps(small, m));
+	const __m256 z = _mm256_mul_ps(m, m);
+	__m256 p = _mm256_set1_ps(7.0376836292e-2f);
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.1514610310e-1f));
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(1.1676998740e-1f));
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.2420140846e-1f));
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(1.4249322787e-1f));
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.6668057665e-1f));
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(2.0000714765e-1f));
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-2.4999993993e-1f));
+	p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(3.3333331174e-1f));
+	__m256 y = _mm256_mul_ps(_mm256_mul_ps(p, m), z);
+	y = _mm256_fmadd_ps(exponent, _mm256_set1_ps(-2.12194440e-4f), y);
+	y = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, y);
+	return _mm256_fmadd_ps(exponent, _mm256_set1_ps(0.693359375f), _mm256_add_ps(m, y));
+}
+
+// Four quadrant arctangent, Cephes atanf on the ratio of the smaller to the larger magnitude, then unfolded
+static inline __m256 atan2_ps(const __m256 y, const __m256 x) {
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 abs_y = _mm256_andnot_ps(sign, y), abs_x = _mm256_andnot_ps(sign, x);
+	const __m256 larger = _mm256_max_ps(abs_y, abs_x);
+	const __m256 a = _mm256_and_ps(_mm256_cmp_ps(larger, _mm256_setzero_ps(), _CMP_GT_OQ),
+		_mm256_div_ps(_mm256_min_ps(abs_y, abs_x), larger));
+	const __m256 reduce = _mm256_cmp_ps(a, _mm256_set1_ps(0.414213562373095f), _CMP_GT_OQ);
+	const __m256 t = _mm256_blendv_ps(a, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), reduce);
+	const __m256 z = _mm256_mul_ps(t, t);
+	__m256 p = _mm256_set1_ps(8.05374449538e-2f);
+	p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(-1.38776856032e-1f));
+	p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(1.99777106478e-1f));
+	p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(-3.33329491539e-1f));
+	__m256 r = _mm256_add_ps(_mm256_and_ps(reduce, _mm256_set1_ps(0.785398163397448f)), _mm256_fmadd_ps(_mm256_mul_ps(p, z), t, t));
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.57079632679490f), r), _mm256_cmp_ps(abs_y, abs_x, _CMP_GT_OQ));
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(3.14159265358979f), r), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+	return _mm256_or_ps(r, _mm256_and_ps(sign, y));
+}
+
+void polyhedron_kernel_avx2(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 tiny = _mm256_set1_ps(1e-30f);
+	for (unsigned int i = 0; i < count; i += 8) {
+		const __m256 px = _mm256_loadu_ps(x + i);
+		const __m256 py = _mm256_loadu_ps(y + i);
+		const __m256 pz = _mm256_loadu_ps(z + i);
+		// Offset from the points to every vertex and its length, shared by the edges and faces around the vertex
+		for (unsigned int v = 0; v < polyhedron.vertex_count; ++v) {
+			float* offset = scratch + v * 32;
+			const __m256 rx = _mm256_sub_ps(_mm256_broadcast_ss(polyhedron.vertex_x + v), px);
+			const __m256 ry = _mm256_sub_ps(_mm256_broadcast_ss(polyhedron.vertex_y + v), py);
+			const __m256 rz = _mm256_sub_ps(_mm256_broadcast_ss(polyhedron.vertex_z + v), pz);
+			_mm256_storeu_ps(offset, rx);
+			_mm256_storeu_ps(offset + 8, ry);
+			_mm256_storeu_ps(offset + 16, rz);
+			_mm256_storeu_ps(offset + 24, _mm256_sqrt_ps(_mm256_fmadd_ps(rx, rx, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rz, rz)))));
+		}
+
+		__m256 ex = _mm256_setzero_ps(), ey = _mm256_setzero_ps(), ez = _mm256_setzero_ps();
+		for (unsigned int e = 0; e < polyhedron.edge_count; ++e) {
+			const PolyhedronEdge& edge = polyhedron.edges[e];
+			const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(scratch + edge.first * 32 + 24), _mm256_loadu_ps(scratch + edge.second * 32 + 24));
+			const __m256 length = _mm256_set1_ps(edge.length);
+			const __m256 difference = _mm256_sub_ps(sum, length);
+			const __m256 factor = _mm256_and_ps(_mm256_cmp_ps(difference, zero, _CMP_GT_OQ),
+				log_ps(_mm256_div_ps(_mm256_add_ps(sum, length), _mm256_max_ps(difference, tiny))));
+			const __m256 d0 = _mm256_set1_ps(edge.dyad[0]), d1 = _mm256_set1_ps(edge.dyad[1]), d2 = _mm256_set1_ps(edge.dyad[2]);
+			const __m256 d3 = _mm256_set1_ps(edge.dyad[3]), d4 = _mm256_set1_ps(edge.dyad[4]), d5 = _mm256_set1_ps(edge.dyad[5]);
+			// E r_e = E (first - p)
+			const __m256 rx = _mm256_sub_ps(_mm256_set1_ps(edge.dyad_first[0]), _mm256_fmadd_ps(d0, px, _mm256_fmadd_ps(d3, py, _mm256_mul_ps(d4, pz))));
+			const __m256 ry = _mm256_sub_ps(_mm256_set1_ps(edge.dyad_first[1]), _mm256_fmadd_ps(d3, px, _mm256_fmadd_ps(d1, py, _mm256_mul_ps(d5, pz))));
+			const __m256 rz = _mm256_sub_ps(_mm256_set1_ps(edge.dyad_first[2]), _mm256_fmadd_ps(d4, px, _mm256_fmadd_ps(d5, py, _mm256_mul_ps(d2, pz))));
+			ex = _mm256_fmadd_ps(factor, rx, ex);
+			ey = _mm256_fmadd_ps(factor, ry, ey);
+			ez = _mm256_fmadd_ps(factor, rz, ez);
+		}
+
+		__m256 fx = _mm256_setzero_ps(), fy = _mm256_setzero_ps(), fz = _mm256_setzero_ps();
+		for (unsigned int f = 0; f < polyhedron.face_count; ++f) {
+			const PolyhedronFace& face = polyhedron.faces[f];
+			const float* r1 = scratch + face.vertices[0] * 32;
+			const float* r2 = scratch + face.vertices[1] * 32;
+			const float* r3 = scratch + face.vertices[2] * 32;
+			const __m256 x1 = _mm256_loadu_ps(r1), y1 = _mm256_loadu_ps(r1 + 8), z1 = _mm256_loadu_ps(r1 + 16), l1 = _mm256_loadu_ps(r1 + 24);
+			const __m256 x2 = _mm256_loadu_ps(r2), y2 = _mm256_loadu_ps(r2 + 8), z2 = _mm256_loadu_ps(r2 + 16), l2 = _mm256_loadu_ps(r2 + 24);
+			const __m256 x3 = _mm256_loadu_ps(r3), y3 = _mm256_loadu_ps(r3 + 8), z3 = _mm256_loadu_ps(r3 + 16), l3 = _mm256_loadu_ps(r3 + 24);
+			// Solid angle: tan(omega / 2) = r1 . (r2 x r3) / (l1 l2 l3 + l1 r2.r3 + l2 r3.r1 + l3 r1.r2)
+			const __m256 cx = _mm256_fmsub_ps(y2, z3, _mm256_mul_ps(z2, y3));
+			const __m256 cy = _mm256_fmsub_ps(z2, x3, _mm256_mul_ps(x2, z3));
+			const __m256 cz = _mm256_fmsub_ps(x2, y3, _mm256_mul_ps(y2, x3));
+			const __m256 numerator = _mm256_fmadd_ps(x1, cx, _mm256_fmadd_ps(y1, cy, _mm256_mul_ps(z1, cz)));
+			const __m256 d23 = _mm256_fmadd_ps(x2, x3, _mm256_fmadd_ps(y2, y3, _mm256_mul_ps(z2, z3)));
+			const __m256 d31 = _mm256_fmadd_ps(x3, x1, _mm256_fmadd_ps(y3, y1, _mm256_mul_ps(z3, z1)));
+			const __m256 d12 = _mm256_fmadd_ps(x1, x2, _mm256_fmadd_ps(y1, y2, _mm256_mul_ps(z1, z2)));
+			const __m256 denominator = _mm256_fmadd_ps(_mm256_mul_ps(l1, l2), l3,
+				_mm256_fmadd_ps(l1, d23, _mm256_fmadd_ps(l2, d31, _mm256_mul_ps(l3, d12))));
+			const __m256 omega = _mm256_mul_ps(two, atan2_ps(numerator, denominator));
+			const __m256 nx = _mm256_set1_ps(face.normal[0]), ny = _mm256_set1_ps(face.normal[1]), nz = _mm256_set1_ps(face.normal[2]);
+			// F r_f = n (offset - n . p)
+			const __m256 height = _mm256_sub_ps(_mm256_set1_ps(face.offset), _mm256_fmadd_ps(nx, px, _mm256_fmadd_ps(ny, py, _mm256_mul_ps(nz, pz))));
+			const __m256 w = _mm256_mul_ps(omega, height);
+			fx = _mm256_fmadd_ps(w, nx, fx);
+			fy = _mm256_fmadd_ps(w, ny, fy);
+			fz = _mm256_fmadd_ps(w, nz, fz);
+		}
+
+		const __m256 mu = _mm256_set1_ps(polyhedron.mu_density);
+		_mm256_storeu_ps(ax + i, _mm256_mul_ps(mu, _mm256_sub_ps(fx, ex)));
+		_mm256_storeu_ps(ay + i, _mm256_mul_ps(mu, _mm256_sub_ps(fy, ey)));
+		_mm256_storeu_ps(az + i, _mm256_mul_ps(mu, _mm256_sub_ps(fz, ez)));
+	}
+}
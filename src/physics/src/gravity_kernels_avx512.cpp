@@ -0,0 +1,288 @@
+#include <gravity/gravity_kernels.hpp>
+#include <immintrin.h>
+
+// Compiled with AVX-512F enabled. Only called after runtime detection confirmed support.
+
+void gravity_kernel_avx512(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]) {
+	const __m512 px = _mm512_set1_ps(target.position[0]);
+	const __m512 py = _mm512_set1_ps(target.position[1]);
+	const __m512 pz = _mm512_set1_ps(target.position[2]);
+	const __m512 mass = _mm512_set1_ps(target.mass);
+	const __m512 epsilon = _mm512_set1_ps(EPSILON);
+	const __m512 one = _mm512_set1_ps(1.0f);
+	const __m512 inv_sqrt_epsilon = _mm512_div_ps(one, _mm512_sqrt_ps(epsilon));
+	const __m512 three = _mm512_set1_ps(3.0f);
+	const float* w = target.world_inertia;
+	const __m512 w0 = _mm512_set1_ps(w[0]), w1 = _mm512_set1_ps(w[1]), w2 = _mm512_set1_ps(w[2]);
+	const __m512 w3 = _mm512_set1_ps(w[3]), w4 = _mm512_set1_ps(w[4]), w5 = _mm512_set1_ps(w[5]);
+	const __m512 w6 = _mm512_set1_ps(w[6]), w7 = _mm512_set1_ps(w[7]), w8 = _mm512_set1_ps(w[8]);
+	const __m512i skip = _mm512_set1_epi32(static_cast<int>(target.skip_index));
+	const __m512i count = _mm512_set1_epi32(static_cast<int>(sources.count));
+	const __m512i step = _mm512_set1_epi32(16);
+	__m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+	__m512 fx = _mm512_setzero_ps(), fy = _mm512_setzero_ps(), fz = _mm512_setzero_ps();
+	__m512 tx = _mm512_setzero_ps(), ty = _mm512_setzero_ps(), tz = _mm512_setzero_ps();
+	for (unsigned int j = 0; j < sources.padded_count; j += 16) {
+		const __m512 rx = _mm512_sub_ps(_mm512_loadu_ps(sources.x + j), px);
+		const __m512 ry = _mm512_sub_ps(_mm512_loadu_ps(sources.y + j), py);
+		const __m512 rz = _mm512_sub_ps(_mm512_loadu_ps(sources.z + j), pz);
+		const __m512 mu = _mm512_loadu_ps(sources.mu + j);
+		const __m512 r2 = _mm512_fmadd_ps(rx, rx, _mm512_fmadd_ps(ry, ry, _mm512_mul_ps(rz, rz)));
+		const __mmask16 valid = _mm512_cmpneq_epi32_mask(index, skip) & _mm512_cmplt_epi32_mask(index, count);
+
+		// The clamped inverse distance only differs from the real one inside EPSILON
+		const __m512 inv_length = _mm512_div_ps(one, _mm512_sqrt_ps(r2));
+		const __m512 inv_r = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(r2, epsilon, _CMP_LT_OQ), inv_length, inv_sqrt_epsilon);
+		const __m512 inv_r2 = _mm512_mul_ps(inv_r, inv_r);
+
+		const __m512 f = _mm512_mul_ps(_mm512_mul_ps(mass, mu), _mm512_mul_ps(inv_r2, inv_length));
+		fx = _mm512_mask3_fmadd_ps(f, rx, fx, valid);
+		fy = _mm512_mask3_fmadd_ps(f, ry, fy, valid);
+		fz = _mm512_mask3_fmadd_ps(f, rz, fz, valid);
+
+		const __m512 t = _mm512_mul_ps(_mm512_mul_ps(three, mu), _mm512_mul_ps(_mm512_mul_ps(inv_r2, inv_r2), inv_r));
+		const __m512 ix = _mm512_fmadd_ps(w0, rx, _mm512_fmadd_ps(w3, ry, _mm512_mul_ps(w6, rz)));
+		const __m512 iy = _mm512_fmadd_ps(w1, rx, _mm512_fmadd_ps(w4, ry, _mm512_mul_ps(w7, rz)));
+		const __m512 iz = _mm512_fmadd_ps(w2, rx, _mm512_fmadd_ps(w5, ry, _mm512_mul_ps(w8, rz)));
+		tx = _mm512_mask3_fmadd_ps(t, _mm512_fmsub_ps(ry, iz, _mm512_mul_ps(rz, iy)), tx, valid);
+		ty = _mm512_mask3_fmadd_ps(t, _mm512_fmsub_ps(rz, ix, _mm512_mul_ps(rx, iz)), ty, valid);
+		tz = _mm512_mask3_fmadd_ps(t, _mm512_fmsub_ps(rx, iy, _mm512_mul_ps(ry, ix)), tz, valid);
+
+		index = _mm512_add_epi32(index, step);
+	}
+	force[0] = _mm512_reduce_add_ps(fx); force[1] = _mm512_reduce_add_ps(fy); force[2] = _mm512_reduce_add_ps(fz);
+	torque[0] = _mm512_reduce_add_ps(tx); torque[1] = _mm512_reduce_add_ps(ty); torque[2] = _mm512_reduce_add_ps(tz);
+}
+
+void symmetric_gravity_kernel_avx512(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators) {
+	const __m512 epsilon = _mm512_set1_ps(EPSILON);
+	const __m512 one = _mm512_set1_ps(1.0f);
+	const __m512 inv_sqrt_epsilon = _mm512_div_ps(one, _mm512_sqrt_ps(epsilon));
+	const __m512 three_g = _mm512_set1_ps(3.0f * G);
+	const __m512i count = _mm512_set1_epi32(static_cast<int>(bodies.count));
+	const __m512i step = _mm512_set1_epi32(16);
+	// Kept in locals: stores through them could otherwise alias the accumulator struct and force reloads
+	float* const force_x = accumulators.force[0], * const force_y = accumulators.force[1], * const force_z = accumulators.force[2];
+	float* const tidal_xx = accumulators.tidal[0], * const tidal_yy = accumulators.tidal[1];
+	float* const tidal_xy = accumulators.tidal[2], * const tidal_xz = accumulators.tidal[3], * const tidal_yz = accumulators.tidal[4];
+	const unsigned int i_last = i_end < bodies.count ? i_end : bodies.count;
+	for (unsigned int i = i_begin; i < i_last; ++i) {
+		const __m512 px = _mm512_set1_ps(bodies.x[i]);
+		const __m512 py = _mm512_set1_ps(bodies.y[i]);
+		const __m512 pz = _mm512_set1_ps(bodies.z[i]);
+		const __m512 mass = _mm512_set1_ps(bodies.mass[i]);
+		const __m512 g_mass = _mm512_set1_ps(G * bodies.mass[i]);
+		const __m512i target = _mm512_set1_epi32(static_cast<int>(i));
+		// Starts at the vector holding i + 1, the lanes up to i are masked out
+		const unsigned int first = (i + 1) & ~15u;
+		const unsigned int j_start = first > j_begin ? first : j_begin;
+		__m512i index = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(j_start)),
+			_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+		__m512 fx = _mm512_setzero_ps(), fy = _mm512_setzero_ps(), fz = _mm512_setzero_ps();
+		__m512 txx = _mm512_setzero_ps(), tyy = _mm512_setzero_ps();
+		__m512 txy = _mm512_setzero_ps(), txz = _mm512_setzero_ps(), tyz = _mm512_setzero_ps();
+		for (unsigned int j = j_start; j < j_end; j += 16) {
+			const __m512 rx = _mm512_sub_ps(_mm512_loadu_ps(bodies.x + j), px);
+			const __m512 ry = _mm512_sub_ps(_mm512_loadu_ps(bodies.y + j), py);
+			const __m512 rz = _mm512_sub_ps(_mm512_loadu_ps(bodies.z + j), pz);
+			const __m512 other_mass = _mm512_loadu_ps(bodies.mass + j);
+			const __m512 r2 = _mm512_fmadd_ps(rx, rx, _mm512_fmadd_ps(ry, ry, _mm512_mul_ps(rz, rz)));
+			const __mmask16 valid = _mm512_cmpgt_epi32_mask(index, target) & _mm512_cmplt_epi32_mask(index, count);
+
+			// The clamped inverse distance only differs from the real one inside EPSILON
+			const __m512 inv_length = _mm512_div_ps(one, _mm512_sqrt_ps(r2));
+			const __m512 inv_r = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(r2, epsilon, _CMP_LT_OQ), inv_length, inv_sqrt_epsilon);
+			const __m512 inv_r2 = _mm512_mul_ps(inv_r, inv_r);
+
+			// Force on i, j gets the opposite
+			const __m512 f = _mm512_maskz_mul_ps(valid, _mm512_mul_ps(g_mass, other_mass), _mm512_mul_ps(inv_r2, inv_length));
+			fx = _mm512_fmadd_ps(f, rx, fx);
+			fy = _mm512_fmadd_ps(f, ry, fy);
+			fz = _mm512_fmadd_ps(f, rz, fz);
+			_mm512_storeu_ps(force_x + j, _mm512_fnmadd_ps(f, rx, _mm512_loadu_ps(force_x + j)));
+			_mm512_storeu_ps(force_y + j, _mm512_fnmadd_ps(f, ry, _mm512_loadu_ps(force_y + j)));
+			_mm512_storeu_ps(force_z + j, _mm512_fnmadd_ps(f, rz, _mm512_loadu_ps(force_z + j)));
+
+			// The tidal term is even in r, so both bodies share r r^T and the 3G / r^5 factor
+			const __m512 t = _mm512_maskz_mul_ps(valid, three_g, _mm512_mul_ps(_mm512_mul_ps(inv_r2, inv_r2), inv_r));
+			const __m512 ti = _mm512_mul_ps(t, other_mass);
+			const __m512 tj = _mm512_mul_ps(t, mass);
+			const __m512 zz = _mm512_mul_ps(rz, rz);
+			const __m512 xx = _mm512_fmsub_ps(rx, rx, zz), yy = _mm512_fmsub_ps(ry, ry, zz);
+			const __m512 xy = _mm512_mul_ps(rx, ry), xz = _mm512_mul_ps(rx, rz), yz = _mm512_mul_ps(ry, rz);
+			txx = _mm512_fmadd_ps(ti, xx, txx);
+			tyy = _mm512_fmadd_ps(ti, yy, tyy);
+			txy = _mm512_fmadd_ps(ti, xy, txy);
+			txz = _mm512_fmadd_ps(ti, xz, txz);
+			tyz = _mm512_fmadd_ps(ti, yz, tyz);
+			_mm512_storeu_ps(tidal_xx + j, _mm512_fmadd_ps(tj, xx, _mm512_loadu_ps(tidal_xx + j)));
+			_mm512_storeu_ps(tidal_yy + j, _mm512_fmadd_ps(tj, yy, _mm512_loadu_ps(tidal_yy + j)));
+			_mm512_storeu_ps(tidal_xy + j, _mm512_fmadd_ps(tj, xy, _mm512_loadu_ps(tidal_xy + j)));
+			_mm512_storeu_ps(tidal_xz + j, _mm512_fmadd_ps(tj, xz, _mm512_loadu_ps(tidal_xz + j)));
+			_mm512_storeu_ps(tidal_yz + j, _mm512_fmadd_ps(tj, yz, _mm512_loadu_ps(tidal_yz + j)));
+
+			index = _mm512_add_epi32(index, step);
+		}
+		force_x[i] += _mm512_reduce_add_ps(fx); force_y[i] += _mm512_reduce_add_ps(fy); force_z[i] += _mm512_reduce_add_ps(fz);
+		tidal_xx[i] += _mm512_reduce_add_ps(txx); tidal_yy[i] += _mm512_reduce_add_ps(tyy);
+		tidal_xy[i] += _mm512_reduce_add_ps(txy); tidal_xz[i] += _mm512_reduce_add_ps(txz); tidal_yz[i] += _mm512_reduce_add_ps(tyz);
+	}
+}
+
+void tracer_kernel_avx512(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az) {
+	const __m512 epsilon = _mm512_set1_ps(EPSILON);
+	const __m512 one = _mm512_set1_ps(1.0f);
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512 inv_sqrt_epsilon = _mm512_div_ps(one, _mm512_sqrt_ps(epsilon));
+	for (unsigned int i = 0; i < count; i += 16) {
+		const __m512 px = _mm512_loadu_ps(x + i);
+		const __m512 py = _mm512_loadu_ps(y + i);
+		const __m512 pz = _mm512_loadu_ps(z + i);
+		__m512 sx = _mm512_setzero_ps(), sy = _mm512_setzero_ps(), sz = _mm512_setzero_ps();
+		// Sources are broadcast one at a time, the lanes hold consecutive tracers
+		for (unsigned int j = 0; j < sources.count; ++j) {
+			const __m512 rx = _mm512_sub_ps(_mm512_set1_ps(sources.x[j]), px);
+			const __m512 ry = _mm512_sub_ps(_mm512_set1_ps(sources.y[j]), py);
+			const __m512 rz = _mm512_sub_ps(_mm512_set1_ps(sources.z[j]), pz);
+			const __m512 r2 = _mm512_fmadd_ps(rx, rx, _mm512_fmadd_ps(ry, ry, _mm512_mul_ps(rz, rz)));
+			const __mmask16 valid = _mm512_cmp_ps_mask(r2, zero, _CMP_GT_OQ);
+			const __m512 inv_length = _mm512_div_ps(one, _mm512_sqrt_ps(r2));
+			const __m512 inv_r = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(r2, epsilon, _CMP_LT_OQ), inv_length, inv_sqrt_epsilon);
+			const __m512 a = _mm512_mul_ps(_mm512_set1_ps(sources.mu[j]), _mm512_mul_ps(_mm512_mul_ps(inv_r, inv_r), inv_length));
+			sx = _mm512_mask3_fmadd_ps(a, rx, sx, valid);
+			sy = _mm512_mask3_fmadd_ps(a, ry, sy, valid);
+			sz = _mm512_mask3_fmadd_ps(a, rz, sz, valid);
+		}
+		_mm512_storeu_ps(ax + i, sx);
+		_mm512_storeu_ps(ay + i, sy);
+		_mm512_storeu_ps(az + i, sz);
+	}
+}
+
+// Natural logarithm of positive normal floats, Cephes logf: the mantissa is brought to [sqrt(1/2), sqrt(2)) and the
+// logarithm of 1 + m follows from a polynomial
+static inline __m512 log_ps(const __m512 x) {
+	const __m512 one = _mm512_set1_ps(1.0f);
+	const __m512i bits = _mm512_castps_si512(x);
+	__m512 exponent = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(126)));
+	__m512 m = _mm512_castsi512_ps(_mm512_or_epi32(_mm512_and_epi32(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f000000)));
+	const __mmask16 small = _mm512_cmp_ps_mask(m, _mm512_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+	exponent = _mm512_mask_sub_ps(exponent, small, exponent, one);
+	m = _mm512_mask_add_ps(_mm512_sub_ps(m, one), small, _mm512_sub_ps(m, one), m);
+	const __m512 z = _mm512_mul_ps(m, m);
+	__m512 p = _mm512_set1_ps(7.0376836292e-2f);
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(-1.1514610310e-1f));
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(1.1676998740e-1f));
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(-1.2420140846e-1f));
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(1.4249322787e-1f));
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(-1.6668057665e-1f));
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(2.0000714765e-1f));
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(-2.4999993993e-1f));
+	p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(3.3333331174e-1f));
+	__m512 y = _mm512_mul_ps(_mm512_mul_ps(p, m), z);
+	y = _mm512_fmadd_ps(exponent, _mm512_set1_ps(-2.12194440e-4f), y);
+	y = _mm512_fnmadd_ps(_mm512_set1_ps(0.5f), z, y);
+	return _mm512_fmadd_ps(exponent, _mm512_set1_ps(0.693359375f), _mm512_add_ps(m, y));
+}
+
+// Four quadrant arctangent, Cephes atanf on the ratio of the smaller to the larger magnitude, then unfolded
+static inline __m512 atan2_ps(const __m512 y, const __m512 x) {
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512 one = _mm512_set1_ps(1.0f);
+	const __m512 abs_y = _mm512_abs_ps(y), abs_x = _mm512_abs_ps(x);
+	const __m512 larger = _mm512_max_ps(abs_y, abs_x);
+	const __m512 a = _mm512_maskz_div_ps(_mm512_cmp_ps_mask(larger, zero, _CMP_GT_OQ), _mm512_min_ps(abs_y, abs_x), larger);
+	const __mmask16 reduce = _mm512_cmp_ps_mask(a, _mm512_set1_ps(0.414213562373095f), _CMP_GT_OQ);
+	const __m512 t = _mm512_mask_div_ps(a, reduce, _mm512_sub_ps(a, one), _mm512_add_ps(a, one));
+	const __m512 z = _mm512_mul_ps(t, t);
+	__m512 p = _mm512_set1_ps(8.05374449538e-2f);
+	p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(-1.38776856032e-1f));
+	p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(1.99777106478e-1f));
+	p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(-3.33329491539e-1f));
+	__m512 r = _mm512_fmadd_ps(_mm512_mul_ps(p, z), t, t);
+	r = _mm512_mask_add_ps(r, reduce, r, _mm512_set1_ps(0.785398163397448f));
+	r = _mm512_mask_sub_ps(r, _mm512_cmp_ps_mask(abs_y, abs_x, _CMP_GT_OQ), _mm512_set1_ps(1.57079632679490f), r);
+	r = _mm512_mask_sub_ps(r, _mm512_cmp_ps_mask(x, zero, _CMP_LT_OQ), _mm512_set1_ps(3.14159265358979f), r);
+	const __m512i sign = _mm512_and_epi32(_mm512_castps_si512(y), _mm512_set1_epi32(static_cast<int>(0x80000000u)));
+	return _mm512_castsi512_ps(_mm512_or_epi32(_mm512_castps_si512(r), sign));
+}
+
+void polyhedron_kernel_avx512(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az) {
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512 two = _mm512_set1_ps(2.0f);
+	const __m512 tiny = _mm512_set1_ps(1e-30f);
+	for (unsigned int i = 0; i < count; i += 16) {
+		const __m512 px = _mm512_loadu_ps(x + i);
+		const __m512 py = _mm512_loadu_ps(y + i);
+		const __m512 pz = _mm512_loadu_ps(z + i);
+		// Offset from the points to every vertex and its length, shared by the edges and faces around the vertex
+		for (unsigned int v = 0; v < polyhedron.vertex_count; ++v) {
+			float* offset = scratch + v * 64;
+			const __m512 rx = _mm512_sub_ps(_mm512_set1_ps(polyhedron.vertex_x[v]), px);
+			const __m512 ry = _mm512_sub_ps(_mm512_set1_ps(polyhedron.vertex_y[v]), py);
+			const __m512 rz = _mm512_sub_ps(_mm512_set1_ps(polyhedron.vertex_z[v]), pz);
+			_mm512_storeu_ps(offset, rx);
+			_mm512_storeu_ps(offset + 16, ry);
+			_mm512_storeu_ps(offset + 32, rz);
+			_mm512_storeu_ps(offset + 48, _mm512_sqrt_ps(_mm512_fmadd_ps(rx, rx, _mm512_fmadd_ps(ry, ry, _mm512_mul_ps(rz, rz)))));
+		}
+
+		__m512 ex = _mm512_setzero_ps(), ey = _mm512_setzero_ps(), ez = _mm512_setzero_ps();
+		for (unsigned int e = 0; e < polyhedron.edge_count; ++e) {
+			const PolyhedronEdge& edge = polyhedron.edges[e];
+			const __m512 sum = _mm512_add_ps(_mm512_loadu_ps(scratch + edge.first * 64 + 48), _mm512_loadu_ps(scratch + edge.second * 64 + 48));
+			const __m512 length = _mm512_set1_ps(edge.length);
+			const __m512 difference = _mm512_sub_ps(sum, length);
+			const __mmask16 valid = _mm512_cmp_ps_mask(difference, zero, _CMP_GT_OQ);
+			const __m512 factor = log_ps(_mm512_div_ps(_mm512_add_ps(sum, length), _mm512_max_ps(difference, tiny)));
+			const __m512 d0 = _mm512_set1_ps(edge.dyad[0]), d1 = _mm512_set1_ps(edge.dyad[1]), d2 = _mm512_set1_ps(edge.dyad[2]);
+			const __m512 d3 = _mm512_set1_ps(edge.dyad[3]), d4 = _mm512_set1_ps(edge.dyad[4]), d5 = _mm512_set1_ps(edge.dyad[5]);
+			// E r_e = E (first - p)
+			const __m512 rx = _mm512_sub_ps(_mm512_set1_ps(edge.dyad_first[0]), _mm512_fmadd_ps(d0, px, _mm512_fmadd_ps(d3, py, _mm512_mul_ps(d4, pz))));
+			const __m512 ry = _mm512_sub_ps(_mm512_set1_ps(edge.dyad_first[1]), _mm512_fmadd_ps(d3, px, _mm512_fmadd_ps(d1, py, _mm512_mul_ps(d5, pz))));
+			const __m512 rz = _mm512_sub_ps(_mm512_set1_ps(edge.dyad_first[2]), _mm512_fmadd_ps(d4, px, _mm512_fmadd_ps(d5, py, _mm512_mul_ps(d2, pz))));
+			ex = _mm512_mask3_fmadd_ps(factor, rx, ex, valid);
+			ey = _mm512_mask3_fmadd_ps(factor, ry, ey, valid);
+			ez = _mm512_mask3_fmadd_ps(factor, rz, ez, valid);
+		}
+
+		__m512 fx = _mm512_setzero_ps(), fy = _mm512_setzero_ps(), fz = _mm512_setzero_ps();
+		for (unsigned int f = 0; f < polyhedron.face_count; ++f) {
+			const PolyhedronFace& face = polyhedron.faces[f];
+			const float* r1 = scratch + face.vertices[0] * 64;
+			const float* r2 = scratch + face.vertices[1] * 64;
+			const float* r3 = scratch + face.vertices[2] * 64;
+			const __m512 x1 = _mm512_loadu_ps(r1), y1 = _mm512_loadu_ps(r1 + 16), z1 = _mm512_loadu_ps(r1 + 32), l1 = _mm512_loadu_ps(r1 + 48);
+			const __m512 x2 = _mm512_loadu_ps(r2), y2 = _mm512_loadu_ps(r2 + 16), z2 = _mm512_loadu_ps(r2 + 32), l2 = _mm512_loadu_ps(r2 + 48);
+			const __m512 x3 = _mm512_loadu_ps(r3), y3 = _mm512_loadu_ps(r3 + 16), z3 = _mm512_loadu_ps(r3 + 32), l3 = _mm512_loadu_ps(r3 + 48);
+			// Solid angle: tan(omega / 2) = r1 . (r2 x r3) / (l1 l2 l3 + l1 r2.r3 + l2 r3.r1 + l3 r1.r2)
+			const __m512 cx = _mm512_fmsub_ps(y2, z3, _mm512_mul_ps(z2, y3));
+			const __m512 cy = _mm512_fmsub_ps(z2, x3, _mm512_mul_ps(x2, z3));
+			const __m512 cz = _mm512_fmsub_ps(x2, y3, _mm512_mul_ps(y2, x3));
+			const __m512 numerator = _mm512_fmadd_ps(x1, cx, _mm512_fmadd_ps(y1, cy, _mm512_mul_ps(z1, cz)));
+			const __m512 d23 = _mm512_fmadd_ps(x2, x3, _mm512_fmadd_ps(y2, y3, _mm512_mul_ps(z2, z3)));
+			const __m512 d31 = _mm512_fmadd_ps(x3, x1, _mm512_fmadd_ps(y3, y1, _mm512_mul_ps(z3, z1)));
+			const __m512 d12 = _mm512_fmadd_ps(x1, x2, _mm512_fmadd_ps(y1, y2, _mm512_mul_ps(z1, z2)));
+			const __m512 denominator = _mm512_fmadd_ps(_mm512_mul_ps(l1, l2), l3,
+				_mm512_fmadd_ps(l1, d23, _mm512_fmadd_ps(l2, d31, _mm512_mul_ps(l3, d12))));
+			const __m512 omega = _mm512_mul_ps(two, atan2_ps(numerator, denominator));
+			const __m512 nx = _mm512_set1_ps(face.normal[0]), ny = _mm512_set1_ps(face.normal[1]), nz = _mm512_set1_ps(face.normal[2]);
+			// F r_f = n (offset - n . p)
+			const __m512 height = _mm512_sub_ps(_mm512_set1_ps(face.offset), _mm512_fmadd_ps(nx, px, _mm512_fmadd_ps(ny, py, _mm512_mul_ps(nz, pz))));
+			const __m512 w = _mm512_mul_ps(omega, height);
+			fx = _mm512_fmadd_ps(w, nx, fx);
+			fy = _mm512_fmadd_ps(w, ny, fy);
+			fz = _mm512_fmadd_ps(w, nz, fz);
+		}
+
+		const __m512 mu = _mm512_set1_ps(polyhedron.mu_density);
+		_mm512_storeu_ps(ax + i, _mm512_mul_ps(mu, _mm512_sub_ps(fx, ex)));
+		_mm512_storeu_ps(ay + i, _mm512_mul_ps(mu, _mm512_sub_ps(fy, ey)));
+		_mm512_storeu_ps(az + i, _mm512_mul_ps(mu, _mm512_sub_ps(fz, ez)));
+	}
+}
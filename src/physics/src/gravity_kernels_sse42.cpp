@@ -0,0 +1,292 @@
+#include <gravity/gravity_kernels.hpp>
+#include <immintrin.h>
+
+// Compiled with SSE4.2 enabled. Only called after runtime detection confirmed support.
+
+static inline float horizontal_sum(const __m128 v) {
+	const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 0x55)));
+}
+
+void gravity_kernel_sse42(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]) {
+	const __m128 px = _mm_set1_ps(target.position[0]);
+	const __m128 py = _mm_set1_ps(target.position[1]);
+	const __m128 pz = _mm_set1_ps(target.position[2]);
+	const __m128 mass = _mm_set1_ps(target.mass);
+	const __m128 epsilon = _mm_set1_ps(EPSILON);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 inv_sqrt_epsilon = _mm_div_ps(one, _mm_sqrt_ps(epsilon));
+	const __m128 three = _mm_set1_ps(3.0f);
+	const float* w = target.world_inertia;
+	const __m128 w0 = _mm_set1_ps(w[0]), w1 = _mm_set1_ps(w[1]), w2 = _mm_set1_ps(w[2]);
+	const __m128 w3 = _mm_set1_ps(w[3]), w4 = _mm_set1_ps(w[4]), w5 = _mm_set1_ps(w[5]);
+	const __m128 w6 = _mm_set1_ps(w[6]), w7 = _mm_set1_ps(w[7]), w8 = _mm_set1_ps(w[8]);
+	const __m128i skip = _mm_set1_epi32(static_cast<int>(target.skip_index));
+	const __m128i count = _mm_set1_epi32(static_cast<int>(sources.count));
+	const __m128i step = _mm_set1_epi32(4);
+	__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+	__m128 fx = _mm_setzero_ps(), fy = _mm_setzero_ps(), fz = _mm_setzero_ps();
+	__m128 tx = _mm_setzero_ps(), ty = _mm_setzero_ps(), tz = _mm_setzero_ps();
+	for (unsigned int j = 0; j < sources.padded_count; j += 4) {
+		const __m128 rx = _mm_sub_ps(_mm_loadu_ps(sources.x + j), px);
+		const __m128 ry = _mm_sub_ps(_mm_loadu_ps(sources.y + j), py);
+		const __m128 rz = _mm_sub_ps(_mm_loadu_ps(sources.z + j), pz);
+		const __m128 mu = _mm_loadu_ps(sources.mu + j);
+		const __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+		const __m128 valid = _mm_castsi128_ps(_mm_andnot_si128(_mm_cmpeq_epi32(index, skip), _mm_cmpgt_epi32(count, index)));
+
+		// The clamped inverse distance only differs from the real one inside EPSILON
+		const __m128 inv_length = _mm_div_ps(one, _mm_sqrt_ps(r2));
+		const __m128 inv_r = _mm_blendv_ps(inv_length, inv_sqrt_epsilon, _mm_cmplt_ps(r2, epsilon));
+		const __m128 inv_r2 = _mm_mul_ps(inv_r, inv_r);
+
+		const __m128 f = _mm_and_ps(valid, _mm_mul_ps(_mm_mul_ps(mass, mu), _mm_mul_ps(inv_r2, inv_length)));
+		fx = _mm_add_ps(fx, _mm_mul_ps(f, rx));
+		fy = _mm_add_ps(fy, _mm_mul_ps(f, ry));
+		fz = _mm_add_ps(fz, _mm_mul_ps(f, rz));
+
+		const __m128 t = _mm_and_ps(valid, _mm_mul_ps(_mm_mul_ps(three, mu), _mm_mul_ps(_mm_mul_ps(inv_r2, inv_r2), inv_r)));
+		const __m128 ix = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, rx), _mm_mul_ps(w3, ry)), _mm_mul_ps(w6, rz));
+		const __m128 iy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, rx), _mm_mul_ps(w4, ry)), _mm_mul_ps(w7, rz));
+		const __m128 iz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w2, rx), _mm_mul_ps(w5, ry)), _mm_mul_ps(w8, rz));
+		tx = _mm_add_ps(tx, _mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(ry, iz), _mm_mul_ps(rz, iy))));
+		ty = _mm_add_ps(ty, _mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(rz, ix), _mm_mul_ps(rx, iz))));
+		tz = _mm_add_ps(tz, _mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(rx, iy), _mm_mul_ps(ry, ix))));
+
+		index = _mm_add_epi32(index, step);
+	}
+	force[0] = horizontal_sum(fx); force[1] = horizontal_sum(fy); force[2] = horizontal_sum(fz);
+	torque[0] = horizontal_sum(tx); torque[1] = horizontal_sum(ty); torque[2] = horizontal_sum(tz);
+}
+
+void symmetric_gravity_kernel_sse42(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators) {
+	const __m128 epsilon = _mm_set1_ps(EPSILON);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 inv_sqrt_epsilon = _mm_div_ps(one, _mm_sqrt_ps(epsilon));
+	const __m128 three_g = _mm_set1_ps(3.0f * G);
+	const __m128i step = _mm_set1_epi32(4);
+	// Kept in locals: stores through them could otherwise alias the accumulator struct and force reloads
+	float* const force_x = accumulators.force[0], * const force_y = accumulators.force[1], * const force_z = accumulators.force[2];
+	float* const tidal_xx = accumulators.tidal[0], * const tidal_yy = accumulators.tidal[1];
+	float* const tidal_xy = accumulators.tidal[2], * const tidal_xz = accumulators.tidal[3], * const tidal_yz = accumulators.tidal[4];
+	const unsigned int i_last = i_end < bodies.count ? i_end : bodies.count;
+	for (unsigned int i = i_begin; i < i_last; ++i) {
+		const __m128 px = _mm_set1_ps(bodies.x[i]);
+		const __m128 py = _mm_set1_ps(bodies.y[i]);
+		const __m128 pz = _mm_set1_ps(bodies.z[i]);
+		const __m128 mass = _mm_set1_ps(bodies.mass[i]);
+		const __m128 g_mass = _mm_set1_ps(G * bodies.mass[i]);
+		// Starts at the vector holding i + 1. Lanes are valid when i < j < count, that is when j - i - 1 < count - i - 1
+		// as unsigned numbers: flipping the sign bit of both sides turns this into a single signed comparison
+		const unsigned int first = (i + 1) & ~3u;
+		const unsigned int j_start = first > j_begin ? first : j_begin;
+		const __m128i bound = _mm_set1_epi32(static_cast<int>((bodies.count - i - 1) ^ 0x80000000u));
+		__m128i offset = _mm_add_epi32(_mm_set1_epi32(static_cast<int>((j_start - i - 1) ^ 0x80000000u)), _mm_setr_epi32(0, 1, 2, 3));
+
+		__m128 fx = _mm_setzero_ps(), fy = _mm_setzero_ps(), fz = _mm_setzero_ps();
+		__m128 txx = _mm_setzero_ps(), tyy = _mm_setzero_ps();
+		__m128 txy = _mm_setzero_ps(), txz = _mm_setzero_ps(), tyz = _mm_setzero_ps();
+		for (unsigned int j = j_start; j < j_end; j += 4) {
+			const __m128 rx = _mm_sub_ps(_mm_loadu_ps(bodies.x + j), px);
+			const __m128 ry = _mm_sub_ps(_mm_loadu_ps(bodies.y + j), py);
+			const __m128 rz = _mm_sub_ps(_mm_loadu_ps(bodies.z + j), pz);
+			const __m128 other_mass = _mm_loadu_ps(bodies.mass + j);
+			const __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+			const __m128 valid = _mm_castsi128_ps(_mm_cmpgt_epi32(bound, offset));
+
+			// The clamped inverse distance only differs from the real one inside EPSILON
+			const __m128 inv_length = _mm_div_ps(one, _mm_sqrt_ps(r2));
+			const __m128 inv_r = _mm_blendv_ps(inv_length, inv_sqrt_epsilon, _mm_cmplt_ps(r2, epsilon));
+			const __m128 inv_r2 = _mm_mul_ps(inv_r, inv_r);
+
+			// Force on i, j gets the opposite
+			const __m128 f = _mm_and_ps(valid, _mm_mul_ps(_mm_mul_ps(g_mass, other_mass), _mm_mul_ps(inv_r2, inv_length)));
+			const __m128 pair_x = _mm_mul_ps(f, rx), pair_y = _mm_mul_ps(f, ry), pair_z = _mm_mul_ps(f, rz);
+			fx = _mm_add_ps(fx, pair_x);
+			fy = _mm_add_ps(fy, pair_y);
+			fz = _mm_add_ps(fz, pair_z);
+			_mm_storeu_ps(force_x + j, _mm_sub_ps(_mm_loadu_ps(force_x + j), pair_x));
+			_mm_storeu_ps(force_y + j, _mm_sub_ps(_mm_loadu_ps(force_y + j), pair_y));
+			_mm_storeu_ps(force_z + j, _mm_sub_ps(_mm_loadu_ps(force_z + j), pair_z));
+
+			// The tidal term is even in r, so both bodies share r r^T and the 3G / r^5 factor
+			const __m128 t = _mm_and_ps(valid, _mm_mul_ps(three_g, _mm_mul_ps(_mm_mul_ps(inv_r2, inv_r2), inv_r)));
+			const __m128 ti = _mm_mul_ps(t, other_mass);
+			const __m128 tj = _mm_mul_ps(t, mass);
+			const __m128 zz = _mm_mul_ps(rz, rz);
+			const __m128 xx = _mm_sub_ps(_mm_mul_ps(rx, rx), zz), yy = _mm_sub_ps(_mm_mul_ps(ry, ry), zz);
+			const __m128 xy = _mm_mul_ps(rx, ry), xz = _mm_mul_ps(rx, rz), yz = _mm_mul_ps(ry, rz);
+			txx = _mm_add_ps(txx, _mm_mul_ps(ti, xx));
+			tyy = _mm_add_ps(tyy, _mm_mul_ps(ti, yy));
+			txy = _mm_add_ps(txy, _mm_mul_ps(ti, xy));
+			txz = _mm_add_ps(txz, _mm_mul_ps(ti, xz));
+			tyz = _mm_add_ps(tyz, _mm_mul_ps(ti, yz));
+			_mm_storeu_ps(tidal_xx + j, _mm_add_ps(_mm_loadu_ps(tidal_xx + j), _mm_mul_ps(tj, xx)));
+			_mm_storeu_ps(tidal_yy + j, _mm_add_ps(_mm_loadu_ps(tidal_yy + j), _mm_mul_ps(tj, yy)));
+			_mm_storeu_ps(tidal_xy + j, _mm_add_ps(_mm_loadu_ps(tidal_xy + j), _mm_mul_ps(tj, xy)));
+			_mm_storeu_ps(tidal_xz + j, _mm_add_ps(_mm_loadu_ps(tidal_xz + j), _mm_mul_ps(tj, xz)));
+			_mm_storeu_ps(tidal_yz + j, _mm_add_ps(_mm_loadu_ps(tidal_yz + j), _mm_mul_ps(tj, yz)));
+
+			offset = _mm_add_epi32(offset, step);
+		}
+		force_x[i] += horizontal_sum(fx); force_y[i] += horizontal_sum(fy); force_z[i] += horizontal_sum(fz);
+		tidal_xx[i] += horizontal_sum(txx); tidal_yy[i] += horizontal_sum(tyy);
+		tidal_xy[i] += horizontal_sum(txy); tidal_xz[i] += horizontal_sum(txz); tidal_yz[i] += horizontal_sum(tyz);
+	}
+}
+
+void tracer_kernel_sse42(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az) {
+	const __m128 epsilon = _mm_set1_ps(EPSILON);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 inv_sqrt_epsilon = _mm_div_ps(one, _mm_sqrt_ps(epsilon));
+	for (unsigned int i = 0; i < count; i += 4) {
+		const __m128 px = _mm_loadu_ps(x + i);
+		const __m128 py = _mm_loadu_ps(y + i);
+		const __m128 pz = _mm_loadu_ps(z + i);
+		__m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sz = _mm_setzero_ps();
+		// Sources are broadcast one at a time, the lanes hold consecutive tracers
+		for (unsigned int j = 0; j < sources.count; ++j) {
+			const __m128 rx = _mm_sub_ps(_mm_set1_ps(sources.x[j]), px);
+			const __m128 ry = _mm_sub_ps(_mm_set1_ps(sources.y[j]), py);
+			const __m128 rz = _mm_sub_ps(_mm_set1_ps(sources.z[j]), pz);
+			const __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+			const __m128 inv_length = _mm_div_ps(one, _mm_sqrt_ps(r2));
+			const __m128 inv_r = _mm_blendv_ps(inv_length, inv_sqrt_epsilon, _mm_cmplt_ps(r2, epsilon));
+			const __m128 a = _mm_and_ps(_mm_cmpgt_ps(r2, zero),
+				_mm_mul_ps(_mm_set1_ps(sources.mu[j]), _mm_mul_ps(_mm_mul_ps(inv_r, inv_r), inv_length)));
+			sx = _mm_add_ps(sx, _mm_mul_ps(a, rx));
+			sy = _mm_add_ps(sy, _mm_mul_ps(a, ry));
+			sz = _mm_add_ps(sz, _mm_mul_ps(a, rz));
+		}
+		_mm_storeu_ps(ax + i, sx);
+		_mm_storeu_ps(ay + i, sy);
+		_mm_storeu_ps(az + i, sz);
+	}
+}
+
+// Natural logarithm of positive normal floats, Cephes logf: the mantissa is brought to [sqrt(1/2), sqrt(2)) and the
+// logarithm of 1 + m follows from a polynomial
+static inline __m128 log_ps(const __m128 x) {
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i bits = _mm_castps_si128(x);
+	__m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));
+	const __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+	exponent = _mm_sub_ps(exponent, _mm_and_ps(small, one));
+	m = _mm_add_ps(_mm_sub_ps(m, one), _mm_and_ps(small, m));
+	const __m128 z = _mm_mul_ps(m, m);
+	__m128 p = _mm_set1_ps(7.0376836292e-2f);
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.1514610310e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.1676998740e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.2420140846e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.4249322787e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.6668057665e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(2.0000714765e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-2.4999993993e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(3.3333331174e-1f));
+	__m128 y = _mm_mul_ps(_mm_mul_ps(p, m), z);
+	y = _mm_add_ps(y, _mm_mul_ps(exponent, _mm_set1_ps(-2.12194440e-4f)));
+	y = _mm_sub_ps(y, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+	return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(exponent, _mm_set1_ps(0.693359375f)));
+}
+
+// Four quadrant arctangent, Cephes atanf on the ratio of the smaller to the larger magnitude, then unfolded
+static inline __m128 atan2_ps(const __m128 y, const __m128 x) {
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 abs_y = _mm_andnot_ps(sign, y), abs_x = _mm_andnot_ps(sign, x);
+	const __m128 larger = _mm_max_ps(abs_y, abs_x);
+	const __m128 a = _mm_and_ps(_mm_cmpgt_ps(larger, _mm_setzero_ps()), _mm_div_ps(_mm_min_ps(abs_y, abs_x), larger));
+	const __m128 reduce = _mm_cmpgt_ps(a, _mm_set1_ps(0.414213562373095f));
+	const __m128 t = _mm_blendv_ps(a, _mm_div_ps(_mm_sub_ps(a, one), _mm_add_ps(a, one)), reduce);
+	const __m128 z = _mm_mul_ps(t, t);
+	__m128 p = _mm_set1_ps(8.05374449538e-2f);
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-1.38776856032e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.99777106478e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-3.33329491539e-1f));
+	__m128 r = _mm_add_ps(_mm_and_ps(reduce, _mm_set1_ps(0.785398163397448f)), _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), t), t));
+	r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(1.57079632679490f), r), _mm_cmpgt_ps(abs_y, abs_x));
+	r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(3.14159265358979f), r), _mm_cmplt_ps(x, _mm_setzero_ps()));
+	return _mm_or_ps(r, _mm_and_ps(sign, y));
+}
+
+static inline __m128 dot_ps(const __m128 ax, const __m128 ay, const __m128 az, const __m128 bx, const __m128 by, const __m128 bz) {
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+void polyhedron_kernel_sse42(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 tiny = _mm_set1_ps(1e-30f);
+	for (unsigned int i = 0; i < count; i += 4) {
+		const __m128 px = _mm_loadu_ps(x + i);
+		const __m128 py = _mm_loadu_ps(y + i);
+		const __m128 pz = _mm_loadu_ps(z + i);
+		// Offset from the points to every vertex and its length, shared by the edges and faces around the vertex
+		for (unsigned int v = 0; v < polyhedron.vertex_count; ++v) {
+			float* offset = scratch + v * 16;
+			const __m128 rx = _mm_sub_ps(_mm_set1_ps(polyhedron.vertex_x[v]), px);
+			const __m128 ry = _mm_sub_ps(_mm_set1_ps(polyhedron.vertex_y[v]), py);
+			const __m128 rz = _mm_sub_ps(_mm_set1_ps(polyhedron.vertex_z[v]), pz);
+			_mm_storeu_ps(offset, rx);
+			_mm_storeu_ps(offset + 4, ry);
+			_mm_storeu_ps(offset + 8, rz);
+			_mm_storeu_ps(offset + 12, _mm_sqrt_ps(dot_ps(rx, ry, rz, rx, ry, rz)));
+		}
+
+		__m128 ex = _mm_setzero_ps(), ey = _mm_setzero_ps(), ez = _mm_setzero_ps();
+		for (unsigned int e = 0; e < polyhedron.edge_count; ++e) {
+			const PolyhedronEdge& edge = polyhedron.edges[e];
+			const __m128 sum = _mm_add_ps(_mm_loadu_ps(scratch + edge.first * 16 + 12), _mm_loadu_ps(scratch + edge.second * 16 + 12));
+			const __m128 length = _mm_set1_ps(edge.length);
+			const __m128 difference = _mm_sub_ps(sum, length);
+			const __m128 factor = _mm_and_ps(_mm_cmpgt_ps(difference, zero),
+				log_ps(_mm_div_ps(_mm_add_ps(sum, length), _mm_max_ps(difference, tiny))));
+			const __m128 d0 = _mm_set1_ps(edge.dyad[0]), d1 = _mm_set1_ps(edge.dyad[1]), d2 = _mm_set1_ps(edge.dyad[2]);
+			const __m128 d3 = _mm_set1_ps(edge.dyad[3]), d4 = _mm_set1_ps(edge.dyad[4]), d5 = _mm_set1_ps(edge.dyad[5]);
+			// E r_e = E (first - p)
+			const __m128 rx = _mm_sub_ps(_mm_set1_ps(edge.dyad_first[0]), dot_ps(d0, d3, d4, px, py, pz));
+			const __m128 ry = _mm_sub_ps(_mm_set1_ps(edge.dyad_first[1]), dot_ps(d3, d1, d5, px, py, pz));
+			const __m128 rz = _mm_sub_ps(_mm_set1_ps(edge.dyad_first[2]), dot_ps(d4, d5, d2, px, py, pz));
+			ex = _mm_add_ps(ex, _mm_mul_ps(factor, rx));
+			ey = _mm_add_ps(ey, _mm_mul_ps(factor, ry));
+			ez = _mm_add_ps(ez, _mm_mul_ps(factor, rz));
+		}
+
+		__m128 fx = _mm_setzero_ps(), fy = _mm_setzero_ps(), fz = _mm_setzero_ps();
+		for (unsigned int f = 0; f < polyhedron.face_count; ++f) {
+			const PolyhedronFace& face = polyhedron.faces[f];
+			const float* r1 = scratch + face.vertices[0] * 16;
+			const float* r2 = scratch + face.vertices[1] * 16;
+			const float* r3 = scratch + face.vertices[2] * 16;
+			const __m128 x1 = _mm_loadu_ps(r1), y1 = _mm_loadu_ps(r1 + 4), z1 = _mm_loadu_ps(r1 + 8), l1 = _mm_loadu_ps(r1 + 12);
+			const __m128 x2 = _mm_loadu_ps(r2), y2 = _mm_loadu_ps(r2 + 4), z2 = _mm_loadu_ps(r2 + 8), l2 = _mm_loadu_ps(r2 + 12);
+			const __m128 x3 = _mm_loadu_ps(r3), y3 = _mm_loadu_ps(r3 + 4), z3 = _mm_loadu_ps(r3 + 8), l3 = _mm_loadu_ps(r3 + 12);
+			// Solid angle: tan(omega / 2) = r1 . (r2 x r3) / (l1 l2 l3 + l1 r2.r3 + l2 r3.r1 + l3 r1.r2)
+			const __m128 cx = _mm_sub_ps(_mm_mul_ps(y2, z3), _mm_mul_ps(z2, y3));
+			const __m128 cy = _mm_sub_ps(_mm_mul_ps(z2, x3), _mm_mul_ps(x2, z3));
+			const __m128 cz = _mm_sub_ps(_mm_mul_ps(x2, y3), _mm_mul_ps(y2, x3));
+			const __m128 numerator = dot_ps(x1, y1, z1, cx, cy, cz);
+			const __m128 denominator = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(l1, l2), l3),
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(l1, dot_ps(x2, y2, z2, x3, y3, z3)), _mm_mul_ps(l2, dot_ps(x3, y3, z3, x1, y1, z1))),
+					_mm_mul_ps(l3, dot_ps(x1, y1, z1, x2, y2, z2))));
+			const __m128 omega = _mm_mul_ps(two, atan2_ps(numerator, denominator));
+			const __m128 nx = _mm_set1_ps(face.normal[0]), ny = _mm_set1_ps(face.normal[1]), nz = _mm_set1_ps(face.normal[2]);
+			// F r_f = n (offset - n . p)
+			const __m128 w = _mm_mul_ps(omega, _mm_sub_ps(_mm_set1_ps(face.offset), dot_ps(nx, ny, nz, px, py, pz)));
+			fx = _mm_add_ps(fx, _mm_mul_ps(w, nx));
+			fy = _mm_add_ps(fy, _mm_mul_ps(w, ny));
+			fz = _mm_add_ps(fz, _mm_mul_ps(w, nz));
+		}
+
+		const __m128 mu = _mm_set1_ps(polyhedron.mu_density);
+		_mm_storeu_ps(ax + i, _mm_mul_ps(mu, _mm_sub_ps(fx, ex)));
+		_mm_storeu_ps(ay + i, _mm_mul_ps(mu, _mm_sub_ps(fy, ey)));
+		_mm_storeu_ps(az + i, _mm_mul_ps(mu, _mm_sub_ps(fz, ez)));
+	}
+}
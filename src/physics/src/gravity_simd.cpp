@@ -0,0 +1,362 @@
+#include <gravity_simd/gravity_simd.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+using std::vector;
+using glm::mat3, glm::vec3;
+
+#if defined(PHYSICS_X86_KERNELS)
+/// <summary>
+/// Reads the CPUID leaves and the XCR0 register to check which vector extensions are usable
+/// </summary>
+static SimdLevel query_simd_level() {
+	unsigned int regs[4] = { 0 };
+	auto cpuid = [&](const unsigned int leaf, const unsigned int subleaf) {
+#if defined(_MSC_VER)
+		int out[4];
+		__cpuidex(out, leaf, subleaf);
+		for (int i = 0; i < 4; ++i) regs[i] = out[i];
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	};
+	auto xgetbv = []() -> unsigned long long {
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	};
+
+	cpuid(0, 0);
+	const unsigned int max_leaf = regs[0];
+	cpuid(1, 0);
+	const bool has_sse42 = regs[2] & (1u << 20);
+	const bool has_osxsave = regs[2] & (1u << 27);
+	const bool has_avx = regs[2] & (1u << 28);
+	const bool has_fma = regs[2] & (1u << 12);
+	if (!has_sse42) return SimdLevel::scalar;
+	if (!has_osxsave || !has_avx || max_leaf < 7) return SimdLevel::sse42;
+
+	const unsigned long long xcr0 = xgetbv();
+	// XMM and YMM state must be saved by the OS
+	if ((xcr0 & 0x6) != 0x6) return SimdLevel::sse42;
+	cpuid(7, 0);
+	const bool has_avx2 = regs[1] & (1u << 5);
+	const bool has_avx512f = regs[1] & (1u << 16);
+	if (!has_avx2 || !has_fma) return SimdLevel::sse42;
+	// Opmask and ZMM state must be saved by the OS
+	if (has_avx512f && (xcr0 & 0xe6) == 0xe6) return SimdLevel::avx512;
+	return SimdLevel::avx2;
+}
+#endif
+
+SimdLevel detect_simd_level() {
+#if defined(PHYSICS_X86_KERNELS)
+	static const SimdLevel level = query_simd_level();
+	return level;
+#else
+	return SimdLevel::scalar;
+#endif
+}
+
+const char* simd_level_name(const SimdLevel level) {
+	switch (level) {
+	case SimdLevel::scalar: return "scalar";
+	case SimdLevel::sse42: return "sse4.2";
+	case SimdLevel::avx2: return "avx2";
+	case SimdLevel::avx512: return "avx512";
+	}
+	return "unknown";
+}
+
+GravityKernel select_gravity_kernel(const SimdLevel level) {
+	const SimdLevel supported = detect_simd_level();
+	const SimdLevel selected = static_cast<int>(level) < static_cast<int>(supported) ? level : supported;
+	switch (selected) {
+#if defined(PHYSICS_X86_KERNELS)
+	case SimdLevel::avx512: return gravity_kernel_avx512;
+	case SimdLevel::avx2: return gravity_kernel_avx2;
+	case SimdLevel::sse42: return gravity_kernel_sse42;
+#endif
+	default: return gravity_kernel_scalar;
+	}
+}
+
+SymmetricGravityKernel select_symmetric_gravity_kernel(const SimdLevel level) {
+	const SimdLevel supported = detect_simd_level();
+	const SimdLevel selected = static_cast<int>(level) < static_cast<int>(supported) ? level : supported;
+	switch (selected) {
+#if defined(PHYSICS_X86_KERNELS)
+	case SimdLevel::avx512: return symmetric_gravity_kernel_avx512;
+	case SimdLevel::avx2: return symmetric_gravity_kernel_avx2;
+	case SimdLevel::sse42: return symmetric_gravity_kernel_sse42;
+#endif
+	default: return symmetric_gravity_kernel_scalar;
+	}
+}
+
+TracerKernel select_tracer_kernel(const SimdLevel level) {
+	const SimdLevel supported = detect_simd_level();
+	const SimdLevel selected = static_cast<int>(level) < static_cast<int>(supported) ? level : supported;
+	switch (selected) {
+#if defined(PHYSICS_X86_KERNELS)
+	case SimdLevel::avx512: return tracer_kernel_avx512;
+	case SimdLevel::avx2: return tracer_kernel_avx2;
+	case SimdLevel::sse42: return tracer_kernel_sse42;
+#endif
+	default: return tracer_kernel_scalar;
+	}
+}
+
+PolyhedronKernel select_polyhedron_kernel(const SimdLevel level) {
+	const SimdLevel supported = detect_simd_level();
+	const SimdLevel selected = static_cast<int>(level) < static_cast<int>(supported) ? level : supported;
+	switch (selected) {
+#if defined(PHYSICS_X86_KERNELS)
+	case SimdLevel::avx512: return polyhedron_kernel_avx512;
+	case SimdLevel::avx2: return polyhedron_kernel_avx2;
+	case SimdLevel::sse42: return polyhedron_kernel_sse42;
+#endif
+	default: return polyhedron_kernel_scalar;
+	}
+}
+
+void GravitySources::assign(const vector<vec3>& positions, const vector<float>& masses, const float G) {
+	count = positions.size();
+	const unsigned int padded_count = (count + gravity_source_padding - 1) / gravity_source_padding * gravity_source_padding;
+	x.assign(padded_count, 0.0f);
+	y.assign(padded_count, 0.0f);
+	z.assign(padded_count, 0.0f);
+	mu.assign(padded_count, 0.0f);
+	for (unsigned int i = 0; i < count; ++i) {
+		x[i] = positions[i].x;
+		y[i] = positions[i].y;
+		z[i] = positions[i].z;
+		mu[i] = masses[i] * G;
+	}
+}
+
+GravitySourceArrays GravitySources::arrays() const {
+	return GravitySourceArrays{ x.data(), y.data(), z.data(), mu.data(), count, static_cast<unsigned int>(x.size()) };
+}
+
+// Arrays held by SymmetricBodies: x, y, z, mass, the three force components and the five tidal ones
+constexpr unsigned int symmetric_array_count = 12;
+// Floats in a cache line
+constexpr unsigned int cache_line_floats = 16;
+
+void SymmetricBodies::assign(const vector<vec3>& positions, const vector<float>& masses) {
+	count = positions.size();
+	padded_count = (count + gravity_source_padding - 1) / gravity_source_padding * gravity_source_padding;
+	storage.assign(static_cast<size_t>(symmetric_array_count) * padded_count + cache_line_floats, 0.0f);
+	const size_t misalignment = reinterpret_cast<uintptr_t>(storage.data()) % (cache_line_floats * sizeof(float));
+	offset = misalignment == 0 ? 0 : static_cast<unsigned int>((cache_line_floats * sizeof(float) - misalignment) / sizeof(float));
+	float* x = array(0);
+	float* y = array(1);
+	float* z = array(2);
+	float* mass = array(3);
+	for (unsigned int i = 0; i < count; ++i) {
+		x[i] = positions[i].x;
+		y[i] = positions[i].y;
+		z[i] = positions[i].z;
+		mass[i] = masses[i];
+	}
+}
+
+const float* SymmetricBodies::array(const unsigned int index) const {
+	return storage.data() + offset + static_cast<size_t>(index) * padded_count;
+}
+
+float* SymmetricBodies::array(const unsigned int index) {
+	return storage.data() + offset + static_cast<size_t>(index) * padded_count;
+}
+
+SymmetricBodyArrays SymmetricBodies::arrays() const {
+	return SymmetricBodyArrays{ array(0), array(1), array(2), array(3), count, padded_count };
+}
+
+SymmetricAccumulators SymmetricBodies::accumulators() {
+	return SymmetricAccumulators{ { array(4), array(5), array(6) }, { array(7), array(8), array(9), array(10), array(11) } };
+}
+
+vec3 SymmetricBodies::force(const unsigned int index) const {
+	return vec3(array(4)[index], array(5)[index], array(6)[index]);
+}
+
+mat3 SymmetricBodies::tidal_tensor(const unsigned int index) const {
+	const float xx = array(7)[index], yy = array(8)[index];
+	const float xy = array(9)[index], xz = array(10)[index], yz = array(11)[index];
+	return mat3(xx, xy, xz, xy, yy, yz, xz, yz, 0.0f);
+}
+
+GravityTarget make_gravity_target(const vec3& position, const float mass, const mat3& world_inertia, const unsigned int skip_index) {
+	GravityTarget target;
+	target.position[0] = position.x;
+	target.position[1] = position.y;
+	target.position[2] = position.z;
+	target.mass = mass;
+	for (unsigned int c = 0; c < 3; ++c) {
+		for (unsigned int r = 0; r < 3; ++r) {
+			target.world_inertia[c * 3 + r] = world_inertia[c][r];
+		}
+	}
+	target.skip_index = skip_index;
+	return target;
+}
+
+void gravity_kernel_scalar(const GravitySourceArrays& sources, const GravityTarget& target, float force[3], float torque[3]) {
+	const float* w = target.world_inertia;
+	float fx = 0.0f, fy = 0.0f, fz = 0.0f;
+	float tx = 0.0f, ty = 0.0f, tz = 0.0f;
+	for (unsigned int j = 0; j < sources.count; ++j) {
+		if (j == target.skip_index) continue;
+		const float rx = sources.x[j] - target.position[0];
+		const float ry = sources.y[j] - target.position[1];
+		const float rz = sources.z[j] - target.position[2];
+		const float r2 = rx * rx + ry * ry + rz * rz;
+		const float dist2 = r2 < EPSILON ? EPSILON : r2;
+		// gravity_force: the clamped distance scales the magnitude, the direction uses the real one
+		const float f = target.mass * sources.mu[j] / dist2 / std::sqrt(r2);
+		fx += f * rx;
+		fy += f * ry;
+		fz += f * rz;
+		// gravity_torque
+		const float inv_r = 1.0f / std::sqrt(dist2);
+		const float inv_r2 = inv_r * inv_r;
+		const float t = 3.0f * sources.mu[j] * inv_r2 * inv_r2 * inv_r;
+		const float ix = w[0] * rx + w[3] * ry + w[6] * rz;
+		const float iy = w[1] * rx + w[4] * ry + w[7] * rz;
+		const float iz = w[2] * rx + w[5] * ry + w[8] * rz;
+		tx += t * (ry * iz - rz * iy);
+		ty += t * (rz * ix - rx * iz);
+		tz += t * (rx * iy - ry * ix);
+	}
+	force[0] = fx; force[1] = fy; force[2] = fz;
+	torque[0] = tx; torque[1] = ty; torque[2] = tz;
+}
+
+void symmetric_gravity_kernel_scalar(const SymmetricBodyArrays& bodies, const float G, const unsigned int i_begin, const unsigned int i_end,
+	const unsigned int j_begin, const unsigned int j_end, const SymmetricAccumulators& accumulators) {
+	const unsigned int i_last = i_end < bodies.count ? i_end : bodies.count;
+	const unsigned int j_last = j_end < bodies.count ? j_end : bodies.count;
+	float* const* tidal = accumulators.tidal;
+	for (unsigned int i = i_begin; i < i_last; ++i) {
+		const float g_mass = G * bodies.mass[i];
+		float fx = 0.0f, fy = 0.0f, fz = 0.0f;
+		float txx = 0.0f, tyy = 0.0f, txy = 0.0f, txz = 0.0f, tyz = 0.0f;
+		for (unsigned int j = i + 1 > j_begin ? i + 1 : j_begin; j < j_last; ++j) {
+			const float rx = bodies.x[j] - bodies.x[i];
+			const float ry = bodies.y[j] - bodies.y[i];
+			const float rz = bodies.z[j] - bodies.z[i];
+			const float r2 = rx * rx + ry * ry + rz * rz;
+			const float dist2 = r2 < EPSILON ? EPSILON : r2;
+			// gravity_force on i, j gets the opposite
+			const float f = g_mass * bodies.mass[j] / dist2 / std::sqrt(r2);
+			fx += f * rx;
+			fy += f * ry;
+			fz += f * rz;
+			accumulators.force[0][j] -= f * rx;
+			accumulators.force[1][j] -= f * ry;
+			accumulators.force[2][j] -= f * rz;
+			// The tidal term is even in r, so both bodies share r r^T and the 3G / r^5 factor
+			const float inv_r = 1.0f / std::sqrt(dist2);
+			const float inv_r2 = inv_r * inv_r;
+			const float t = 3.0f * G * inv_r2 * inv_r2 * inv_r;
+			const float ti = t * bodies.mass[j], tj = t * bodies.mass[i];
+			const float xx = rx * rx - rz * rz, yy = ry * ry - rz * rz, xy = rx * ry, xz = rx * rz, yz = ry * rz;
+			txx += ti * xx; tyy += ti * yy;
+			txy += ti * xy; txz += ti * xz; tyz += ti * yz;
+			tidal[0][j] += tj * xx; tidal[1][j] += tj * yy;
+			tidal[2][j] += tj * xy; tidal[3][j] += tj * xz; tidal[4][j] += tj * yz;
+		}
+		accumulators.force[0][i] += fx; accumulators.force[1][i] += fy; accumulators.force[2][i] += fz;
+		tidal[0][i] += txx; tidal[1][i] += tyy;
+		tidal[2][i] += txy; tidal[3][i] += txz; tidal[4][i] += tyz;
+	}
+}
+
+void tracer_kernel_scalar(const GravitySourceArrays& sources, const float* x, const float* y, const float* z,
+	const unsigned int count, float* ax, float* ay, float* az) {
+	for (unsigned int i = 0; i < count; ++i) {
+		float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+		for (unsigned int j = 0; j < sources.count; ++j) {
+			const float rx = sources.x[j] - x[i];
+			const float ry = sources.y[j] - y[i];
+			const float rz = sources.z[j] - z[i];
+			const float r2 = rx * rx + ry * ry + rz * rz;
+			if (r2 == 0.0f) continue;
+			const float dist2 = r2 < EPSILON ? EPSILON : r2;
+			const float a = sources.mu[j] / dist2 / std::sqrt(r2);
+			sx += a * rx;
+			sy += a * ry;
+			sz += a * rz;
+		}
+		ax[i] = sx;
+		ay[i] = sy;
+		az[i] = sz;
+	}
+}
+
+void polyhedron_kernel_scalar(const PolyhedronArrays& polyhedron, const float* x, const float* y, const float* z,
+	const unsigned int count, float* scratch, float* ax, float* ay, float* az) {
+	for (unsigned int i = 0; i < count; ++i) {
+		// Offset from the point to every vertex and its length
+		for (unsigned int v = 0; v < polyhedron.vertex_count; ++v) {
+			float* offset = scratch + v * 4;
+			offset[0] = polyhedron.vertex_x[v] - x[i];
+			offset[1] = polyhedron.vertex_y[v] - y[i];
+			offset[2] = polyhedron.vertex_z[v] - z[i];
+			offset[3] = std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+		}
+
+		float ex = 0.0f, ey = 0.0f, ez = 0.0f;
+		for (unsigned int e = 0; e < polyhedron.edge_count; ++e) {
+			const PolyhedronEdge& edge = polyhedron.edges[e];
+			const float sum = scratch[edge.first * 4 + 3] + scratch[edge.second * 4 + 3];
+			const float difference = sum - edge.length;
+			if (!(difference > 0.0f)) continue;
+			const float factor = std::log((sum + edge.length) / std::max(difference, 1e-30f));
+			const float* d = edge.dyad;
+			// E r_e = E (first - p)
+			ex += factor * (edge.dyad_first[0] - (d[0] * x[i] + d[3] * y[i] + d[4] * z[i]));
+			ey += factor * (edge.dyad_first[1] - (d[3] * x[i] + d[1] * y[i] + d[5] * z[i]));
+			ez += factor * (edge.dyad_first[2] - (d[4] * x[i] + d[5] * y[i] + d[2] * z[i]));
+		}
+
+		float fx = 0.0f, fy = 0.0f, fz = 0.0f;
+		for (unsigned int f = 0; f < polyhedron.face_count; ++f) {
+			const PolyhedronFace& face = polyhedron.faces[f];
+			const float* r1 = scratch + face.vertices[0] * 4;
+			const float* r2 = scratch + face.vertices[1] * 4;
+			const float* r3 = scratch + face.vertices[2] * 4;
+			// Solid angle: tan(omega / 2) = r1 . (r2 x r3) / (l1 l2 l3 + l1 r2.r3 + l2 r3.r1 + l3 r1.r2)
+			const float numerator = r1[0] * (r2[1] * r3[2] - r2[2] * r3[1]) + r1[1] * (r2[2] * r3[0] - r2[0] * r3[2])
+				+ r1[2] * (r2[0] * r3[1] - r2[1] * r3[0]);
+			const float denominator = r1[3] * r2[3] * r3[3]
+				+ r1[3] * (r2[0] * r3[0] + r2[1] * r3[1] + r2[2] * r3[2])
+				+ r2[3] * (r3[0] * r1[0] + r3[1] * r1[1] + r3[2] * r1[2])
+				+ r3[3] * (r1[0] * r2[0] + r1[1] * r2[1] + r1[2] * r2[2]);
+			const float omega = 2.0f * std::atan2(numerator, denominator);
+			// F r_f = n (offset - n . p)
+			const float* n = face.normal;
+			const float w = omega * (face.offset - (n[0] * x[i] + n[1] * y[i] + n[2] * z[i]));
+			fx += w * n[0];
+			fy += w * n[1];
+			fz += w * n[2];
+		}
+
+		ax[i] = polyhedron.mu_density * (fx - ex);
+		ay[i] = polyhedron.mu_density * (fy - ey);
+		az[i] = polyhedron.mu_density * (fz - ez);
+	}
+}
@@ -0,0 +1,41 @@
+#include <gravity/gravity.hpp>
+#include <algorithm>
+#include <utility>
+
+using std::vector;
+
+void accumulate_gravity_symmetric(BodyStore& bodies, const float G, const SimdLevel simd_level, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	if (n < 2) return;
+	const SymmetricGravityKernel kernel = select_symmetric_gravity_kernel(simd_level);
+	SymmetricBodies symmetric;
+	symmetric.assign(bodies.positions, bodies.masses);
+	const SymmetricBodyArrays arrays = symmetric.arrays();
+	const SymmetricAccumulators accumulators = symmetric.accumulators();
+
+	// Round r pairs tile I with tile (r - I) mod tile_count, so every tile takes part in exactly one pair per round and
+	// the pairs of a round can run in parallel on disjoint bodies. Every unordered pair of tiles comes up in one round,
+	// and each body's sums are formed in the same order whatever the amount of threads.
+	const unsigned int tile_count = (n + symmetric_tile_size - 1) / symmetric_tile_size;
+	vector<std::pair<unsigned int, unsigned int>> round_pairs;
+	for (unsigned int round = 0; round < tile_count; ++round) {
+		round_pairs.clear();
+		for (unsigned int row = 0; row < tile_count; ++row) {
+			const unsigned int column = (round + tile_count - row) % tile_count;
+			if (row <= column) round_pairs.emplace_back(row, column);
+		}
+		thread_pool.run(round_pairs.size(), [&](const unsigned int pair) {
+			const unsigned int i_begin = round_pairs[pair].first * symmetric_tile_size;
+			const unsigned int j_begin = round_pairs[pair].second * symmetric_tile_size;
+			kernel(arrays, G, i_begin, std::min(i_begin + symmetric_tile_size, n),
+				j_begin, std::min(j_begin + symmetric_tile_size, arrays.padded_count), accumulators);
+		});
+	}
+
+	thread_pool.parallel_for(n, force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			bodies.forces[i] += symmetric.force(i);
+			bodies.torques[i] += tidal_torque(symmetric.tidal_tensor(i), bodies.world_inertias[i]);
+		}
+	});
+}
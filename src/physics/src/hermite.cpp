@@ -0,0 +1,161 @@
+#include <hermite/hermite.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <gravity/gravity.hpp>
+
+using glm::mat3, glm::vec3;
+
+// Ticks in a whole step, the time at which every body is synchronized again
+constexpr unsigned int hermite_end_time = 1u << hermite_max_level;
+
+static unsigned int level_ticks(const unsigned int level) {
+	return 1u << (hermite_max_level - level);
+}
+
+static mat3 world_inertia(const BodyStore& bodies, const unsigned int i) {
+	const mat3 rotation = glm::mat3_cast(bodies.orientations[i]);
+	return rotation * bodies.inertia_tensors[i] * glm::transpose(rotation);
+}
+
+unsigned long long HermiteIntegrator::evaluations() const {
+	return evaluation_count;
+}
+
+void HermiteIntegrator::reset() {
+	initialized = false;
+}
+
+unsigned int HermiteIntegrator::level_for(const float step_size, const unsigned int current_level, const unsigned int time) const {
+	unsigned int level = current_level;
+	while (level < hermite_max_level && std::ldexp(step_delta_time, -static_cast<int>(level)) > step_size) ++level;
+	// Steps only grow one level at a time, and only where the longer step would start on its own block boundary
+	if (level == current_level && level > 0
+		&& std::ldexp(step_delta_time, -static_cast<int>(level - 1)) <= step_size && time % level_ticks(level - 1) == 0) {
+		--level;
+	}
+	return level;
+}
+
+void HermiteIntegrator::evaluate(const BodyStore& bodies, const unsigned int i, const float G, const mat3& world_inertia,
+	vec3& acceleration, vec3& jerk, vec3& torque) const {
+	acceleration = vec3(0.0f);
+	jerk = vec3(0.0f);
+	torque = vec3(0.0f);
+	const vec3 position = predicted_positions[i];
+	const vec3 velocity = predicted_velocities[i];
+	for (unsigned int j = 0; j < bodies.size(); ++j) {
+		if (j == i) continue;
+		const vec3 r = predicted_positions[j] - position;
+		const vec3 v = predicted_velocities[j] - velocity;
+		float dist2 = glm::dot(r, r);
+		if (dist2 < EPSILON) dist2 = EPSILON;
+		const float mu = G * bodies.masses[j];
+		const float inv_r = glm::inversesqrt(dist2);
+		const float mu_inv_r3 = mu * inv_r * inv_r * inv_r;
+		const float inv_r2 = inv_r * inv_r;
+		acceleration += mu_inv_r3 * r;
+		jerk += mu_inv_r3 * (v - 3.0f * glm::dot(r, v) * inv_r2 * r);
+		// gravity_torque, sharing the inverse distance
+		torque += 3.0f * mu_inv_r3 * inv_r2 * glm::cross(r, world_inertia * r);
+	}
+}
+
+void HermiteIntegrator::initialize(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	step_delta_time = delta_time;
+	accelerations.resize(n);
+	jerks.resize(n);
+	torques.resize(n);
+	times.assign(n, 0);
+	levels.assign(n, 0);
+	bodies.update_auxiliary_variables();
+	predicted_positions = bodies.positions;
+	predicted_velocities = bodies.velocities;
+
+	thread_pool.parallel_for(n, force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			evaluate(bodies, i, G, bodies.world_inertias[i], accelerations[i], jerks[i], torques[i]);
+			const float jerk = glm::length(jerks[i]);
+			const float step_size = jerk > 0.0f ? hermite_initial_accuracy * glm::length(accelerations[i]) / jerk : delta_time;
+			levels[i] = level_for(step_size, 0, 0);
+		}
+	});
+	evaluation_count += n;
+	initialized = true;
+}
+
+void HermiteIntegrator::predict(const BodyStore& bodies, const unsigned int time, const float delta_time) {
+	const float tick = std::ldexp(delta_time, -static_cast<int>(hermite_max_level));
+	for (unsigned int j = 0; j < bodies.size(); ++j) {
+		const float t = (time - times[j]) * tick;
+		const vec3 a = accelerations[j], k = jerks[j];
+		predicted_positions[j] = bodies.positions[j] + t * (bodies.velocities[j] + t * (0.5f * a + t / 6.0f * k));
+		predicted_velocities[j] = bodies.velocities[j] + t * (a + 0.5f * t * k);
+	}
+}
+
+void HermiteIntegrator::step(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool) {
+	if (!initialized || delta_time != step_delta_time || accelerations.size() != bodies.size()) {
+		initialize(bodies, G, delta_time, thread_pool);
+	}
+	const unsigned int n = bodies.size();
+	for (;;) {
+		// The next block time is the earliest end of a body's step. Every body ending there is active
+		unsigned int next_time = std::numeric_limits<unsigned int>::max();
+		for (unsigned int i = 0; i < n; ++i) {
+			if (times[i] < hermite_end_time) next_time = std::min(next_time, times[i] + level_ticks(levels[i]));
+		}
+		if (next_time == std::numeric_limits<unsigned int>::max()) break;
+		active.clear();
+		for (unsigned int i = 0; i < n; ++i) {
+			if (times[i] + level_ticks(levels[i]) == next_time) active.push_back(i);
+		}
+		predict(bodies, next_time, delta_time);
+
+		thread_pool.parallel_for(active.size(), force_block_size, [&](const unsigned int begin, const unsigned int end) {
+			for (unsigned int a = begin; a < end; ++a) {
+				const unsigned int i = active[a];
+				const float h = std::ldexp(delta_time, -static_cast<int>(levels[i]));
+				// Kick-rotate-kick of the orientation over the body's own step
+				bodies.angular_momenta[i] += 0.5f * h * torques[i];
+				bodies.orientations[i] = rotate_free_body(bodies.orientations[i], bodies.angular_momenta[i],
+					bodies.principal_moments[i], bodies.principal_frames[i], h);
+
+				vec3 a1, j1, torque;
+				evaluate(bodies, i, G, world_inertia(bodies, i), a1, j1, torque);
+				bodies.angular_momenta[i] += 0.5f * h * torque;
+
+				// Hermite corrector
+				const vec3 a0 = accelerations[i], j0 = jerks[i];
+				const vec3 v0 = bodies.velocities[i];
+				const vec3 v1 = v0 + 0.5f * h * (a0 + a1) + h * h / 12.0f * (j0 - j1);
+				bodies.positions[i] += 0.5f * h * (v0 + v1) + h * h / 12.0f * (a0 - a1);
+				bodies.velocities[i] = v1;
+				bodies.linear_momenta[i] = bodies.masses[i] * v1;
+
+				// Aarseth's criterion, with the second and third derivatives of the acceleration at the end of the step
+				const vec3 snap0 = (-6.0f * (a0 - a1) - h * (4.0f * j0 + 2.0f * j1)) / (h * h);
+				const vec3 crackle = (12.0f * (a0 - a1) + 6.0f * h * (j0 + j1)) / (h * h * h);
+				const vec3 snap1 = snap0 + h * crackle;
+				const float numerator = glm::length(a1) * glm::length(snap1) + glm::dot(j1, j1);
+				const float denominator = glm::length(j1) * glm::length(crackle) + glm::dot(snap1, snap1);
+				const float step_size = denominator > 0.0f ? std::sqrt(hermite_accuracy * numerator / denominator) : delta_time;
+
+				accelerations[i] = a1;
+				jerks[i] = j1;
+				torques[i] = torque;
+				times[i] = next_time;
+				levels[i] = level_for(step_size, levels[i], next_time);
+			}
+		});
+		evaluation_count += active.size();
+	}
+
+	std::fill(times.begin(), times.end(), 0);
+	for (unsigned int i = 0; i < n; ++i) {
+		bodies.forces[i] = bodies.masses[i] * accelerations[i];
+		bodies.torques[i] = torques[i];
+	}
+	bodies.update_auxiliary_variables();
+}
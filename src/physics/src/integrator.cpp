@@ -0,0 +1,155 @@
+#include <integrator/integrator.hpp>
+
+using std::vector;
+
+vector<SplittingStep> kick_drift_kick(const double* weights, const unsigned int stage_count) {
+	vector<SplittingStep> steps;
+	double pending_kick = 0.0;
+	for (unsigned int s = 0; s < stage_count; ++s) {
+		steps.push_back({ true, pending_kick + 0.5 * weights[s] });
+		steps.push_back({ false, weights[s] });
+		pending_kick = 0.5 * weights[s];
+	}
+	steps.push_back({ true, pending_kick });
+	return steps;
+}
+
+vector<SplittingStep> drift_kick_drift(const double* weights, const unsigned int stage_count) {
+	vector<SplittingStep> steps;
+	double pending_drift = 0.0;
+	for (unsigned int s = 0; s < stage_count; ++s) {
+		steps.push_back({ false, pending_drift + 0.5 * weights[s] });
+		steps.push_back({ true, weights[s] });
+		pending_drift = 0.5 * weights[s];
+	}
+	steps.push_back({ false, pending_drift });
+	return steps;
+}
+
+vector<SplittingStep> splitting_steps(const IntegratorKind kind) {
+	const double leapfrog_weights[1] = { 1.0 };
+	switch (kind) {
+	case IntegratorKind::euler: return {};
+	case IntegratorKind::hermite: return {};
+	case IntegratorKind::wisdom_holman: return {};
+	case IntegratorKind::leapfrog: return kick_drift_kick(leapfrog_weights, 1);
+	case IntegratorKind::yoshida4: return kick_drift_kick(yoshida4_weights, 3);
+	case IntegratorKind::yoshida6: return kick_drift_kick(yoshida6_weights, 7);
+	case IntegratorKind::forest_ruth: return drift_kick_drift(yoshida4_weights, 3);
+	}
+	return {};
+}
+
+Integrator::Integrator(const IntegratorKind kind, const float kepler_threshold, const float regularization_radius) {
+	this->integrator_kind = kind;
+	this->kepler_threshold = kepler_threshold;
+	this->regularization_radius = regularization_radius;
+	this->steps = splitting_steps(kind);
+}
+
+IntegratorKind Integrator::kind() const {
+	return integrator_kind;
+}
+
+void Integrator::reset() {
+	forces_current = false;
+	analytic_system = false;
+	hermite.reset();
+	wisdom_holman.reset();
+}
+
+bool Integrator::analytic(const unsigned int index) const {
+	return index < analytic_bodies.size() && analytic_bodies[index];
+}
+
+unsigned long long Integrator::evaluations() const {
+	return evaluation_count + hermite.evaluations() + wisdom_holman.evaluations();
+}
+
+void Integrator::ensure_forces(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool) {
+	if (integrator_kind == IntegratorKind::hermite || integrator_kind == IntegratorKind::wisdom_holman || forces_current
+		|| analytic_system) return;
+	evaluate_forces(bodies, settings, thread_pool);
+}
+
+void Integrator::evaluate_forces(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool) {
+	bodies.update_auxiliary_variables();
+	bodies.clear_forces();
+	accumulate_gravity(bodies, settings, thread_pool);
+	evaluation_count += bodies.size();
+	forces_current = true;
+}
+
+void Integrator::step(BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool) {
+	if (kepler_threshold <= 0.0f && regularization_radius <= 0.0f) {
+		integrate(bodies, settings, delta_time, thread_pool);
+		return;
+	}
+	bodies.update_auxiliary_variables();
+	if (regularization_radius > 0.0f) {
+		regularized_groups.detect(bodies, regularization_radius, delta_time, thread_pool);
+	}
+	if (kepler_threshold > 0.0f) {
+		kepler_pairs.detect(bodies, settings.G, kepler_threshold, thread_pool);
+		std::erase_if(kepler_pairs.pairs, [&](const KeplerPair& pair) {
+			return regularized_groups.contains(pair.first) || regularized_groups.contains(pair.second);
+		});
+	}
+	if (kepler_pairs.pairs.empty() && regularized_groups.groups.empty()) {
+		analytic_bodies.clear();
+		integrate(bodies, settings, delta_time, thread_pool);
+		return;
+	}
+	analytic_bodies.assign(bodies.size(), false);
+	for (const KeplerPair& pair : kepler_pairs.pairs) {
+		analytic_bodies[pair.first] = true;
+		analytic_bodies[pair.second] = true;
+	}
+	for (const RegularizedGroup& group : regularized_groups.groups) {
+		for (const unsigned int i : group.members) analytic_bodies[i] = true;
+	}
+	kepler_pairs.save(bodies);
+	if (!regularized_groups.groups.empty()) regularized_groups.save(bodies);
+	// A system that is a single pair or group has nothing else to integrate: its center of mass moves in a straight line
+	const bool single_pair = kepler_pairs.pairs.size() == 1 && regularized_groups.groups.empty() && bodies.size() == 2;
+	const bool single_group = kepler_pairs.pairs.empty() && regularized_groups.groups.size() == 1
+		&& regularized_groups.groups[0].members.size() == bodies.size();
+	if (single_pair || single_group) bodies.drift(delta_time);
+	else integrate(bodies, settings, delta_time, thread_pool);
+	kepler_pairs.apply(bodies, settings.G, delta_time, thread_pool);
+	if (!regularized_groups.groups.empty()) regularized_groups.apply(bodies, settings.G, delta_time, thread_pool);
+	reset();
+	analytic_system = single_pair || single_group;
+	bodies.update_auxiliary_variables();
+}
+
+void Integrator::integrate(BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool) {
+	if (integrator_kind == IntegratorKind::hermite) {
+		hermite.step(bodies, settings.G, delta_time, thread_pool);
+		return;
+	}
+	if (integrator_kind == IntegratorKind::wisdom_holman) {
+		wisdom_holman.step(bodies, settings.G, settings.simd_level, delta_time, thread_pool);
+		return;
+	}
+	if (integrator_kind == IntegratorKind::euler) {
+		if (!forces_current) evaluate_forces(bodies, settings, thread_pool);
+		bodies.update_state(delta_time);
+		forces_current = false;
+		return;
+	}
+	for (const SplittingStep& operation : steps) {
+		const float weighted_time = static_cast<float>(operation.weight * delta_time);
+		if (operation.kick) {
+			if (!forces_current) evaluate_forces(bodies, settings, thread_pool);
+			bodies.kick(weighted_time);
+		}
+		else {
+			// Kicks change the velocities, so they are refreshed before every drift
+			bodies.update_auxiliary_variables();
+			bodies.drift(weighted_time);
+			forces_current = false;
+		}
+	}
+	bodies.update_auxiliary_variables();
+}
@@ -0,0 +1,189 @@
+#include <kepler/kepler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using std::vector;
+using glm::vec3, glm::quat;
+
+// Below this |z| the Stumpff functions come from their series, which the closed forms lose to cancellation
+constexpr double stumpff_series_limit = 1e-4;
+// Relative change of the universal anomaly at which the solver stops
+constexpr double kepler_tolerance = 1e-13;
+constexpr double kepler_two_pi = 6.283185307179586;
+
+void stumpff(const double z, double& c, double& s) {
+	if (std::abs(z) < stumpff_series_limit) {
+		c = 0.5 - z * (1.0 / 24.0 - z / 720.0);
+		s = 1.0 / 6.0 - z * (1.0 / 120.0 - z / 5040.0);
+	}
+	else if (z > 0.0) {
+		const double root = std::sqrt(z);
+		c = (1.0 - std::cos(root)) / z;
+		s = (root - std::sin(root)) / (z * root);
+	}
+	else {
+		const double root = std::sqrt(-z);
+		c = (std::cosh(root) - 1.0) / -z;
+		s = (std::sinh(root) - root) / (-z * root);
+	}
+}
+
+void kepler_drift(vec3& position, vec3& velocity, const float mu, const float delta_time) {
+	if (mu <= 0.0f || delta_time == 0.0f) {
+		position += velocity * delta_time;
+		return;
+	}
+	const double r0[3] = { position.x, position.y, position.z };
+	const double v0[3] = { velocity.x, velocity.y, velocity.z };
+	const double distance = std::sqrt(r0[0] * r0[0] + r0[1] * r0[1] + r0[2] * r0[2]);
+	if (distance == 0.0) return;
+	const double speed2 = v0[0] * v0[0] + v0[1] * v0[1] + v0[2] * v0[2];
+	const double radial = (r0[0] * v0[0] + r0[1] * v0[1] + r0[2] * v0[2]) / distance;
+	const double sqrt_mu = std::sqrt(static_cast<double>(mu));
+	// alpha = 1 / semi-major axis, positive for bound orbits
+	const double alpha = 2.0 / distance - speed2 / mu;
+
+	double time = delta_time;
+	if (alpha > 0.0) {
+		const double period = kepler_two_pi / (sqrt_mu * alpha * std::sqrt(alpha));
+		time = std::fmod(time, period);
+	}
+
+	// Universal Kepler equation F(x) = 0 for the universal anomaly x, solved with Laguerre's method (n = 5), which
+	// converges from the crude starting guesses below where Newton's method can cycle on hyperbolic orbits
+	const double a = distance * radial / sqrt_mu;
+	const double b = 1.0 - alpha * distance;
+	double x = alpha > 0.0 ? sqrt_mu * alpha * time : sqrt_mu * time / distance;
+	double c = 0.5, s = 1.0 / 6.0;
+	for (unsigned int iteration = 0; iteration < kepler_max_iterations; ++iteration) {
+		const double x2 = x * x;
+		const double z = alpha * x2;
+		stumpff(z, c, s);
+		const double f = a * x2 * c + b * x2 * x * s + distance * x - sqrt_mu * time;
+		const double df = a * x * (1.0 - z * s) + b * x2 * c + distance;
+		const double ddf = a * (1.0 - z * c) + b * x * (1.0 - z * s);
+		const double n = 5.0;
+		const double root = std::sqrt(std::abs((n - 1.0) * (n - 1.0) * df * df - n * (n - 1.0) * f * ddf));
+		const double denominator = df >= 0.0 ? df + root : df - root;
+		if (denominator == 0.0) break;
+		const double step = n * f / denominator;
+		x -= step;
+		if (std::abs(step) <= kepler_tolerance * std::max(1.0, std::abs(x))) break;
+	}
+	const double x2 = x * x;
+	stumpff(alpha * x2, c, s);
+
+	const double f = 1.0 - x2 / distance * c;
+	const double g = time - x2 * x / sqrt_mu * s;
+	double r[3];
+	for (int k = 0; k < 3; ++k) r[k] = f * r0[k] + g * v0[k];
+	const double new_distance = std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+	const double df = sqrt_mu / (new_distance * distance) * (alpha * x2 * x * s - x);
+	const double dg = 1.0 - x2 / new_distance * c;
+	position = vec3(static_cast<float>(r[0]), static_cast<float>(r[1]), static_cast<float>(r[2]));
+	velocity = vec3(
+		static_cast<float>(df * r0[0] + dg * v0[0]),
+		static_cast<float>(df * r0[1] + dg * v0[1]),
+		static_cast<float>(df * r0[2] + dg * v0[2]));
+}
+
+void kepler_drift(vector<vec3>& positions, vector<vec3>& velocities, const vector<float>& mus,
+	const float delta_time, ThreadPool& thread_pool) {
+	thread_pool.parallel_for(positions.size(), kepler_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			kepler_drift(positions[i], velocities[i], mus[i], delta_time);
+		}
+	});
+}
+
+void KeplerPairs::detect(const BodyStore& bodies, const float G, const float threshold, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	pairs.clear();
+	nearest.resize(n);
+	thread_pool.parallel_for(n, kepler_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			float closest = std::numeric_limits<float>::max();
+			nearest[i] = i;
+			for (unsigned int j = 0; j < n; ++j) {
+				const vec3 offset = bodies.positions[j] - bodies.positions[i];
+				const float distance2 = glm::dot(offset, offset);
+				if (j != i && distance2 < closest) {
+					closest = distance2;
+					nearest[i] = j;
+				}
+			}
+		}
+	});
+
+	for (unsigned int i = 0; i < n; ++i) {
+		const unsigned int j = nearest[i];
+		if (j <= i || nearest[j] != i) continue;
+		const float total_mass = bodies.masses[i] + bodies.masses[j];
+		const float mu = G * total_mass;
+		const vec3 r = bodies.positions[j] - bodies.positions[i];
+		const vec3 v = bodies.velocities[j] - bodies.velocities[i];
+		const float distance = glm::length(r);
+		const float energy = 0.5f * glm::dot(v, v) - mu / distance;
+		if (!(energy < 0.0f)) continue;
+		const float semi_major_axis = -mu / (2.0f * energy);
+		const vec3 h = glm::cross(r, v);
+		const float eccentricity = std::sqrt(std::max(0.0f, 1.0f + 2.0f * energy * glm::dot(h, h) / (mu * mu)));
+		const float apocenter = semi_major_axis * (1.0f + eccentricity);
+
+		const vec3 center = (bodies.masses[i] * bodies.positions[i] + bodies.masses[j] * bodies.positions[j]) / total_mass;
+		float tidal = 0.0f;
+		bool isolated = true;
+		for (unsigned int k = 0; k < n && isolated; ++k) {
+			if (k == i || k == j) continue;
+			const float distance_k = glm::length(bodies.positions[k] - center);
+			isolated = distance_k > kepler_isolation_ratio * apocenter;
+			tidal += 2.0f * G * bodies.masses[k] * apocenter / (distance_k * distance_k * distance_k);
+		}
+		if (isolated && tidal < threshold * mu / (apocenter * apocenter)) pairs.push_back({ i, j });
+	}
+}
+
+void KeplerPairs::save(const BodyStore& bodies) {
+	const unsigned int count = pairs.size();
+	relative_positions.resize(count);
+	relative_velocities.resize(count);
+	saved_angular_momenta.resize(2 * count);
+	saved_orientations.resize(2 * count);
+	for (unsigned int p = 0; p < count; ++p) {
+		const auto [i, j] = pairs[p];
+		relative_positions[p] = bodies.positions[j] - bodies.positions[i];
+		relative_velocities[p] = bodies.velocities[j] - bodies.velocities[i];
+		saved_angular_momenta[2 * p] = bodies.angular_momenta[i];
+		saved_angular_momenta[2 * p + 1] = bodies.angular_momenta[j];
+		saved_orientations[2 * p] = bodies.orientations[i];
+		saved_orientations[2 * p + 1] = bodies.orientations[j];
+	}
+}
+
+void KeplerPairs::apply(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool) {
+	const unsigned int count = pairs.size();
+	mus.resize(count);
+	for (unsigned int p = 0; p < count; ++p) {
+		mus[p] = G * (bodies.masses[pairs[p].first] + bodies.masses[pairs[p].second]);
+	}
+	kepler_drift(relative_positions, relative_velocities, mus, delta_time, thread_pool);
+	for (unsigned int p = 0; p < count; ++p) {
+		const auto [i, j] = pairs[p];
+		const float total_mass = bodies.masses[i] + bodies.masses[j];
+		const vec3 center = (bodies.masses[i] * bodies.positions[i] + bodies.masses[j] * bodies.positions[j]) / total_mass;
+		const vec3 center_velocity = (bodies.linear_momenta[i] + bodies.linear_momenta[j]) / total_mass;
+		const float share_i = bodies.masses[j] / total_mass, share_j = bodies.masses[i] / total_mass;
+		bodies.positions[i] = center - share_i * relative_positions[p];
+		bodies.positions[j] = center + share_j * relative_positions[p];
+		bodies.linear_momenta[i] = bodies.masses[i] * (center_velocity - share_i * relative_velocities[p]);
+		bodies.linear_momenta[j] = bodies.masses[j] * (center_velocity + share_j * relative_velocities[p]);
+		const unsigned int members[2] = { i, j };
+		for (unsigned int m = 0; m < 2; ++m) {
+			const unsigned int b = members[m];
+			bodies.angular_momenta[b] = saved_angular_momenta[2 * p + m];
+			bodies.orientations[b] = rotate_free_body(saved_orientations[2 * p + m], saved_angular_momenta[2 * p + m],
+				bodies.principal_moments[b], bodies.principal_frames[b], delta_time);
+		}
+	}
+}
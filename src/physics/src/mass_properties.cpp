@@ -0,0 +1,281 @@
+#include <mass_properties/mass_properties.hpp>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <utility>
+#include <iostream>
+
+using std::cerr, std::string, std::vector;
+using glm::mat3, glm::vec3, glm::quat;
+
+static_assert(std::is_trivially_copyable_v<MeshProperties>, "cache entries are written to disk as raw bytes");
+static_assert(std::is_trivially_copyable_v<vec3> && sizeof(vec3) == 3 * sizeof(float), "cache entries are written to disk as raw bytes");
+
+// Sweeps of Jacobi rotations after which principal_axes gives up. A 3x3 tensor converges in well under 10
+constexpr unsigned int max_jacobi_sweeps = 32;
+
+// Identifies cache files and their layout. Bump the version whenever an entry changes
+constexpr char cache_magic[4] = { 'M', 'P', 'C', '3' };
+
+MeshProperties compute_mesh_properties(const vector<vec3>& vertices) {
+	MeshProperties properties;
+
+	// Center of mass, from the signed volumes of the tetrahedra formed with the first vertex
+	float total_volume = 0.0f;
+	vec3 com_accumulator = vec3(0.0f);
+	const vec3 origin = vertices[0];
+	for (unsigned int i = 0; i < vertices.size(); i += 3) {
+		const vec3 a = vertices[i];
+		const vec3 b = vertices[i + 1];
+		const vec3 c = vertices[i + 2];
+		const float signed_volume = 0.16666f * glm::determinant(mat3(a - origin, b - origin, c - origin));
+		const vec3 centroid = (origin + a + b + c) * 0.25f;
+		total_volume += signed_volume;
+		com_accumulator += centroid * signed_volume;
+	}
+	properties.volume = total_volume;
+	properties.center_of_mass = com_accumulator / total_volume;
+
+	// Inertia tensor around the center of mass, from the covariance of the tetrahedra formed with it
+	using glm::outerProduct;
+	const vec3 com = properties.center_of_mass;
+	mat3 covariance_matrix = mat3(0.0f);
+	for (unsigned int i = 0; i < vertices.size(); i += 3) {
+		const vec3 a = vertices[i] - com;
+		const vec3 b = vertices[i + 1] - com;
+		const vec3 c = vertices[i + 2] - com;
+		const vec3 sum = a + b + c;
+		const float signed_volume = glm::determinant(mat3(a, b, c)) / 120.0f;
+		covariance_matrix += signed_volume * (outerProduct(a, a) + outerProduct(b, b) + outerProduct(c, c) + outerProduct(sum, sum));
+	}
+	const float trace = covariance_matrix[0][0] + covariance_matrix[1][1] + covariance_matrix[2][2];
+	properties.unit_inertia_tensor = trace * mat3(1.0f) - covariance_matrix;
+	properties.unit_inverse_inertia_tensor = glm::inverse(properties.unit_inertia_tensor);
+	principal_axes(properties.unit_inertia_tensor, properties.unit_principal_moments, properties.principal_frame);
+	return properties;
+}
+
+void principal_axes(const mat3& tensor, vec3& moments, quat& frame) {
+	// Row major copies in double: a is diagonalized in place, v accumulates the rotations
+	double a[3][3], v[3][3];
+	for (int row = 0; row < 3; ++row) {
+		for (int column = 0; column < 3; ++column) {
+			a[row][column] = tensor[column][row];
+			v[row][column] = row == column ? 1.0 : 0.0;
+		}
+	}
+	const int pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+	for (unsigned int sweep = 0; sweep < max_jacobi_sweeps; ++sweep) {
+		const double diagonal = std::abs(a[0][0]) + std::abs(a[1][1]) + std::abs(a[2][2]);
+		const double off_diagonal = std::abs(a[0][1]) + std::abs(a[0][2]) + std::abs(a[1][2]);
+		if (off_diagonal <= 1e-15 * diagonal) break;
+		for (const auto& [p, q] : pairs) {
+			if (a[p][q] == 0.0) continue;
+			// Rotation in the (p, q) plane zeroing a[p][q], using the smaller root for stability
+			const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+			const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+			const double c = 1.0 / std::sqrt(t * t + 1.0);
+			const double s = t * c;
+			for (int k = 0; k < 3; ++k) {
+				const double akp = a[k][p], akq = a[k][q];
+				a[k][p] = c * akp - s * akq;
+				a[k][q] = s * akp + c * akq;
+			}
+			for (int k = 0; k < 3; ++k) {
+				const double apk = a[p][k], aqk = a[q][k];
+				a[p][k] = c * apk - s * aqk;
+				a[q][k] = s * apk + c * aqk;
+			}
+			for (int k = 0; k < 3; ++k) {
+				const double vkp = v[k][p], vkq = v[k][q];
+				v[k][p] = c * vkp - s * vkq;
+				v[k][q] = s * vkp + c * vkq;
+			}
+		}
+	}
+	// The columns of v are the principal axes. Flipping one keeps the frame a rotation
+	mat3 axes;
+	for (int column = 0; column < 3; ++column) {
+		moments[column] = static_cast<float>(a[column][column]);
+		for (int row = 0; row < 3; ++row) {
+			axes[column][row] = static_cast<float>(v[row][column]);
+		}
+	}
+	if (glm::determinant(axes) < 0.0f) axes[2] = -axes[2];
+	frame = glm::normalize(glm::quat_cast(axes));
+}
+
+MassProperties scale_mass_properties(const MeshProperties& properties, const float density) {
+	return MassProperties{
+		properties.volume * density,
+		properties.volume,
+		properties.center_of_mass,
+		density * properties.unit_inertia_tensor,
+		properties.unit_inverse_inertia_tensor / density,
+		density * properties.unit_principal_moments,
+		properties.principal_frame
+	};
+}
+
+bool MassPropertyCache::Key::operator==(const Key& other) const {
+	return hash == other.hash && vertex_count == other.vertex_count;
+}
+
+std::size_t MassPropertyCache::KeyHash::operator()(const Key& key) const {
+	return static_cast<std::size_t>(key.hash ^ (static_cast<std::uint64_t>(key.vertex_count) << 32));
+}
+
+MassPropertyCache::Key MassPropertyCache::make_key(const vector<vec3>& vertices) {
+	// 64 bit FNV-1a over the raw bytes of the coordinates
+	std::uint64_t hash = 14695981039346656037ull;
+	for (const vec3& v : vertices) {
+		const float coordinates[3] = { v.x, v.y, v.z };
+		unsigned char bytes[sizeof(coordinates)];
+		std::memcpy(bytes, coordinates, sizeof(coordinates));
+		for (const unsigned char byte : bytes) {
+			hash ^= byte;
+			hash *= 1099511628211ull;
+		}
+	}
+	return Key{ hash, static_cast<std::uint32_t>(vertices.size()) };
+}
+
+const MassPropertyCache::Entry* MassPropertyCache::find(const Key& key, const vector<vec3>& vertices) const {
+	const auto found = entries.find(key);
+	if (found == entries.end()) return nullptr;
+	for (const Entry& entry : found->second) {
+		if (std::memcmp(entry.vertices.data(), vertices.data(), vertices.size() * sizeof(vec3)) == 0) return &entry;
+	}
+	return nullptr;
+}
+
+MeshProperties MassPropertyCache::get(const vector<vec3>& vertices) {
+	const Key key = make_key(vertices);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (const Entry* entry = find(key, vertices)) {
+			++hit_count;
+			return entry->properties;
+		}
+		++miss_count;
+	}
+	// Computed outside the lock so other threads are not held up by a large mesh
+	const MeshProperties properties = compute_mesh_properties(vertices);
+	std::lock_guard<std::mutex> lock(mutex);
+	// Another thread may have added the same mesh meanwhile
+	if (!find(key, vertices)) {
+		entries[key].push_back(Entry{ vertices, properties });
+		++entry_count;
+	}
+	return properties;
+}
+
+MassProperties MassPropertyCache::get(const vector<vec3>& vertices, const float density) {
+	return scale_mass_properties(get(vertices), density);
+}
+
+unsigned int MassPropertyCache::size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return entry_count;
+}
+
+unsigned int MassPropertyCache::hits() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return hit_count;
+}
+
+unsigned int MassPropertyCache::misses() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return miss_count;
+}
+
+void MassPropertyCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	entry_count = 0;
+	hit_count = 0;
+	miss_count = 0;
+}
+
+bool MassPropertyCache::load(const string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		cerr << "Error at MassPropertyCache::load: could not open " << path << "\n";
+		return false;
+	}
+	char magic[sizeof(cache_magic)];
+	std::uint64_t count = 0;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&count), sizeof(count));
+	if (!file || std::memcmp(magic, cache_magic, sizeof(magic)) != 0) {
+		cerr << "Error at MassPropertyCache::load: " << path << " is not a mass property cache\n";
+		return false;
+	}
+	// The count comes from the file: it must fit in what is left of it before anything is allocated
+	const std::streampos entries_begin = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::uint64_t remaining = static_cast<std::uint64_t>(file.tellg() - entries_begin);
+	file.seekg(entries_begin);
+	constexpr std::uint64_t fixed_entry_size = sizeof(Key::hash) + sizeof(Key::vertex_count) + sizeof(MeshProperties);
+	if (!file || count > remaining / fixed_entry_size) {
+		cerr << "Error at MassPropertyCache::load: " << path << " is truncated\n";
+		return false;
+	}
+	vector<std::pair<Key, Entry>> loaded(count);
+	for (auto& [key, entry] : loaded) {
+		file.read(reinterpret_cast<char*>(&key.hash), sizeof(key.hash));
+		file.read(reinterpret_cast<char*>(&key.vertex_count), sizeof(key.vertex_count));
+		const std::uint64_t vertex_bytes = static_cast<std::uint64_t>(key.vertex_count) * sizeof(vec3);
+		if (!file || vertex_bytes + fixed_entry_size > remaining) {
+			cerr << "Error at MassPropertyCache::load: " << path << " is truncated\n";
+			return false;
+		}
+		remaining -= vertex_bytes + fixed_entry_size;
+		entry.vertices.resize(key.vertex_count);
+		file.read(reinterpret_cast<char*>(entry.vertices.data()), vertex_bytes);
+		file.read(reinterpret_cast<char*>(&entry.properties), sizeof(entry.properties));
+		if (!file) {
+			cerr << "Error at MassPropertyCache::load: " << path << " is truncated\n";
+			return false;
+		}
+		// The key is checked like a hit would be, so a damaged entry can't be served for another mesh
+		if (!(make_key(entry.vertices) == key)) {
+			cerr << "Error at MassPropertyCache::load: " << path << " is corrupt\n";
+			return false;
+		}
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& [key, entry] : loaded) {
+		if (find(key, entry.vertices)) continue;
+		entries[key].push_back(std::move(entry));
+		++entry_count;
+	}
+	return true;
+}
+
+bool MassPropertyCache::save(const string& path) const {
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		cerr << "Error at MassPropertyCache::save: could not open " << path << "\n";
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	const std::uint64_t count = entry_count;
+	file.write(cache_magic, sizeof(cache_magic));
+	file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	for (const auto& [key, meshes] : entries) {
+		for (const Entry& entry : meshes) {
+			file.write(reinterpret_cast<const char*>(&key.hash), sizeof(key.hash));
+			file.write(reinterpret_cast<const char*>(&key.vertex_count), sizeof(key.vertex_count));
+			file.write(reinterpret_cast<const char*>(entry.vertices.data()), entry.vertices.size() * sizeof(vec3));
+			file.write(reinterpret_cast<const char*>(&entry.properties), sizeof(entry.properties));
+		}
+	}
+	return static_cast<bool>(file);
+}
+
+MassPropertyCache& mass_property_cache() {
+	static MassPropertyCache cache;
+	return cache;
+}
@@ -0,0 +1,70 @@
+#include <mesh_asset/mesh_asset.hpp>
+#include <algorithm>
+#include <utility>
+#include <mesh_multipole/mesh_multipole.hpp>
+
+using std::vector;
+using glm::vec3;
+
+float mesh_bounding_radius(const vector<vec3>& vertices) {
+	float radius = 0.0f;
+	for (const vec3& v : vertices) {
+		radius = std::max(radius, glm::length(v));
+	}
+	return radius;
+}
+
+MeshAsset make_mesh_asset(const vector<vec3>& vertices) {
+	MeshAsset asset;
+	asset.vertices = vertices;
+	asset.properties = mass_property_cache().get(vertices);
+	for (auto& v : asset.vertices) {
+		v -= asset.properties.center_of_mass;
+	}
+	asset.bounding_radius = mesh_bounding_radius(asset.vertices);
+	return asset;
+}
+
+unsigned int MeshRegistry::size() const {
+	return assets.size();
+}
+
+MeshHandle MeshRegistry::add(const vector<vec3>& vertices) {
+	return add(make_mesh_asset(vertices));
+}
+
+MeshHandle MeshRegistry::add(MeshAsset asset) {
+	compute_multipoles(asset);
+	compute_polyhedron(asset);
+	assets.push_back(std::move(asset));
+	return assets.size() - 1;
+}
+
+const MeshAsset& MeshRegistry::get(const MeshHandle handle) const {
+	return assets[handle];
+}
+
+void MeshRegistry::set_multipole_order(const unsigned int order) {
+	multipole_order = order;
+	for (MeshAsset& asset : assets) {
+		compute_multipoles(asset);
+	}
+}
+
+void MeshRegistry::compute_multipoles(MeshAsset& asset) const {
+	if (multipole_order == 0 || asset.multipole_order >= multipole_order) return;
+	asset.multipoles = compute_mesh_multipoles(asset.vertices, multipole_order);
+	asset.multipole_order = multipole_order;
+}
+
+void MeshRegistry::set_polyhedron_models(const bool enabled) {
+	polyhedron_models = enabled;
+	for (MeshAsset& asset : assets) {
+		compute_polyhedron(asset);
+	}
+}
+
+void MeshRegistry::compute_polyhedron(MeshAsset& asset) const {
+	if (!polyhedron_models || !asset.polyhedron.empty()) return;
+	asset.polyhedron.build(asset.vertices);
+}
@@ -0,0 +1,172 @@
+#include <mesh_multipole/mesh_multipole.hpp>
+#include <algorithm>
+#include <cmath>
+
+using std::vector;
+using glm::mat3, glm::vec3;
+
+/// <summary>
+/// Expands products of linear forms: out[n * size + m] is the coefficient of u^m in the product over every axis a of
+/// (rows[a][0] u_0 + rows[a][1] u_1 + rows[a][2] u_2)^n_a
+/// </summary>
+static void linear_form_powers(const MultiIndexTable& table, const double rows[3][3], vector<double>& out) {
+	const unsigned int size = table.size;
+	out.assign(size * size, 0.0);
+	out[0] = 1.0;
+	for (unsigned int n = 1; n < size; ++n) {
+		// Built from the multi-index with one unit less on its first non-zero axis
+		auto lower = table.indices[n];
+		unsigned int axis = 0;
+		while (lower[axis] == 0) ++axis;
+		--lower[axis];
+		const double* parent = &out[table.index(lower[0], lower[1], lower[2]) * size];
+		double* product = &out[n * size];
+		for (unsigned int m = 0; m < size; ++m) {
+			if (parent[m] == 0.0) continue;
+			const auto& k = table.indices[m];
+			product[table.index(k[0] + 1, k[1], k[2])] += parent[m] * rows[axis][0];
+			product[table.index(k[0], k[1] + 1, k[2])] += parent[m] * rows[axis][1];
+			product[table.index(k[0], k[1], k[2] + 1)] += parent[m] * rows[axis][2];
+		}
+	}
+}
+
+vector<double> compute_mesh_multipoles(const vector<vec3>& vertices, const unsigned int order) {
+	const MultiIndexTable table(order);
+	const unsigned int size = table.size;
+	// a! b! c! / (a + b + c + 3)!, the integral of a barycentric monomial over a tetrahedron divided by 6 times its volume
+	vector<double> factorials(order + 4, 1.0);
+	for (unsigned int i = 1; i < factorials.size(); ++i) factorials[i] = factorials[i - 1] * i;
+	vector<double> weights(size);
+	for (unsigned int m = 0; m < size; ++m) {
+		const auto& k = table.indices[m];
+		weights[m] = factorials[k[0]] * factorials[k[1]] * factorials[k[2]] / factorials[table.degrees[m] + 3];
+	}
+
+	vector<double> moments(size, 0.0), powers;
+	for (unsigned int t = 0; t + 2 < vertices.size(); t += 3) {
+		const vec3& a = vertices[t];
+		const vec3& b = vertices[t + 1];
+		const vec3& c = vertices[t + 2];
+		// Signed volume of the tetrahedron (origin, a, b, c), times 6
+		const double six_volume = glm::dot(a, glm::cross(b, c));
+		// x = a l1 + b l2 + c l3 in barycentric coordinates
+		const double rows[3][3] = { { a.x, b.x, c.x }, { a.y, b.y, c.y }, { a.z, b.z, c.z } };
+		linear_form_powers(table, rows, powers);
+		for (unsigned int n = 0; n < size; ++n) {
+			double sum = 0.0;
+			for (unsigned int m = 0; m < size; ++m) sum += powers[n * size + m] * weights[m];
+			moments[n] += six_volume * sum;
+		}
+	}
+	return moments;
+}
+
+void rotate_multipoles(const MultiIndexTable& table, const mat3& rotation, const double* moments, double* rotated, vector<double>& scratch) {
+	// (R x)_a = sum_j R[j][a] x_j, glm indexes [column][row]
+	double rows[3][3];
+	for (unsigned int a = 0; a < 3; ++a) {
+		for (unsigned int j = 0; j < 3; ++j) rows[a][j] = rotation[j][a];
+	}
+	linear_form_powers(table, rows, scratch);
+	const unsigned int size = table.size;
+	for (unsigned int n = 0; n < size; ++n) {
+		double sum = 0.0;
+		for (unsigned int m = 0; m < size; ++m) sum += scratch[n * size + m] * moments[m];
+		rotated[n] = sum;
+	}
+}
+
+void accumulate_mesh_multipole_gravity(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	if (settings.mesh_multipole_order == 0 || n < 2) return;
+	const MultiIndexTable table(std::clamp(settings.mesh_multipole_order, min_multipole_order, max_multipole_order));
+	const unsigned int size = table.size;
+	const float G = settings.G;
+	auto has_moments = [&](const unsigned int i) {
+		return bodies.meshes.get(bodies.shapes[i].mesh).multipole_order >= table.order;
+	};
+	auto bounding_radius = [&](const unsigned int i) {
+		return bodies.meshes.get(bodies.shapes[i].mesh).bounding_radius;
+	};
+
+	vector<vector<unsigned int>> neighbours(n);
+	thread_pool.parallel_for(n, force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			if (!has_moments(i)) continue;
+			for (unsigned int j = 0; j < n; ++j) {
+				if (j == i || !has_moments(j)) continue;
+				// Small bodies close to a polyhedron feel its exact field instead
+				if (polyhedron_pair(bodies, settings, i, j) || polyhedron_pair(bodies, settings, j, i)) continue;
+				const float reach = bounding_radius(i) + bounding_radius(j);
+				const float distance = glm::length(bodies.positions[j] - bodies.positions[i]);
+				if (distance > reach && distance < settings.mesh_multipole_range * reach) neighbours[i].push_back(j);
+			}
+		}
+	});
+
+	// World frame mass moments of every body taking part, around its center of mass. Pairs are symmetric, so having
+	// neighbours is enough
+	vector<double> moments(n * size, 0.0);
+	thread_pool.parallel_for(n, force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		vector<double> scratch, body_moments(size);
+		for (unsigned int i = begin; i < end; ++i) {
+			if (neighbours[i].empty()) continue;
+			const MeshAsset& mesh = bodies.meshes.get(bodies.shapes[i].mesh);
+			for (unsigned int m = 0; m < size; ++m) body_moments[m] = bodies.shapes[i].density * mesh.multipoles[m];
+			rotate_multipoles(table, bodies.rotation_matrices[i], body_moments.data(), &moments[i * size], scratch);
+		}
+	});
+
+	thread_pool.parallel_for(n, force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		vector<double> derivatives(size), source(size), local(size);
+		for (unsigned int i = begin; i < end; ++i) {
+			if (neighbours[i].empty()) continue;
+			const double* target = &moments[i * size];
+			double force[3] = { 0.0, 0.0, 0.0 }, torque[3] = { 0.0, 0.0, 0.0 };
+			vec3 point_force = vec3(0.0f), point_torque = vec3(0.0f);
+			for (const unsigned int j : neighbours[i]) {
+				const vec3 r = bodies.positions[i] - bodies.positions[j];
+				const double R[3] = { r.x, r.y, r.z };
+				table.derivatives(R, derivatives.data());
+				// The potential expansions take moments of the offsets from the point to the center, hence the sign
+				for (unsigned int m = 0; m < size; ++m) {
+					source[m] = (table.degrees[m] % 2 == 0 ? G : -G) * moments[j * size + m];
+				}
+				// Local expansion of the source's potential around the target's center of mass
+				for (unsigned int k = 0; k < size; ++k) {
+					double sum = 0.0;
+					for (unsigned int t = table.interaction_begin[k]; t < table.interaction_begin[k + 1]; ++t) {
+						const InteractionTerm& term = table.interaction_terms[t];
+						sum += term.binomial * source[term.multipole] * derivatives[term.derivative];
+					}
+					local[k] = sum;
+				}
+				// The target's mass moments against the gradient of the local expansion:
+				// F_a = sum_k k_a L_k N_(k - e_a) and tau_i = e_iab sum_k k_b L_k N_(k - e_b + e_a)
+				for (unsigned int k = 1; k < size; ++k) {
+					const auto& index = table.indices[k];
+					for (unsigned int b = 0; b < 3; ++b) {
+						if (index[b] == 0) continue;
+						auto lower = index;
+						--lower[b];
+						force[b] += index[b] * local[k] * target[table.index(lower[0], lower[1], lower[2])];
+						for (unsigned int a = 0; a < 3; ++a) {
+							if (a == b) continue;
+							auto moved = lower;
+							++moved[a];
+							// e_iab is +1 for (a, b) = (i + 1, i + 2) and -1 for (i + 2, i + 1)
+							const unsigned int axis = 3 - a - b;
+							const double sign = (a == (axis + 1) % 3) ? 1.0 : -1.0;
+							torque[axis] += sign * index[b] * local[k] * target[table.index(moved[0], moved[1], moved[2])];
+						}
+					}
+				}
+				point_force += gravity_force(bodies.masses[i], -r, G * bodies.masses[j]);
+				point_torque += gravity_torque(bodies.world_inertias[i], -r, G * bodies.masses[j]);
+			}
+			bodies.forces[i] += vec3(static_cast<float>(force[0]), static_cast<float>(force[1]), static_cast<float>(force[2])) - point_force;
+			bodies.torques[i] += vec3(static_cast<float>(torque[0]), static_cast<float>(torque[1]), static_cast<float>(torque[2])) - point_torque;
+		}
+	});
+}
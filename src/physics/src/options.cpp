@@ -0,0 +1,216 @@
+#include <options/options.hpp>
+#include <cmath>
+#include <iostream>
+#include <fft/fft.hpp>
+#include <fmm/fmm.hpp>
+#include <particle_mesh/particle_mesh.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+using std::cerr, std::string;
+
+const char* solver_name(const GravitySolver solver) {
+	switch (solver) {
+	case GravitySolver::direct: return "direct";
+	case GravitySolver::symmetric: return "symmetric";
+	case GravitySolver::barnes_hut: return "barnes-hut";
+	case GravitySolver::fmm: return "fmm";
+	case GravitySolver::particle_mesh: return "pm";
+	case GravitySolver::p3m: return "p3m";
+	}
+	return "unknown";
+}
+
+const char* integrator_name(const IntegratorKind integrator) {
+	switch (integrator) {
+	case IntegratorKind::euler: return "euler";
+	case IntegratorKind::leapfrog: return "leapfrog";
+	case IntegratorKind::yoshida4: return "yoshida4";
+	case IntegratorKind::yoshida6: return "yoshida6";
+	case IntegratorKind::forest_ruth: return "forest-ruth";
+	case IntegratorKind::hermite: return "hermite";
+	case IntegratorKind::wisdom_holman: return "wisdom-holman";
+	}
+	return "unknown";
+}
+
+const char* scenario_name(const ScenarioKind scenario) {
+	switch (scenario) {
+	case ScenarioKind::two_body: return "two-body";
+	case ScenarioKind::cloud: return "cloud";
+	case ScenarioKind::planetary: return "planetary";
+	}
+	return "unknown";
+}
+
+/// <summary>
+/// Reads an integrator name as printed by integrator_name
+/// </summary>
+/// <returns>false if the name is unknown. The error is printed to cerr</returns>
+static bool parse_integrator(const string& value, IntegratorKind& integrator) {
+	if (value == "euler") integrator = IntegratorKind::euler;
+	else if (value == "leapfrog") integrator = IntegratorKind::leapfrog;
+	else if (value == "yoshida4") integrator = IntegratorKind::yoshida4;
+	else if (value == "yoshida6") integrator = IntegratorKind::yoshida6;
+	else if (value == "forest-ruth") integrator = IntegratorKind::forest_ruth;
+	else if (value == "hermite") integrator = IntegratorKind::hermite;
+	else if (value == "wisdom-holman") integrator = IntegratorKind::wisdom_holman;
+	else {
+		cerr << "Error at parse_simulation_options: unknown integrator " << value << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool parse_simulation_options(const int argc, char* argv[], SimulationOptions& options) {
+	if (argc % 2 == 0) {
+		cerr << "Error at parse_simulation_options: missing value for " << argv[argc - 1] << "\n";
+		return false;
+	}
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const string key = argv[i];
+		const string value = argv[i + 1];
+		try {
+			if (key == "--solver") {
+				if (value == "direct") options.gravity.solver = GravitySolver::direct;
+				else if (value == "symmetric") options.gravity.solver = GravitySolver::symmetric;
+				else if (value == "barnes-hut") options.gravity.solver = GravitySolver::barnes_hut;
+				else if (value == "fmm") options.gravity.solver = GravitySolver::fmm;
+				else if (value == "pm") options.gravity.solver = GravitySolver::particle_mesh;
+				else if (value == "p3m") options.gravity.solver = GravitySolver::p3m;
+				else {
+					cerr << "Error at parse_simulation_options: unknown solver " << value << "\n";
+					return false;
+				}
+			}
+			else if (key == "--theta") options.gravity.opening_angle = std::stof(value);
+			else if (key == "--order") options.gravity.multipole_order = std::stoul(value);
+			else if (key == "--mesh-order") {
+				options.gravity.mesh_multipole_order = std::stoul(value);
+				if (options.gravity.mesh_multipole_order == 1 || options.gravity.mesh_multipole_order > max_multipole_order) {
+					cerr << "Error at parse_simulation_options: mesh multipole order must be 0 or between " << min_multipole_order
+						<< " and " << max_multipole_order << "\n";
+					return false;
+				}
+			}
+			else if (key == "--mesh-range") options.gravity.mesh_multipole_range = std::stof(value);
+			else if (key == "--polyhedron") options.gravity.polyhedron_range = std::stof(value);
+			else if (key == "--mesh") {
+				options.gravity.mesh_size = std::stoul(value);
+				if (!is_power_of_two(options.gravity.mesh_size) || options.gravity.mesh_size < min_mesh_size) {
+					cerr << "Error at parse_simulation_options: mesh size must be a power of two no smaller than " << min_mesh_size << "\n";
+					return false;
+				}
+			}
+			else if (key == "--boundary") {
+				if (value == "periodic") options.gravity.mesh_boundary = MeshBoundary::periodic;
+				else if (value == "isolated") options.gravity.mesh_boundary = MeshBoundary::isolated;
+				else {
+					cerr << "Error at parse_simulation_options: unknown boundary " << value << "\n";
+					return false;
+				}
+			}
+			else if (key == "--assignment") {
+				if (value == "cic") options.gravity.mass_assignment = MassAssignment::cic;
+				else if (value == "tsc") options.gravity.mass_assignment = MassAssignment::tsc;
+				else {
+					cerr << "Error at parse_simulation_options: unknown mass assignment " << value << "\n";
+					return false;
+				}
+			}
+			else if (key == "--box") options.gravity.mesh_box_size = std::stof(value);
+			else if (key == "--split") {
+				options.gravity.p3m_split_radius = std::stof(value);
+				if (!(options.gravity.p3m_split_radius > 0.0f)) {
+					cerr << "Error at parse_simulation_options: split radius must be positive\n";
+					return false;
+				}
+			}
+			else if (key == "--threads") {
+				// Parsed signed, std::stoul would wrap "-1" around to billions of threads
+				const long thread_count = std::stol(value);
+				if (thread_count < 0 || thread_count > static_cast<long>(max_thread_count())) {
+					cerr << "Error at parse_simulation_options: thread count must be between 0 and " << max_thread_count() << "\n";
+					return false;
+				}
+				options.thread_count = static_cast<unsigned int>(thread_count);
+			}
+			else if (key == "--simd") {
+				if (value == "scalar") options.gravity.simd_level = SimdLevel::scalar;
+				else if (value == "sse4.2") options.gravity.simd_level = SimdLevel::sse42;
+				else if (value == "avx2") options.gravity.simd_level = SimdLevel::avx2;
+				else if (value == "avx512") options.gravity.simd_level = SimdLevel::avx512;
+				else {
+					cerr << "Error at parse_simulation_options: unknown instruction set " << value << "\n";
+					return false;
+				}
+			}
+			else if (key == "--scenario") {
+				if (value == "two-body") options.scenario = ScenarioKind::two_body;
+				else if (value == "cloud") options.scenario = ScenarioKind::cloud;
+				else if (value == "planetary") options.scenario = ScenarioKind::planetary;
+				else {
+					cerr << "Error at parse_simulation_options: unknown scenario " << value << "\n";
+					return false;
+				}
+			}
+			else if (key == "--bodies") options.body_count = std::stoul(value);
+			else if (key == "--seed") options.seed = std::stoul(value);
+			else if (key == "--tracers") options.tracer_count = std::stoul(value);
+			else if (key == "--integrator") {
+				if (!parse_integrator(value, options.integrator)) return false;
+			}
+			else if (key == "--kepler") options.kepler_threshold = std::stof(value);
+			else if (key == "--regularize") options.regularization_radius = std::stof(value);
+			else if (key == "--dt") {
+				options.delta_time = std::stof(value);
+				// The physics thread divides its accumulated time by the step: 0 never advances, negative ones run backwards
+				if (!(options.delta_time > 0.0f) || std::isinf(options.delta_time)) {
+					cerr << "Error at parse_simulation_options: time step must be positive and finite\n";
+					return false;
+				}
+			}
+			else if (key == "--adaptive") {
+				options.step_control.adaptive = true;
+				options.step_control.tolerance = std::stof(value);
+				if (!(options.step_control.tolerance > 0.0f)) {
+					cerr << "Error at parse_simulation_options: tolerance must be positive\n";
+					return false;
+				}
+			}
+			else if (key == "--min-dt") options.step_control.min_step = std::stof(value);
+			else if (key == "--max-dt") options.step_control.max_step = std::stof(value);
+			else if (key == "--steps") options.step_count = std::stoul(value);
+			else if (key == "--parareal") options.parareal.slice_count = std::stoul(value);
+			else if (key == "--coarse-integrator") {
+				if (!parse_integrator(value, options.parareal.coarse_integrator)) return false;
+			}
+			else if (key == "--parareal-tolerance") options.parareal.tolerance = std::stof(value);
+			else if (key == "--coarse-ratio") {
+				options.parareal.coarse_ratio = std::stoul(value);
+				if (options.parareal.coarse_ratio == 0) {
+					cerr << "Error at parse_simulation_options: coarse ratio must be positive\n";
+					return false;
+				}
+			}
+			else if (key == "--time-scale") {
+				options.time_scale = std::stof(value);
+				// The physics thread divides its sleep by the scale: 0 would sleep forever, negative ones spin
+				if (!(options.time_scale > 0.0f) || std::isinf(options.time_scale)) {
+					cerr << "Error at parse_simulation_options: time scale must be positive and finite\n";
+					return false;
+				}
+			}
+			else if (key == "--output") options.output_path = value;
+			else if (key == "--mass-cache") options.mass_cache_path = value;
+			else {
+				cerr << "Error at parse_simulation_options: unknown argument " << key << "\n";
+				return false;
+			}
+		}
+		catch (const std::exception&) {
+			cerr << "Error at parse_simulation_options: invalid value " << value << " for " << key << "\n";
+			return false;
+		}
+	}
+	return true;
+}
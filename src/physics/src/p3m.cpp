@@ -0,0 +1,166 @@
+#include <p3m/p3m.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using std::array, std::vector;
+using glm::vec3;
+
+// Amount of intervals of the tables of short-range factors, which are sampled uniformly in x^2
+constexpr unsigned int short_range_table_size = 1024;
+
+/// <summary>
+/// Shares of the point mass force and of the anisotropic part of its tidal tensor carried by the short-range
+/// potential -erfc(x) / r, where x = r / 2 r_s, tabulated up to the cutoff since erfc dominates the pair loop
+/// </summary>
+struct ShortRangeTable {
+	array<float, short_range_table_size + 2> force, tidal;
+	// Table intervals per unit of x^2
+	float scale;
+};
+
+static const ShortRangeTable& short_range_table() {
+	static const ShortRangeTable table = []() {
+		ShortRangeTable result;
+		const double end = 0.25 * p3m_cutoff_ratio * p3m_cutoff_ratio;
+		result.scale = static_cast<float>(short_range_table_size / end);
+		for (unsigned int i = 0; i < short_range_table_size + 2; ++i) {
+			const double x2 = i * end / short_range_table_size;
+			const double x = std::sqrt(x2);
+			const double gaussian = 1.1283791670955126 * x * std::exp(-x2);
+			const double complement = std::erfc(x);
+			result.force[i] = static_cast<float>(complement + gaussian);
+			result.tidal[i] = static_cast<float>(complement + gaussian * (1.0 + 2.0 / 3.0 * x2));
+		}
+		return result;
+	}();
+	return table;
+}
+
+ParticleParticleMesh::ParticleParticleMesh(const unsigned int mesh_size, const MeshBoundary boundary, const MassAssignment assignment,
+	const float box_size, const float split_radius) : mesh(mesh_size, boundary, assignment, box_size, split_radius) {
+	this->split_radius = 0.0f;
+	this->cutoff = 0.0f;
+	this->cell_origin = vec3(0.0f);
+	this->cell_side = 1.0f;
+	this->cell_counts[0] = this->cell_counts[1] = this->cell_counts[2] = 1;
+}
+
+void ParticleParticleMesh::accumulate_gravity(BodyStore& bodies, const float G, ThreadPool& thread_pool) {
+	if (bodies.size() == 0) return;
+	// The mesh fits its grid first, which fixes the cell size the split radius is measured in
+	mesh.accumulate_gravity(bodies, G, thread_pool);
+	split_radius = mesh.split_radius * mesh.cell_size;
+	cutoff = p3m_cutoff_ratio * split_radius;
+	build_cells(bodies);
+	accumulate_short_range(bodies, G, thread_pool);
+}
+
+void ParticleParticleMesh::cell_coordinates(const vec3& position, int coordinates[3]) const {
+	const vec3 u = (position - cell_origin) / cell_side;
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		const int count = cell_counts[axis];
+		const int c = static_cast<int>(std::floor(u[axis]));
+		coordinates[axis] = mesh.boundary == MeshBoundary::periodic ? ((c % count) + count) % count : std::clamp(c, 0, count - 1);
+	}
+}
+
+void ParticleParticleMesh::build_cells(const BodyStore& bodies) {
+	// The cells tile the mesh box with sides no smaller than cutoff / p3m_cell_reach, so neighbours are at most
+	// p3m_cell_reach cells away along every axis
+	const float box = mesh.size * mesh.cell_size;
+	const unsigned int count = std::max(1u, static_cast<unsigned int>(p3m_cell_reach * box / cutoff));
+	cell_origin = mesh.origin;
+	cell_side = box / count;
+	cell_counts[0] = cell_counts[1] = cell_counts[2] = count;
+
+	const unsigned int n = bodies.size();
+	vector<unsigned int> cells(n);
+	cell_begin.assign(count * count * count + 1, 0);
+	for (unsigned int i = 0; i < n; ++i) {
+		int c[3];
+		cell_coordinates(bodies.positions[i], c);
+		cells[i] = (c[2] * count + c[1]) * count + c[0];
+		++cell_begin[cells[i] + 1];
+	}
+	for (unsigned int c = 0; c + 1 < cell_begin.size(); ++c) {
+		cell_begin[c + 1] += cell_begin[c];
+	}
+	vector<unsigned int> cursor(cell_begin.begin(), cell_begin.end() - 1);
+	cell_bodies.resize(n);
+	cell_positions.resize(n);
+	cell_masses.resize(n);
+	for (unsigned int i = 0; i < n; ++i) {
+		const unsigned int k = cursor[cells[i]]++;
+		cell_bodies[k] = i;
+		cell_positions[k] = bodies.positions[i];
+		cell_masses[k] = bodies.masses[i];
+	}
+}
+
+void ParticleParticleMesh::accumulate_short_range(BodyStore& bodies, const float G, ThreadPool& thread_pool) const {
+	const bool periodic = mesh.boundary == MeshBoundary::periodic;
+	const float box = cell_side * cell_counts[0];
+	const float cutoff2 = cutoff * cutoff;
+	const ShortRangeTable& table = short_range_table();
+	// Converts a squared distance into a position in the tables
+	const float table_scale = table.scale / (4.0f * split_radius * split_radius);
+	const unsigned int cell_count = cell_counts[0] * cell_counts[1] * cell_counts[2];
+	// Bodies of a cell share their neighbours, so tasks take whole cells and read the neighbours from the cell-sorted copies
+	thread_pool.parallel_for(cell_count, p3m_cell_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int cell = begin; cell < end; ++cell) {
+			if (cell_begin[cell] == cell_begin[cell + 1]) continue;
+			const int center[3] = {
+				static_cast<int>(cell % cell_counts[0]),
+				static_cast<int>(cell / cell_counts[0] % cell_counts[1]),
+				static_cast<int>(cell / (cell_counts[0] * cell_counts[1]))
+			};
+			// Cells within reach along every axis. Small periodic grids would visit a cell twice, so wrapped duplicates are dropped
+			const int reach = p3m_cell_reach;
+			int neighbours[3][2 * p3m_cell_reach + 1];
+			unsigned int neighbour_counts[3];
+			for (unsigned int axis = 0; axis < 3; ++axis) {
+				const int count = cell_counts[axis];
+				neighbour_counts[axis] = 0;
+				for (int offset = -reach; offset <= reach; ++offset) {
+					int c = center[axis] + offset;
+					if (periodic) c = ((c % count) + count) % count;
+					else if (c < 0 || c >= count) continue;
+					const int* const first = neighbours[axis];
+					const int* const last = first + neighbour_counts[axis];
+					if (std::find(first, last, c) == last) neighbours[axis][neighbour_counts[axis]++] = c;
+				}
+			}
+
+			for (unsigned int target = cell_begin[cell]; target < cell_begin[cell + 1]; ++target) {
+				const unsigned int i = cell_bodies[target];
+				const vec3 position = cell_positions[target];
+				vec3 force = vec3(0.0f), torque = vec3(0.0f);
+				for (unsigned int z = 0; z < neighbour_counts[2]; ++z) {
+					for (unsigned int y = 0; y < neighbour_counts[1]; ++y) {
+						for (unsigned int x = 0; x < neighbour_counts[0]; ++x) {
+							const unsigned int source_cell = (neighbours[2][z] * cell_counts[1] + neighbours[1][y]) * cell_counts[0] + neighbours[0][x];
+							for (unsigned int k = cell_begin[source_cell]; k < cell_begin[source_cell + 1]; ++k) {
+								if (k == target) continue;
+								vec3 r = cell_positions[k] - position;
+								if (periodic) r -= box * glm::round(r / box);
+								const float distance2 = glm::dot(r, r);
+								if (distance2 >= cutoff2) continue;
+								const float table_position = distance2 * table_scale;
+								const unsigned int entry = static_cast<unsigned int>(table_position);
+								const float fraction = table_position - entry;
+								const float force_factor = table.force[entry] + fraction * (table.force[entry + 1] - table.force[entry]);
+								const float tidal_factor = table.tidal[entry] + fraction * (table.tidal[entry + 1] - table.tidal[entry]);
+								const float mu = G * cell_masses[k];
+								force += force_factor * gravity_force(bodies.masses[i], r, mu);
+								torque += tidal_factor * gravity_torque(bodies.world_inertias[i], r, mu);
+							}
+						}
+					}
+				}
+				bodies.forces[i] += force;
+				bodies.torques[i] += torque;
+			}
+		}
+	});
+}
@@ -0,0 +1,154 @@
+#include <parareal/parareal.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using std::vector;
+using glm::vec3, glm::quat;
+
+void PararealState::capture(const BodyStore& bodies) {
+	positions.assign(bodies.positions.begin(), bodies.positions.end());
+	linear_momenta.assign(bodies.linear_momenta.begin(), bodies.linear_momenta.end());
+	angular_momenta.assign(bodies.angular_momenta.begin(), bodies.angular_momenta.end());
+	orientations.assign(bodies.orientations.begin(), bodies.orientations.end());
+}
+
+void PararealState::restore(BodyStore& bodies) const {
+	std::copy(positions.begin(), positions.end(), bodies.positions.begin());
+	std::copy(linear_momenta.begin(), linear_momenta.end(), bodies.linear_momenta.begin());
+	std::copy(angular_momenta.begin(), angular_momenta.end(), bodies.angular_momenta.begin());
+	std::copy(orientations.begin(), orientations.end(), bodies.orientations.begin());
+	bodies.update_auxiliary_variables();
+}
+
+/// <summary>
+/// The parareal correction coarse + fine - previous_coarse
+/// </summary>
+static PararealState correct(const PararealState& coarse, const PararealState& fine, const PararealState& previous_coarse) {
+	PararealState result = coarse;
+	for (unsigned int i = 0; i < coarse.positions.size(); ++i) {
+		result.positions[i] += fine.positions[i] - previous_coarse.positions[i];
+		result.linear_momenta[i] += fine.linear_momenta[i] - previous_coarse.linear_momenta[i];
+		result.angular_momenta[i] += fine.angular_momenta[i] - previous_coarse.angular_momenta[i];
+		// q and -q are the same rotation, the difference is taken between matching signs
+		const quat q = coarse.orientations[i];
+		const quat f = glm::dot(fine.orientations[i], q) < 0.0f ? -fine.orientations[i] : fine.orientations[i];
+		const quat p = glm::dot(previous_coarse.orientations[i], q) < 0.0f ? -previous_coarse.orientations[i] : previous_coarse.orientations[i];
+		result.orientations[i] = glm::normalize(q + (f - p));
+	}
+	return result;
+}
+
+/// <summary>
+/// Largest change of position and velocity between two states, in units of the given scales
+/// </summary>
+static double state_change(const PararealState& a, const PararealState& b, const vector<float>& masses, const double length_scale, const double speed_scale) {
+	double change = 0.0;
+	for (unsigned int i = 0; i < a.positions.size(); ++i) {
+		change = std::max(change, glm::length(a.positions[i] - b.positions[i]) / length_scale);
+		change = std::max(change, glm::length(a.linear_momenta[i] - b.linear_momenta[i]) / masses[i] / speed_scale);
+	}
+	return change;
+}
+
+PararealDriver::PararealDriver(const PararealSettings& settings) {
+	this->settings = settings;
+}
+
+const PararealStatistics& PararealDriver::statistics() const {
+	return stats;
+}
+
+void PararealDriver::run(BodyStore& bodies, const GravitySettings& gravity, const std::function<Integrator()>& make_fine,
+	const float delta_time, const unsigned int step_count, ThreadPool& thread_pool) {
+	using clock = std::chrono::steady_clock;
+	stats = PararealStatistics();
+	const unsigned int n = bodies.size();
+	const unsigned int slice_count = std::max(1u, std::min(settings.slice_count, step_count));
+	const unsigned int max_iterations = settings.max_iterations > 0 ? std::min(settings.max_iterations, slice_count) : slice_count;
+	if (n == 0 || step_count == 0) return;
+
+	// Fine steps of every slice, and the coarse steps covering the same time
+	vector<unsigned int> fine_steps(slice_count), coarse_steps(slice_count);
+	for (unsigned int s = 0; s < slice_count; ++s) {
+		fine_steps[s] = (s + 1) * step_count / slice_count - s * step_count / slice_count;
+		coarse_steps[s] = std::max(1u, (fine_steps[s] + settings.coarse_ratio - 1) / std::max(settings.coarse_ratio, 1u));
+	}
+
+	// Scales of the convergence test: spread of positions and velocities around the center of mass, unweighted so that
+	// light bodies count as much as heavy ones
+	float total_mass = 0.0f;
+	vec3 center = vec3(0.0f), center_velocity = vec3(0.0f);
+	for (unsigned int i = 0; i < n; ++i) {
+		total_mass += bodies.masses[i];
+		center += bodies.masses[i] * bodies.positions[i];
+		center_velocity += bodies.linear_momenta[i];
+	}
+	center /= total_mass;
+	center_velocity /= total_mass;
+	double length_scale = 0.0, speed_scale = 0.0;
+	for (unsigned int i = 0; i < n; ++i) {
+		length_scale += glm::dot(bodies.positions[i] - center, bodies.positions[i] - center);
+		const vec3 velocity = bodies.linear_momenta[i] / bodies.masses[i] - center_velocity;
+		speed_scale += glm::dot(velocity, velocity);
+	}
+	length_scale = std::max(std::sqrt(length_scale / n), 1e-30);
+	speed_scale = std::max(std::sqrt(speed_scale / n), 1e-30);
+
+	// Every slice integrates in its own copy of the store, serially
+	vector<BodyStore> workspaces(slice_count, bodies);
+	auto coarse = [&](const PararealState& start, const unsigned int s, ThreadPool& pool) {
+		BodyStore& store = workspaces[s];
+		start.restore(store);
+		Integrator integrator(settings.coarse_integrator);
+		const float coarse_step = static_cast<float>(static_cast<double>(fine_steps[s]) * delta_time / coarse_steps[s]);
+		for (unsigned int step = 0; step < coarse_steps[s]; ++step) integrator.step(store, gravity, coarse_step, pool);
+		stats.coarse_evaluations += integrator.evaluations();
+		PararealState end;
+		end.capture(store);
+		return end;
+	};
+
+	vector<PararealState> boundaries(slice_count + 1), coarse_results(slice_count), fine_results(slice_count);
+	vector<unsigned long long> fine_evaluations(slice_count, 0);
+	boundaries[0].capture(bodies);
+	auto start_time = clock::now();
+	for (unsigned int s = 0; s < slice_count; ++s) {
+		coarse_results[s] = coarse(boundaries[s], s, thread_pool);
+		boundaries[s + 1] = coarse_results[s];
+	}
+	stats.initial_seconds = std::chrono::duration<double>(clock::now() - start_time).count();
+
+	for (unsigned int k = 1; k <= max_iterations; ++k) {
+		start_time = clock::now();
+		// Slices before k - 1 start from exact boundaries and already hold their fine solution
+		const unsigned int first = k - 1;
+		thread_pool.run(slice_count - first, [&](const unsigned int index) {
+			const unsigned int s = first + index;
+			ThreadPool serial(1);
+			BodyStore& store = workspaces[s];
+			boundaries[s].restore(store);
+			Integrator integrator = make_fine();
+			for (unsigned int step = 0; step < fine_steps[s]; ++step) integrator.step(store, gravity, delta_time, serial);
+			fine_evaluations[s] += integrator.evaluations();
+			fine_results[s].capture(store);
+		});
+
+		double change = state_change(fine_results[first], boundaries[first + 1], bodies.masses, length_scale, speed_scale);
+		boundaries[first + 1] = fine_results[first];
+		for (unsigned int s = first + 1; s < slice_count; ++s) {
+			const PararealState coarse_result = coarse(boundaries[s], s, thread_pool);
+			const PararealState corrected = correct(coarse_result, fine_results[s], coarse_results[s]);
+			change = std::max(change, state_change(corrected, boundaries[s + 1], bodies.masses, length_scale, speed_scale));
+			coarse_results[s] = coarse_result;
+			boundaries[s + 1] = corrected;
+		}
+		stats.iterations.push_back({ change, std::chrono::duration<double>(clock::now() - start_time).count() });
+		if (change <= settings.tolerance || first + 1 == slice_count) {
+			stats.converged = true;
+			break;
+		}
+	}
+	for (const unsigned long long count : fine_evaluations) stats.fine_evaluations += count;
+	boundaries[slice_count].restore(bodies);
+}
@@ -0,0 +1,356 @@
+#include <particle_mesh/particle_mesh.hpp>
+#include <fft/fft.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+using std::array, std::complex, std::vector;
+using glm::mat3, glm::vec3;
+
+/// <summary>
+/// Nodes and weights of the assignment window along one axis, and the derivatives of the weights in grid units
+/// </summary>
+struct AssignmentStencil {
+	int first;
+	unsigned int count;
+	float weights[3];
+	float derivatives[3];
+};
+
+static AssignmentStencil make_stencil(const float u, const MassAssignment assignment) {
+	AssignmentStencil stencil;
+	if (assignment == MassAssignment::cic) {
+		const float base = std::floor(u);
+		const float f = u - base;
+		stencil.first = static_cast<int>(base);
+		stencil.count = 2;
+		stencil.weights[0] = 1.0f - f; stencil.weights[1] = f; stencil.weights[2] = 0.0f;
+		stencil.derivatives[0] = -1.0f; stencil.derivatives[1] = 1.0f; stencil.derivatives[2] = 0.0f;
+		return stencil;
+	}
+	const float base = std::floor(u + 0.5f);
+	const float d = u - base;
+	stencil.first = static_cast<int>(base) - 1;
+	stencil.count = 3;
+	stencil.weights[0] = 0.5f * (0.5f - d) * (0.5f - d);
+	stencil.weights[1] = 0.75f - d * d;
+	stencil.weights[2] = 0.5f * (0.5f + d) * (0.5f + d);
+	stencil.derivatives[0] = d - 0.5f;
+	stencil.derivatives[1] = -2.0f * d;
+	stencil.derivatives[2] = d + 0.5f;
+	return stencil;
+}
+
+/// <summary>
+/// Correlations of a stencil's weights, and of their derivatives, with its weights: c[d + 2] = sum_a w[a] w[a - d]
+/// </summary>
+struct StencilCorrelation {
+	float weights[5];
+	float derivatives[5];
+};
+
+static StencilCorrelation correlate(const AssignmentStencil& stencil) {
+	StencilCorrelation correlation = {};
+	for (unsigned int a = 0; a < stencil.count; ++a) {
+		for (unsigned int b = 0; b < stencil.count; ++b) {
+			correlation.weights[a + 2 - b] += stencil.weights[a] * stencil.weights[b];
+			correlation.derivatives[a + 2 - b] += stencil.derivatives[a] * stencil.weights[b];
+		}
+	}
+	return correlation;
+}
+
+static int wrap(const int i, const int n) {
+	return ((i % n) + n) % n;
+}
+
+/// <summary>
+/// Signed offset of node i of a periodic axis of n nodes, so the upper half of the axis holds negative offsets
+/// </summary>
+static float minimum_image(const unsigned int i, const unsigned int n) {
+	return i <= n / 2 ? static_cast<float>(i) : static_cast<float>(i) - static_cast<float>(n);
+}
+
+/// <summary>
+/// Response of an FFT grid to a unit mass, in units of G / h for the potential and G / h^2 for the field
+/// </summary>
+struct MeshGreenFunction {
+	// Spectrum of the potential. Real, since the potential of a point mass is even
+	vector<float> spectrum;
+	// Field at offsets [-2, 2]^3 from a unit mass sitting on a node, x fastest
+	array<vec3, 125> near_field;
+};
+
+/// <summary>
+/// Green's function of a grid of side n, computed once per configuration and cached.
+/// Isolated grids use -1 / r with minimum image offsets, so the padded half holds negative separations. The self
+/// term, -1, only shifts the potential of a body's own nodes. Periodic grids use -4 pi / k^2 without the k = 0 mode.
+/// With a split radius s (in cells) only the long-range part -erf(r / 2s) / r is kept, and the spectrum is divided by
+/// the square of the assignment window, which the deposition and the interpolation each apply once.
+/// </summary>
+static const MeshGreenFunction& mesh_green_function(const unsigned int n, const MeshBoundary boundary, const MassAssignment assignment,
+	const float split_radius, ThreadPool& thread_pool) {
+	static std::mutex mutex;
+	static std::map<std::tuple<unsigned int, MeshBoundary, MassAssignment, float>, MeshGreenFunction> cache;
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto key = std::make_tuple(n, boundary, assignment, split_radius);
+	const auto found = cache.find(key);
+	if (found != cache.end()) return found->second;
+
+	const float pi = 3.14159265f;
+	MeshGreenFunction green;
+	green.spectrum.resize(static_cast<size_t>(n) * n * n);
+	vector<complex<float>> values(green.spectrum.size());
+	for (unsigned int z = 0; z < n; ++z) {
+		for (unsigned int y = 0; y < n; ++y) {
+			for (unsigned int x = 0; x < n; ++x) {
+				const size_t i = (static_cast<size_t>(z) * n + y) * n + x;
+				const float dx = minimum_image(x, n), dy = minimum_image(y, n), dz = minimum_image(z, n);
+				const float r2 = dx * dx + dy * dy + dz * dz;
+				if (boundary == MeshBoundary::isolated) {
+					const float r = std::sqrt(r2);
+					if (split_radius <= 0.0f) values[i] = r > 0.0f ? -1.0f / r : -1.0f;
+					// erf(r / 2s) / r tends to 1 / (s sqrt(pi)) at the origin
+					else values[i] = r > 0.0f ? -std::erf(r / (2.0f * split_radius)) / r : -1.0f / (split_radius * std::sqrt(pi));
+				}
+				else {
+					// -4 pi G / (k^2 h^3) with k = 2 pi kappa / (n h) is -(G / h) n^2 / (pi kappa^2)
+					const float k2 = 4.0f * pi * pi * r2 / (static_cast<float>(n) * n);
+					green.spectrum[i] = r2 > 0.0f ? -static_cast<float>(n) * n / (pi * r2) * std::exp(-k2 * split_radius * split_radius) : 0.0f;
+				}
+			}
+		}
+	}
+	if (boundary == MeshBoundary::isolated) {
+		fft_3d(values, n, false, thread_pool);
+		for (size_t i = 0; i < values.size(); ++i) green.spectrum[i] = values[i].real();
+	}
+	if (split_radius > 0.0f) {
+		// The window of a node spacing is sinc(pi kappa / n) per axis, squared for CIC and cubed for TSC
+		const int power = assignment == MassAssignment::cic ? 4 : 6;
+		vector<float> window(n);
+		for (unsigned int k = 0; k < n; ++k) {
+			const float arg = pi * minimum_image(k, n) / n;
+			window[k] = std::pow(arg == 0.0f ? 1.0f : std::sin(arg) / arg, power);
+		}
+		for (unsigned int z = 0; z < n; ++z) {
+			for (unsigned int y = 0; y < n; ++y) {
+				for (unsigned int x = 0; x < n; ++x) {
+					green.spectrum[(static_cast<size_t>(z) * n + y) * n + x] /= window[x] * window[y] * window[z];
+				}
+			}
+		}
+	}
+
+	// Potential around a unit mass at node 0, differentiated like compute_field does
+	for (size_t i = 0; i < values.size(); ++i) values[i] = green.spectrum[i];
+	fft_3d(values, n, true, thread_pool);
+	const auto potential = [&](const int x, const int y, const int z) {
+		return values[(static_cast<size_t>(wrap(z, n)) * n + wrap(y, n)) * n + wrap(x, n)].real();
+	};
+	for (int z = -2; z <= 2; ++z) {
+		for (int y = -2; y <= 2; ++y) {
+			for (int x = -2; x <= 2; ++x) {
+				green.near_field[((z + 2) * 5 + y + 2) * 5 + x + 2] = -vec3(
+					8.0f * (potential(x + 1, y, z) - potential(x - 1, y, z)) - (potential(x + 2, y, z) - potential(x - 2, y, z)),
+					8.0f * (potential(x, y + 1, z) - potential(x, y - 1, z)) - (potential(x, y + 2, z) - potential(x, y - 2, z)),
+					8.0f * (potential(x, y, z + 1) - potential(x, y, z - 1)) - (potential(x, y, z + 2) - potential(x, y, z - 2))) / 12.0f;
+			}
+		}
+	}
+	return cache.emplace(key, std::move(green)).first->second;
+}
+
+ParticleMesh::ParticleMesh(const unsigned int size, const MeshBoundary boundary, const MassAssignment assignment, const float box_size,
+	const float split_radius) {
+	unsigned int rounded = min_mesh_size;
+	while (rounded < size) rounded *= 2;
+	this->size = rounded;
+	this->fft_size = boundary == MeshBoundary::isolated ? 2 * rounded : rounded;
+	this->boundary = boundary;
+	this->assignment = assignment;
+	this->box_size = box_size;
+	this->split_radius = split_radius;
+	this->origin = vec3(0.0f);
+	this->cell_size = 1.0f;
+}
+
+unsigned int ParticleMesh::grid_index(const int x, const int y, const int z) const {
+	const int n = fft_size;
+	return (static_cast<unsigned int>(wrap(z, n)) * n + wrap(y, n)) * n + wrap(x, n);
+}
+
+unsigned int ParticleMesh::field_index(const int x, const int y, const int z) const {
+	const int n = size;
+	return (static_cast<unsigned int>(wrap(z, n)) * n + wrap(y, n)) * n + wrap(x, n);
+}
+
+void ParticleMesh::accumulate_gravity(BodyStore& bodies, const float G, ThreadPool& thread_pool) {
+	if (bodies.size() == 0) return;
+	fit_grid(bodies);
+	deposit(bodies, thread_pool);
+	solve_potential(G, thread_pool);
+	compute_field(thread_pool);
+	interpolate(bodies, G, thread_pool);
+}
+
+void ParticleMesh::fit_grid(const BodyStore& bodies) {
+	if (boundary == MeshBoundary::periodic && box_size > 0.0f) {
+		cell_size = box_size / size;
+		origin = vec3(-0.5f * box_size);
+		return;
+	}
+	vec3 lower = bodies.positions[0];
+	vec3 upper = lower;
+	for (const vec3& p : bodies.positions) {
+		lower = glm::min(lower, p);
+		upper = glm::max(upper, p);
+	}
+	const vec3 extent_vector = upper - lower;
+	// Slightly enlarged so bodies on the upper boundary stay inside
+	const float extent = std::max({ extent_vector.x, extent_vector.y, extent_vector.z, 1e-6f }) * 1.001f;
+	if (boundary == MeshBoundary::periodic) {
+		cell_size = extent / size;
+		origin = lower;
+		return;
+	}
+	// Bodies stay mesh_margin nodes away from the edges, so neither the windows nor the 4-point difference
+	// reach the padded half of the FFT grid
+	cell_size = extent / (size - 1 - 2 * mesh_margin);
+	origin = 0.5f * (lower + upper) - vec3(0.5f * (size - 1) * cell_size);
+}
+
+void ParticleMesh::deposit(const BodyStore& bodies, ThreadPool& thread_pool) {
+	grid.assign(static_cast<size_t>(fft_size) * fft_size * fft_size, complex<float>(0.0f));
+	const unsigned int n = bodies.size();
+
+	// Bodies are bucketed by the first z node of their window, in groups of consecutive slabs. A window spans at most
+	// 3 slabs, so a group only writes into the next one: even groups run together, then odd ones. The amount of groups
+	// is even and fixed by the grid size, so the sums do not depend on the amount of threads.
+	const unsigned int group_width = std::max(size / 16, 4u);
+	const unsigned int group_count = size / group_width;
+	vector<unsigned int> group_of(n), offsets(group_count + 1, 0), order(n);
+	for (unsigned int i = 0; i < n; ++i) {
+		const float u = (bodies.positions[i].z - origin.z) / cell_size;
+		group_of[i] = wrap(make_stencil(u, assignment).first, size) / group_width;
+		++offsets[group_of[i] + 1];
+	}
+	for (unsigned int g = 0; g < group_count; ++g) {
+		offsets[g + 1] += offsets[g];
+	}
+	vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+	for (unsigned int i = 0; i < n; ++i) {
+		order[cursor[group_of[i]]++] = i;
+	}
+
+	for (unsigned int parity = 0; parity < 2; ++parity) {
+		thread_pool.run(group_count / 2, [&](const unsigned int task) {
+			const unsigned int group = 2 * task + parity;
+			for (unsigned int k = offsets[group]; k < offsets[group + 1]; ++k) {
+				const unsigned int i = order[k];
+				const vec3 u = (bodies.positions[i] - origin) / cell_size;
+				const AssignmentStencil sx = make_stencil(u.x, assignment);
+				const AssignmentStencil sy = make_stencil(u.y, assignment);
+				const AssignmentStencil sz = make_stencil(u.z, assignment);
+				for (unsigned int c = 0; c < sz.count; ++c) {
+					for (unsigned int b = 0; b < sy.count; ++b) {
+						const float weight = bodies.masses[i] * sz.weights[c] * sy.weights[b];
+						for (unsigned int a = 0; a < sx.count; ++a) {
+							grid[grid_index(sx.first + a, sy.first + b, sz.first + c)] += weight * sx.weights[a];
+						}
+					}
+				}
+			}
+		});
+	}
+}
+
+void ParticleMesh::solve_potential(const float G, ThreadPool& thread_pool) {
+	green = &mesh_green_function(fft_size, boundary, assignment, split_radius, thread_pool);
+	// Only the physical octant of an isolated grid holds mass, and only its potential is read
+	const unsigned int extent = boundary == MeshBoundary::isolated ? size : 0;
+	fft_3d(grid, fft_size, false, thread_pool, extent);
+	const float scale = G / cell_size;
+	thread_pool.parallel_for(grid.size(), 4096, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			grid[i] *= scale * green->spectrum[i];
+		}
+	});
+	fft_3d(grid, fft_size, true, thread_pool, extent);
+}
+
+void ParticleMesh::compute_field(ThreadPool& thread_pool) {
+	// g = -grad(phi) with the 4-point difference (8 (phi[i+1] - phi[i-1]) - (phi[i+2] - phi[i-2])) / 12h
+	const unsigned int n = size;
+	field_x.resize(static_cast<size_t>(n) * n * n);
+	field_y.resize(field_x.size());
+	field_z.resize(field_x.size());
+	const float scale = -1.0f / (12.0f * cell_size);
+	auto phi = [&](const int x, const int y, const int z) {
+		return grid[grid_index(x, y, z)].real();
+	};
+	thread_pool.parallel_for(n, 1, [&](const unsigned int begin, const unsigned int end) {
+		for (int z = begin; z < static_cast<int>(end); ++z) {
+			for (int y = 0; y < static_cast<int>(n); ++y) {
+				for (int x = 0; x < static_cast<int>(n); ++x) {
+					const unsigned int i = field_index(x, y, z);
+					field_x[i] = scale * (8.0f * (phi(x + 1, y, z) - phi(x - 1, y, z)) - (phi(x + 2, y, z) - phi(x - 2, y, z)));
+					field_y[i] = scale * (8.0f * (phi(x, y + 1, z) - phi(x, y - 1, z)) - (phi(x, y + 2, z) - phi(x, y - 2, z)));
+					field_z[i] = scale * (8.0f * (phi(x, y, z + 1) - phi(x, y, z - 1)) - (phi(x, y, z + 2) - phi(x, y, z - 2)));
+				}
+			}
+		}
+	});
+}
+
+void ParticleMesh::interpolate(BodyStore& bodies, const float G, ThreadPool& thread_pool) const {
+	thread_pool.parallel_for(bodies.size(), force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			const vec3 u = (bodies.positions[i] - origin) / cell_size;
+			const AssignmentStencil sx = make_stencil(u.x, assignment);
+			const AssignmentStencil sy = make_stencil(u.y, assignment);
+			const AssignmentStencil sz = make_stencil(u.z, assignment);
+			vec3 field = vec3(0.0f);
+			// Derivatives of the interpolated field along x, y and z, in grid units
+			vec3 dx = vec3(0.0f), dy = vec3(0.0f), dz = vec3(0.0f);
+			for (unsigned int c = 0; c < sz.count; ++c) {
+				for (unsigned int b = 0; b < sy.count; ++b) {
+					for (unsigned int a = 0; a < sx.count; ++a) {
+						const unsigned int node = field_index(sx.first + a, sy.first + b, sz.first + c);
+						const vec3 value = vec3(field_x[node], field_y[node], field_z[node]);
+						field += sx.weights[a] * sy.weights[b] * sz.weights[c] * value;
+						dx += sx.derivatives[a] * sy.weights[b] * sz.weights[c] * value;
+						dy += sx.weights[a] * sy.derivatives[b] * sz.weights[c] * value;
+						dz += sx.weights[a] * sy.weights[b] * sz.derivatives[c] * value;
+					}
+				}
+			}
+			// The body's own mass contributes to the field gradient at its position. Unlike its self force, this does not
+			// cancel, so it is removed using the field the mesh produces around a unit mass
+			const StencilCorrelation cx = correlate(sx), cy = correlate(sy), cz = correlate(sz);
+			vec3 self_dx = vec3(0.0f), self_dy = vec3(0.0f), self_dz = vec3(0.0f);
+			for (unsigned int z = 0; z < 5; ++z) {
+				for (unsigned int y = 0; y < 5; ++y) {
+					for (unsigned int x = 0; x < 5; ++x) {
+						const vec3& near = green->near_field[(z * 5 + y) * 5 + x];
+						self_dx += cx.derivatives[x] * cy.weights[y] * cz.weights[z] * near;
+						self_dy += cx.weights[x] * cy.derivatives[y] * cz.weights[z] * near;
+						self_dz += cx.weights[x] * cy.weights[y] * cz.derivatives[z] * near;
+					}
+				}
+			}
+			const float self_scale = G * bodies.masses[i] / (cell_size * cell_size);
+			dx -= self_scale * self_dx;
+			dy -= self_scale * self_dy;
+			dz -= self_scale * self_dz;
+			// Column j holds the derivative along axis j, so this is the Jacobian of the field. Its symmetric part is the tidal tensor
+			const mat3 jacobian = mat3(dx, dy, dz) / cell_size;
+			const mat3 tidal = 0.5f * (jacobian + glm::transpose(jacobian));
+			bodies.forces[i] += bodies.masses[i] * field;
+			bodies.torques[i] += tidal_torque(tidal, bodies.world_inertias[i]);
+		}
+	});
+}
@@ -0,0 +1,112 @@
+#include <physics_thread/physics_thread.hpp>
+#include <simulation/simulation.hpp>
+#include <step_control/step_control.hpp>
+#include <thread_pool/thread_pool.hpp>
+#include <algorithm>
+
+using glm::vec3, glm::quat;
+using clock_type = std::chrono::steady_clock;
+
+vec3 SimulationFrame::interpolated_position(const unsigned int index, const float alpha) const {
+	return glm::mix(previous_positions[index], positions[index], alpha);
+}
+
+quat SimulationFrame::interpolated_orientation(const unsigned int index, const float alpha) const {
+	return glm::slerp(previous_orientations[index], orientations[index], alpha);
+}
+
+PhysicsThread::PhysicsThread(BodyStore bodies, const SimulationOptions& options) : bodies(std::move(bodies)), options(options) {
+	solver = options.gravity.solver;
+	// Every buffer starts out with the initial state, so the reader has something to draw before the first step
+	for (unsigned int i = 0; i < 3; ++i) {
+		publish(0.0, 0);
+	}
+	frames.update();
+}
+
+PhysicsThread::~PhysicsThread() {
+	stop();
+}
+
+void PhysicsThread::start() {
+	if (running.exchange(true)) return;
+	worker = std::thread(&PhysicsThread::run, this);
+}
+
+void PhysicsThread::stop() {
+	running = false;
+	if (worker.joinable()) worker.join();
+}
+
+void PhysicsThread::set_solver(const GravitySolver solver) {
+	this->solver = solver;
+}
+
+const SimulationFrame& PhysicsThread::latest_frame() {
+	frames.update();
+	return frames.read_buffer();
+}
+
+float PhysicsThread::interpolation_factor(const SimulationFrame& frame) const {
+	const double elapsed = std::chrono::duration<double>(clock_type::now() - frame.published_at).count();
+	const double alpha = elapsed * options.time_scale / options.delta_time;
+	return static_cast<float>(std::clamp(alpha, 0.0, 1.0));
+}
+
+void PhysicsThread::publish(const double time, const unsigned long long step) {
+	SimulationFrame& frame = frames.write_buffer();
+	frame.positions.assign(bodies.positions.begin(), bodies.positions.end());
+	frame.orientations.assign(bodies.orientations.begin(), bodies.orientations.end());
+	if (step == 0) {
+		frame.previous_positions = frame.positions;
+		frame.previous_orientations = frame.orientations;
+	}
+	frame.time = time;
+	frame.step = step;
+	frame.published_at = clock_type::now();
+	frames.publish();
+}
+
+void PhysicsThread::run() {
+	ThreadPool thread_pool(options.thread_count);
+	Integrator integrator(options.integrator, options.kepler_threshold, options.regularization_radius);
+	StepController step_controller(options.step_control, options.delta_time);
+	const double delta_time = options.delta_time;
+	double accumulator = 0.0;
+	double time = 0.0;
+	unsigned long long step = 0;
+	GravitySettings settings = options.gravity;
+	auto last = clock_type::now();
+
+	while (running) {
+		const auto now = clock_type::now();
+		accumulator += std::chrono::duration<double>(now - last).count() * options.time_scale;
+		last = now;
+		accumulator = std::min(accumulator, max_steps_per_update * delta_time);
+
+		const unsigned int steps = static_cast<unsigned int>(accumulator / delta_time);
+		if (steps == 0) {
+			std::this_thread::sleep_for(std::chrono::duration<double>((delta_time - accumulator) / options.time_scale));
+			continue;
+		}
+
+		// Forces kept by the integrator came from the previous solver
+		const GravitySolver current_solver = solver;
+		if (settings.solver != current_solver) integrator.reset();
+		settings.solver = current_solver;
+		for (unsigned int i = 0; i < steps; ++i) {
+			if (i + 1 == steps) {
+				// Only the state right before the last step of the batch is needed for interpolation
+				SimulationFrame& frame = frames.write_buffer();
+				frame.previous_positions.assign(bodies.positions.begin(), bodies.positions.end());
+				frame.previous_orientations.assign(bodies.orientations.begin(), bodies.orientations.end());
+			}
+			if (options.step_control.adaptive) step_controller.advance(bodies, settings, integrator, delta_time, thread_pool);
+			else step_simulation(bodies, settings, integrator, static_cast<float>(delta_time), thread_pool);
+			accumulator -= delta_time;
+			time += delta_time;
+			++step;
+		}
+		publish(time, step);
+	}
+}
@@ -0,0 +1,202 @@
+#include <polyhedron_gravity/polyhedron_gravity.hpp>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <body_store/body_store.hpp>
+#include <gravity/gravity.hpp>
+
+using std::vector, std::cerr;
+using glm::vec3, glm::mat3;
+
+namespace {
+	// Faces seen along an edge while the model is built
+	struct EdgeFaces {
+		unsigned int first, second;
+		mat3 dyad = mat3(0.0f);
+		unsigned int count = 0;
+		// Direction the first face runs along the edge, the second one must run the other way
+		bool forward = false;
+	};
+}
+
+bool PolyhedronModel::build(const vector<vec3>& vertices) {
+	*this = PolyhedronModel();
+	if (vertices.empty() || vertices.size() % 3 != 0) {
+		cerr << "Error at PolyhedronModel::build: a triangle list needs a multiple of 3 vertices\n";
+		return false;
+	}
+	float volume = 0.0f;
+	for (size_t t = 0; t < vertices.size(); t += 3) {
+		volume += glm::dot(vertices[t], glm::cross(vertices[t + 1], vertices[t + 2]));
+	}
+	const bool reversed = volume < 0.0f;
+
+	// Welds the triangle list into shared vertices
+	std::map<std::tuple<float, float, float>, unsigned int> welded;
+	vector<vec3> points;
+	vector<unsigned int> corners(vertices.size());
+	for (size_t v = 0; v < vertices.size(); ++v) {
+		const auto key = std::make_tuple(vertices[v].x, vertices[v].y, vertices[v].z);
+		auto found = welded.find(key);
+		if (found == welded.end()) {
+			found = welded.emplace(key, static_cast<unsigned int>(points.size())).first;
+			points.push_back(vertices[v]);
+		}
+		corners[v] = found->second;
+	}
+
+	std::map<std::pair<unsigned int, unsigned int>, EdgeFaces> edge_faces;
+	for (size_t t = 0; t < vertices.size(); t += 3) {
+		const unsigned int a = corners[t], b = corners[t + (reversed ? 2 : 1)], c = corners[t + (reversed ? 1 : 2)];
+		const vec3 cross = glm::cross(points[b] - points[a], points[c] - points[a]);
+		if (a == b || b == c || c == a || glm::dot(cross, cross) == 0.0f) {
+			cerr << "Error at PolyhedronModel::build: triangle " << t / 3 << " is degenerate\n";
+			*this = PolyhedronModel();
+			return false;
+		}
+		const vec3 normal = glm::normalize(cross);
+		PolyhedronFace face = {};
+		face.vertices[0] = a;
+		face.vertices[1] = b;
+		face.vertices[2] = c;
+		face.normal[0] = normal.x;
+		face.normal[1] = normal.y;
+		face.normal[2] = normal.z;
+		face.offset = glm::dot(normal, points[a]);
+		faces.push_back(face);
+
+		const unsigned int ring[3] = { a, b, c };
+		for (unsigned int k = 0; k < 3; ++k) {
+			const unsigned int from = ring[k], to = ring[(k + 1) % 3];
+			EdgeFaces& edge = edge_faces[std::minmax(from, to)];
+			const bool forward = from < to;
+			if (edge.count == 2 || (edge.count == 1 && edge.forward == forward)) {
+				cerr << "Error at PolyhedronModel::build: the mesh is not closed, edge " << from << "-" << to
+					<< " does not separate two consistently wound triangles\n";
+				*this = PolyhedronModel();
+				return false;
+			}
+			edge.first = std::min(from, to);
+			edge.second = std::max(from, to);
+			edge.forward = forward;
+			++edge.count;
+			// Normal of the edge in the plane of the face, pointing out of the face
+			const vec3 edge_normal = glm::normalize(glm::cross(points[to] - points[from], normal));
+			edge.dyad += glm::outerProduct(normal, edge_normal);
+		}
+	}
+
+	for (const auto& [key, edge] : edge_faces) {
+		if (edge.count != 2) {
+			cerr << "Error at PolyhedronModel::build: the mesh is not closed, edge " << key.first << "-" << key.second
+				<< " borders a single triangle\n";
+			*this = PolyhedronModel();
+			return false;
+		}
+		// glm is column-major: dyad[c][r] is row r of column c. The dyad is symmetric up to rounding
+		const mat3& d = edge.dyad;
+		PolyhedronEdge record = {};
+		record.first = edge.first;
+		record.second = edge.second;
+		record.length = glm::length(points[edge.second] - points[edge.first]);
+		record.dyad[0] = d[0][0];
+		record.dyad[1] = d[1][1];
+		record.dyad[2] = d[2][2];
+		record.dyad[3] = 0.5f * (d[1][0] + d[0][1]);
+		record.dyad[4] = 0.5f * (d[2][0] + d[0][2]);
+		record.dyad[5] = 0.5f * (d[2][1] + d[1][2]);
+		const vec3 p = points[edge.first];
+		record.dyad_first[0] = record.dyad[0] * p.x + record.dyad[3] * p.y + record.dyad[4] * p.z;
+		record.dyad_first[1] = record.dyad[3] * p.x + record.dyad[1] * p.y + record.dyad[5] * p.z;
+		record.dyad_first[2] = record.dyad[4] * p.x + record.dyad[5] * p.y + record.dyad[2] * p.z;
+		edges.push_back(record);
+	}
+
+	for (const vec3& point : points) {
+		vertex_x.push_back(point.x);
+		vertex_y.push_back(point.y);
+		vertex_z.push_back(point.z);
+	}
+	return true;
+}
+
+bool PolyhedronModel::empty() const {
+	return faces.empty();
+}
+
+PolyhedronArrays PolyhedronModel::arrays(const float mu_density) const {
+	return PolyhedronArrays{ vertex_x.data(), vertex_y.data(), vertex_z.data(), static_cast<unsigned int>(vertex_x.size()),
+		edges.data(), static_cast<unsigned int>(edges.size()), faces.data(), static_cast<unsigned int>(faces.size()), mu_density };
+}
+
+void PolyhedronModel::field(const float mu_density, const float* x, const float* y, const float* z, const unsigned int count,
+	float* ax, float* ay, float* az, const SimdLevel simd_level, vector<float>& scratch) const {
+	scratch.resize(static_cast<size_t>(polyhedron_scratch_per_vertex) * vertex_x.size());
+	select_polyhedron_kernel(simd_level)(arrays(mu_density), x, y, z, count, scratch.data(), ax, ay, az);
+}
+
+bool polyhedron_pair(const BodyStore& bodies, const GravitySettings& settings, const unsigned int source, const unsigned int target) {
+	if (settings.polyhedron_range <= 0.0f || source == target) return false;
+	const MeshAsset& mesh = bodies.meshes.get(bodies.shapes[source].mesh);
+	if (mesh.polyhedron.empty()) return false;
+	const float target_radius = bodies.meshes.get(bodies.shapes[target].mesh).bounding_radius;
+	if (target_radius > polyhedron_point_ratio * mesh.bounding_radius) return false;
+	return glm::length(bodies.positions[target] - bodies.positions[source]) < settings.polyhedron_range * mesh.bounding_radius;
+}
+
+void accumulate_polyhedron_gravity(BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	if (settings.polyhedron_range <= 0.0f || n < 2) return;
+
+	vector<vector<unsigned int>> targets(n);
+	thread_pool.parallel_for(n, force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			for (unsigned int j = 0; j < n; ++j) {
+				if (polyhedron_pair(bodies, settings, i, j)) targets[i].push_back(j);
+			}
+		}
+	});
+
+	// Field of every source at its targets, vectorized across the targets in the frame of the source
+	vector<vector<vec3>> accelerations(n);
+	thread_pool.parallel_for(n, 1, [&](const unsigned int begin, const unsigned int end) {
+		vector<float> x, y, z, ax, ay, az, scratch;
+		for (unsigned int i = begin; i < end; ++i) {
+			if (targets[i].empty()) continue;
+			const unsigned int count = targets[i].size();
+			const unsigned int padded = (count + gravity_source_padding - 1) / gravity_source_padding * gravity_source_padding;
+			for (auto* values : { &x, &y, &z, &ax, &ay, &az }) {
+				values->assign(padded, 0.0f);
+			}
+			const mat3 to_local = glm::transpose(bodies.rotation_matrices[i]);
+			for (unsigned int t = 0; t < count; ++t) {
+				const vec3 local = to_local * (bodies.positions[targets[i][t]] - bodies.positions[i]);
+				x[t] = local.x;
+				y[t] = local.y;
+				z[t] = local.z;
+			}
+			const MeshAsset& mesh = bodies.meshes.get(bodies.shapes[i].mesh);
+			mesh.polyhedron.field(settings.G * bodies.shapes[i].density, x.data(), y.data(), z.data(), padded,
+				ax.data(), ay.data(), az.data(), settings.simd_level, scratch);
+			accelerations[i].resize(count);
+			for (unsigned int t = 0; t < count; ++t) {
+				accelerations[i][t] = bodies.rotation_matrices[i] * vec3(ax[t], ay[t], az[t]);
+			}
+		}
+	});
+
+	// Pairs share bodies, so they are applied in a fixed order on this thread
+	for (unsigned int i = 0; i < n; ++i) {
+		for (unsigned int t = 0; t < targets[i].size(); ++t) {
+			const unsigned int j = targets[i][t];
+			const vec3 offset = bodies.positions[j] - bodies.positions[i];
+			const vec3 force = bodies.masses[j] * accelerations[i][t];
+			// The solver treated the pair as two point masses, the source with a quadrupole torque
+			bodies.forces[j] += force - gravity_force(bodies.masses[j], -offset, settings.G * bodies.masses[i]);
+			bodies.forces[i] += -force - gravity_force(bodies.masses[i], offset, settings.G * bodies.masses[j]);
+			bodies.torques[i] += glm::cross(offset, -force) - gravity_torque(bodies.world_inertias[i], offset, settings.G * bodies.masses[j]);
+		}
+	}
+}
@@ -0,0 +1,343 @@
+#include <regularization/regularization.hpp>
+#include <algorithm>
+#include <cmath>
+#include <integrator/integrator.hpp>
+
+using std::vector;
+using glm::vec3;
+
+// Secant iterations that fit the last fictitious step to the end of the physical step
+constexpr unsigned int regularization_time_iterations = 16;
+constexpr double regularization_two_pi = 6.283185307179586;
+
+/// <summary>
+/// State of a group in the frame of its center of mass, in double precision. Positions and velocities are packed
+/// as x, y, z per member. binding is B = -E, the conjugate of time, which the perturbations change
+/// </summary>
+struct GroupState {
+	vector<double> x, v;
+	double time = 0.0, binding = 0.0;
+};
+
+/// <summary>
+/// Field of the perturbers of a group, relative to its center of mass, moving linearly over the step
+/// </summary>
+struct GroupPerturbation {
+	vector<double> start, end, mu;
+	double duration = 1.0;
+};
+
+static double potential(const vector<double>& x, const vector<double>& masses, const double G) {
+	double u = 0.0;
+	for (unsigned int a = 0; a < masses.size(); ++a) {
+		for (unsigned int b = a + 1; b < masses.size(); ++b) {
+			const double dx = x[3 * b] - x[3 * a], dy = x[3 * b + 1] - x[3 * a + 1], dz = x[3 * b + 2] - x[3 * a + 2];
+			u += G * masses[a] * masses[b] / std::sqrt(dx * dx + dy * dy + dz * dz);
+		}
+	}
+	return u;
+}
+
+static double kinetic(const vector<double>& v, const vector<double>& masses) {
+	double t = 0.0;
+	for (unsigned int a = 0; a < masses.size(); ++a) {
+		t += 0.5 * masses[a] * (v[3 * a] * v[3 * a] + v[3 * a + 1] * v[3 * a + 1] + v[3 * a + 2] * v[3 * a + 2]);
+	}
+	return t;
+}
+
+/// <summary>
+/// Unsoftened accelerations within the group, and the tidal accelerations of the perturbers at the given time,
+/// without the part common to the whole group so that its center of mass stays at rest
+/// </summary>
+static void group_accelerations(const vector<double>& x, const vector<double>& masses, const double G,
+	const GroupPerturbation& perturbation, const double time, vector<double>& internal, vector<double>& external) {
+	const unsigned int m = static_cast<unsigned int>(masses.size());
+	internal.assign(3 * m, 0.0);
+	external.assign(3 * m, 0.0);
+	for (unsigned int a = 0; a < m; ++a) {
+		for (unsigned int b = a + 1; b < m; ++b) {
+			const double d[3] = { x[3 * b] - x[3 * a], x[3 * b + 1] - x[3 * a + 1], x[3 * b + 2] - x[3 * a + 2] };
+			const double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+			const double inv_r3 = 1.0 / (r2 * std::sqrt(r2));
+			for (unsigned int k = 0; k < 3; ++k) {
+				internal[3 * a + k] += G * masses[b] * inv_r3 * d[k];
+				internal[3 * b + k] -= G * masses[a] * inv_r3 * d[k];
+			}
+		}
+	}
+	const unsigned int perturber_count = static_cast<unsigned int>(perturbation.mu.size());
+	if (perturber_count == 0) return;
+	const double fraction = time / perturbation.duration;
+	double total_mass = 0.0, common[3] = { 0.0, 0.0, 0.0 };
+	for (unsigned int a = 0; a < m; ++a) {
+		for (unsigned int p = 0; p < perturber_count; ++p) {
+			double d[3];
+			for (unsigned int k = 0; k < 3; ++k) {
+				const double position = perturbation.start[3 * p + k] + fraction * (perturbation.end[3 * p + k] - perturbation.start[3 * p + k]);
+				d[k] = position - x[3 * a + k];
+			}
+			const double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+			const double scale = perturbation.mu[p] / (r2 * std::sqrt(r2));
+			for (unsigned int k = 0; k < 3; ++k) external[3 * a + k] += scale * d[k];
+		}
+		total_mass += masses[a];
+		for (unsigned int k = 0; k < 3; ++k) common[k] += masses[a] * external[3 * a + k];
+	}
+	for (unsigned int a = 0; a < m; ++a) {
+		for (unsigned int k = 0; k < 3; ++k) external[3 * a + k] -= common[k] / total_mass;
+	}
+}
+
+/// <summary>
+/// One step of fictitious time step_size: the logarithmic Hamiltonian leapfrog composed into Yoshida's triple jump
+/// </summary>
+static void regularized_step(GroupState& state, const vector<double>& masses, const double G, const GroupPerturbation& perturbation,
+	const vector<SplittingStep>& operations, const double step_size, vector<double>& internal, vector<double>& external) {
+	const unsigned int m = static_cast<unsigned int>(masses.size());
+	for (const SplittingStep& operation : operations) {
+		const double h = operation.weight * step_size;
+		if (operation.kick) {
+			const double delta_time = h / potential(state.x, masses, G);
+			group_accelerations(state.x, masses, G, perturbation, state.time, internal, external);
+			double work = 0.0;
+			for (unsigned int i = 0; i < 3 * m; ++i) {
+				const double previous = state.v[i];
+				state.v[i] += delta_time * (internal[i] + external[i]);
+				work += masses[i / 3] * 0.5 * (previous + state.v[i]) * external[i];
+			}
+			state.binding -= delta_time * work;
+		}
+		else {
+			const double delta_time = h / (kinetic(state.v, masses) + state.binding);
+			for (unsigned int i = 0; i < 3 * m; ++i) state.x[i] += delta_time * state.v[i];
+			state.time += delta_time;
+		}
+	}
+}
+
+/// <summary>
+/// Fictitious time step giving regularization_steps_per_orbit steps per orbit of the pair that dominates the potential.
+/// Unbound pairs use the orbital period at their current separation
+/// </summary>
+static double fictitious_step(const GroupState& state, const vector<double>& masses, const double G) {
+	const unsigned int m = static_cast<unsigned int>(masses.size());
+	double largest = 0.0, step = 0.0;
+	for (unsigned int a = 0; a < m; ++a) {
+		for (unsigned int b = a + 1; b < m; ++b) {
+			double r2 = 0.0, v2 = 0.0;
+			for (unsigned int k = 0; k < 3; ++k) {
+				const double dx = state.x[3 * b + k] - state.x[3 * a + k], dv = state.v[3 * b + k] - state.v[3 * a + k];
+				r2 += dx * dx;
+				v2 += dv * dv;
+			}
+			const double distance = std::sqrt(r2);
+			const double term = G * masses[a] * masses[b] / distance;
+			if (term <= largest) continue;
+			largest = term;
+			const double mu = G * (masses[a] + masses[b]);
+			const double energy = 0.5 * v2 - mu / distance;
+			const double semi_major_axis = energy < 0.0 ? -mu / (2.0 * energy) : distance;
+			const double period = regularization_two_pi * std::sqrt(semi_major_axis * semi_major_axis * semi_major_axis / mu);
+			step = G * masses[a] * masses[b] / semi_major_axis * period / regularization_steps_per_orbit;
+		}
+	}
+	return step;
+}
+
+/// <summary>
+/// Advances the group by exactly duration of physical time. The last step is fitted to end on it with the secant method
+/// </summary>
+static void integrate_group(GroupState& state, const vector<double>& masses, const double G, const GroupPerturbation& perturbation,
+	const double duration) {
+	const vector<SplittingStep> operations = drift_kick_drift(yoshida4_weights, 3);
+	vector<double> internal, external;
+	double step_size = fictitious_step(state, masses, G);
+	// A group taking many orbits per step falls back to longer fictitious steps. The mean potential of a bound
+	// group is twice its binding energy
+	const double expected = duration * std::max(potential(state.x, masses, G), 2.0 * state.binding);
+	step_size = std::max(step_size, expected / regularization_max_substeps);
+
+	for (unsigned int substep = 0; substep < 4 * regularization_max_substeps && state.time < duration; ++substep) {
+		GroupState trial = state;
+		regularized_step(trial, masses, G, perturbation, operations, step_size, internal, external);
+		if (trial.time <= duration) {
+			state = trial;
+			continue;
+		}
+		// Elapsed time is monotonic in the step size over a single step
+		double low = 0.0, low_time = state.time, high = step_size, high_time = trial.time;
+		for (unsigned int iteration = 0; iteration < regularization_time_iterations; ++iteration) {
+			const double guess = low + (high - low) * (duration - low_time) / (high_time - low_time);
+			trial = state;
+			regularized_step(trial, masses, G, perturbation, operations, guess, internal, external);
+			if (std::abs(trial.time - duration) <= 1e-12 * duration) break;
+			if (trial.time < duration) {
+				low = guess;
+				low_time = trial.time;
+			}
+			else {
+				high = guess;
+				high_time = trial.time;
+			}
+		}
+		state = trial;
+		break;
+	}
+	state.time = duration;
+}
+
+bool RegularizedGroups::contains(const unsigned int index) const {
+	return index < group_of.size() && group_of[index] >= 0;
+}
+
+void RegularizedGroups::detect(const BodyStore& bodies, const float radius, const float delta_time, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	groups.clear();
+	group_of.assign(n, -1);
+	close.resize(n);
+	thread_pool.parallel_for(n, regularization_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			close[i].clear();
+			for (unsigned int j = i + 1; j < n; ++j) {
+				const vec3 r = bodies.positions[j] - bodies.positions[i];
+				const vec3 v = bodies.velocities[j] - bodies.velocities[i];
+				// Closest approach of the straight line relative motion within the step
+				const float speed2 = glm::dot(v, v);
+				const float t = speed2 > 0.0f ? std::clamp(-glm::dot(r, v) / speed2, 0.0f, delta_time) : 0.0f;
+				const vec3 closest = r + t * v;
+				if (glm::dot(closest, closest) < radius * radius) close[i].push_back(j);
+			}
+		}
+	});
+
+	// Connected components of the close pairs, with union-find
+	parents.resize(n);
+	for (unsigned int i = 0; i < n; ++i) parents[i] = i;
+	auto root = [&](unsigned int i) {
+		while (parents[i] != i) {
+			parents[i] = parents[parents[i]];
+			i = parents[i];
+		}
+		return i;
+	};
+	for (unsigned int i = 0; i < n; ++i) {
+		for (const unsigned int j : close[i]) {
+			const unsigned int a = root(i), b = root(j);
+			if (a != b) parents[std::max(a, b)] = std::min(a, b);
+		}
+	}
+	vector<int> component(n, -1);
+	vector<RegularizedGroup> components;
+	for (unsigned int i = 0; i < n; ++i) {
+		const unsigned int r = root(i);
+		if (component[r] < 0) {
+			component[r] = static_cast<int>(components.size());
+			components.emplace_back();
+		}
+		components[component[r]].members.push_back(i);
+	}
+	for (RegularizedGroup& candidate : components) {
+		if (candidate.members.size() < 2 || candidate.members.size() > regularization_max_group) continue;
+		for (const unsigned int i : candidate.members) group_of[i] = static_cast<int>(groups.size());
+		groups.push_back(std::move(candidate));
+	}
+
+	// Perturbers: tidal acceleration 2 G m R / d^3 across the group against its own attraction G M / R^2
+	for (unsigned int g = 0; g < groups.size(); ++g) {
+		RegularizedGroup& group = groups[g];
+		float total_mass = 0.0f;
+		vec3 center = vec3(0.0f);
+		for (const unsigned int i : group.members) {
+			total_mass += bodies.masses[i];
+			center += bodies.masses[i] * bodies.positions[i];
+		}
+		center /= total_mass;
+		float extent = radius;
+		for (const unsigned int i : group.members) extent = std::max(extent, glm::length(bodies.positions[i] - center));
+		const float extent3 = extent * extent * extent;
+		for (unsigned int k = 0; k < n; ++k) {
+			if (group_of[k] == static_cast<int>(g)) continue;
+			const float distance = glm::length(bodies.positions[k] - center);
+			if (2.0f * bodies.masses[k] * extent3 > regularization_perturbation_floor * total_mass * distance * distance * distance) {
+				group.perturbers.push_back(k);
+			}
+		}
+	}
+}
+
+void RegularizedGroups::save(const BodyStore& bodies) {
+	saved_positions.assign(bodies.positions.begin(), bodies.positions.end());
+	saved_velocities.assign(bodies.velocities.begin(), bodies.velocities.end());
+	saved_angular_momenta.assign(bodies.angular_momenta.begin(), bodies.angular_momenta.end());
+	saved_orientations.assign(bodies.orientations.begin(), bodies.orientations.end());
+}
+
+void RegularizedGroups::apply(BodyStore& bodies, const float G, const float delta_time, ThreadPool& thread_pool) {
+	// Groups are written in parallel while they read each other's members as perturbers
+	end_positions.assign(bodies.positions.begin(), bodies.positions.end());
+	const unsigned int count = static_cast<unsigned int>(groups.size());
+	thread_pool.parallel_for(count, 1, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int g = begin; g < end; ++g) {
+			const RegularizedGroup& group = groups[g];
+			const unsigned int m = static_cast<unsigned int>(group.members.size());
+			vector<double> masses(m);
+			double total_mass = 0.0, start_center[3] = { 0.0, 0.0, 0.0 }, start_velocity[3] = { 0.0, 0.0, 0.0 };
+			double end_center[3] = { 0.0, 0.0, 0.0 }, end_momentum[3] = { 0.0, 0.0, 0.0 };
+			for (unsigned int a = 0; a < m; ++a) {
+				const unsigned int i = group.members[a];
+				masses[a] = bodies.masses[i];
+				total_mass += masses[a];
+				for (unsigned int k = 0; k < 3; ++k) {
+					start_center[k] += masses[a] * saved_positions[i][k];
+					start_velocity[k] += masses[a] * saved_velocities[i][k];
+					end_center[k] += masses[a] * end_positions[i][k];
+					end_momentum[k] += bodies.linear_momenta[i][k];
+				}
+			}
+			for (unsigned int k = 0; k < 3; ++k) {
+				start_center[k] /= total_mass;
+				start_velocity[k] /= total_mass;
+				end_center[k] /= total_mass;
+			}
+
+			GroupState state;
+			state.x.resize(3 * m);
+			state.v.resize(3 * m);
+			for (unsigned int a = 0; a < m; ++a) {
+				const unsigned int i = group.members[a];
+				for (unsigned int k = 0; k < 3; ++k) {
+					state.x[3 * a + k] = saved_positions[i][k] - start_center[k];
+					state.v[3 * a + k] = saved_velocities[i][k] - start_velocity[k];
+				}
+			}
+			state.binding = potential(state.x, masses, G) - kinetic(state.v, masses);
+
+			GroupPerturbation perturbation;
+			perturbation.duration = delta_time;
+			for (const unsigned int p : group.perturbers) {
+				perturbation.mu.push_back(static_cast<double>(G) * bodies.masses[p]);
+				for (unsigned int k = 0; k < 3; ++k) {
+					perturbation.start.push_back(saved_positions[p][k] - start_center[k]);
+					perturbation.end.push_back(end_positions[p][k] - end_center[k]);
+				}
+			}
+
+			integrate_group(state, masses, G, perturbation, delta_time);
+
+			for (unsigned int a = 0; a < m; ++a) {
+				const unsigned int i = group.members[a];
+				vec3 position, velocity;
+				for (unsigned int k = 0; k < 3; ++k) {
+					position[k] = static_cast<float>(end_center[k] + state.x[3 * a + k]);
+					velocity[k] = static_cast<float>(end_momentum[k] / total_mass + state.v[3 * a + k]);
+				}
+				bodies.positions[i] = position;
+				bodies.linear_momenta[i] = bodies.masses[i] * velocity;
+				bodies.angular_momenta[i] = saved_angular_momenta[i];
+				bodies.orientations[i] = rotate_free_body(saved_orientations[i], saved_angular_momenta[i],
+					bodies.principal_moments[i], bodies.principal_frames[i], delta_time);
+			}
+		}
+	});
+}
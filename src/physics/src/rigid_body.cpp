@@ -0,0 +1,80 @@
+#include <rigid_body/rigid_body.hpp>
+#include <cmath>
+
+using std::vector;
+using glm::mat3, glm::vec3, glm::quat;
+
+quat rotate_free_body(const quat& orientation, const vec3& angular_momentum,
+	const vec3& principal_moments, const quat& principal_frame, const float delta_time) {
+	// Rotation from the principal axes to the world, and the angular momentum in principal coordinates
+	quat rotation = orientation * principal_frame;
+	vec3 momentum = glm::conjugate(rotation) * angular_momentum;
+	const auto rotate_about = [&](const int axis, const float time) {
+		// Degenerate axes (point like bodies) carry no rotation
+		if (principal_moments[axis] <= 0.0f) return;
+		const float half_angle = 0.5f * momentum[axis] / principal_moments[axis] * time;
+		vec3 direction = vec3(0.0f);
+		direction[axis] = std::sin(half_angle);
+		const quat spin = quat(std::cos(half_angle), direction.x, direction.y, direction.z);
+		// The body turns by the angle while its momentum, seen from the body, turns back by it
+		rotation = rotation * spin;
+		momentum = glm::conjugate(spin) * momentum;
+	};
+	rotate_about(0, 0.5f * delta_time);
+	rotate_about(1, 0.5f * delta_time);
+	rotate_about(2, delta_time);
+	rotate_about(1, 0.5f * delta_time);
+	rotate_about(0, 0.5f * delta_time);
+	return glm::normalize(rotation * glm::conjugate(principal_frame));
+}
+
+RigidBody::RigidBody(const float density, const vector<vec3>& vertices,
+	const quat orientation_quat,
+	const vec3 linear_momentum,
+	const vec3 angular_momentum) {
+	this->density = density;
+	this->vertices = vertices;
+
+	this->center_of_mass = null_point;
+	this->center_of_mass.linear_momentum = linear_momentum;
+
+	this->angular_momentum = angular_momentum;
+	this->orientation_quat = orientation_quat;
+
+	const MassProperties properties = mass_property_cache().get(vertices, density);
+	this->volume = properties.volume;
+	this->center_of_mass.mass = properties.mass;
+	this->center_of_mass.position = properties.center_of_mass;
+	this->inertia_tensor = properties.inertia_tensor;
+	this->inverse_inertia_tensor = properties.inverse_inertia_tensor;
+	this->principal_moments = properties.principal_moments;
+	this->principal_frame = properties.principal_frame;
+	for (auto& v : this->vertices) {
+		v -= properties.center_of_mass;
+	}
+
+	// initialize auxiliary variables to 0
+	angular_velocity = vec3(0.0f);
+	velocity = vec3(0.0f);
+	this->center_of_mass.force = vec3(0.0f);
+	torque = vec3(0.0f);
+}
+
+void RigidBody::update_state(const float delta_time) {
+	angular_momentum += torque * delta_time;
+	center_of_mass.linear_momentum += center_of_mass.force * delta_time;
+
+	center_of_mass.position += velocity * delta_time;
+	orientation_quat = rotate_free_body(orientation_quat, angular_momentum, principal_moments, principal_frame, delta_time);
+
+	center_of_mass.force = vec3(0.0f);
+	torque = vec3(0.0f);
+}
+
+void RigidBody::update_auxiliary_variables() {
+	velocity = center_of_mass.linear_momentum / center_of_mass.mass;
+	rotation_matrix = glm::mat3_cast(orientation_quat);
+	inverse_world_inertia = rotation_matrix * inverse_inertia_tensor * glm::transpose(rotation_matrix);
+	world_inertia = rotation_matrix * inertia_tensor * glm::transpose(rotation_matrix);
+	angular_velocity = inverse_world_inertia * angular_momentum;
+}
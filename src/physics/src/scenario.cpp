@@ -0,0 +1,192 @@
+#include <scenario/scenario.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <tuple>
+
+using std::vector;
+using glm::vec3, glm::quat;
+
+const vector<vec3> tetrahedron_verts = {
+	{0.0f,  1.0f,  0.0f}, {-1.0f, -1.0f,  1.0f}, { 1.0f, -1.0f,  1.0f},
+	{0.0f,  1.0f,  0.0f}, { 1.0f, -1.0f,  1.0f}, { 0.0f, -1.0f, -1.0f},
+	{0.0f,  1.0f,  0.0f}, { 0.0f, -1.0f, -1.0f}, {-1.0f, -1.0f,  1.0f},
+	{-1.0f, -1.0f,  1.0f}, { 0.0f, -1.0f, -1.0f}, { 1.0f, -1.0f,  1.0f}
+};
+
+/// <summary>
+/// Places the bodies of the store according to (position, velocity, orientation, angular velocity) tuples.
+/// Positions are offsets from each body's center of mass.
+/// </summary>
+static void apply_starting_conditions(BodyStore& bodies, const vector<std::tuple<vec3, vec3, quat, vec3>>& starting_conditions) {
+	for (unsigned int i = 0; i < bodies.size(); i++) {
+		auto [position, velocity, rotation_quat, angular_velocity] = starting_conditions[i];
+		RigidBodyView body = bodies.view(i);
+		body.center_of_mass.position += position;
+		body.center_of_mass.linear_momentum += velocity * body.center_of_mass.mass;
+		body.orientation_quat = rotation_quat;
+	}
+	bodies.update_auxiliary_variables();
+	for (unsigned int i = 0; i < bodies.size(); i++) {
+		const vec3 angular_velocity = std::get<3>(starting_conditions[i]);
+		RigidBodyView body = bodies.view(i);
+		body.angular_momentum = body.world_inertia * angular_velocity;
+	}
+}
+
+BodyStore make_two_body_scenario() {
+	BodyStore bodies;
+	vector<std::tuple<vec3, vec3, quat, vec3>> starting_conditions;
+	const MeshHandle tetrahedron = bodies.meshes.add(tetrahedron_verts);
+	bodies.add(tetrahedron, 1.0f);
+	bodies.add(tetrahedron, 1.0f);
+
+	starting_conditions.emplace_back(
+		vec3(4.0f, 0.0f, -1.0f),
+		vec3(0.0f, 0.4f, 0.0f),
+		quat(1.0f, 0.0f, 0.0f, 0.0f),
+		vec3(0.1f, 0.0f, 0.0f)
+	);
+	starting_conditions.emplace_back(
+		vec3(5.0f, 0.0f, 0.0f),
+		vec3(0.0f, -0.4f, 0.0f),
+		quat(1.0f, 0.0f, 0.0f, 0.0f),
+		vec3(0.2f, 0.0f, 0.0f)
+	);
+	apply_starting_conditions(bodies, starting_conditions);
+	return bodies;
+}
+
+BodyStore make_cloud_scenario(const unsigned int body_count, const unsigned int seed) {
+	BodyStore bodies;
+	bodies.reserve(body_count);
+	const MeshHandle tetrahedron = bodies.meshes.add(tetrahedron_verts);
+	// Keep the average spacing between bodies around 4 units, regardless of their amount
+	const float radius = 4.0f * std::cbrt(static_cast<float>(body_count));
+
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	auto random_in_sphere = [&]() {
+		vec3 point;
+		do {
+			point = vec3(unit(generator), unit(generator), unit(generator));
+		} while (glm::dot(point, point) > 1.0f);
+		return point;
+	};
+
+	vector<std::tuple<vec3, vec3, quat, vec3>> starting_conditions;
+	starting_conditions.reserve(body_count);
+	for (unsigned int i = 0; i < body_count; ++i) {
+		bodies.add(tetrahedron, 1.0f);
+		const vec3 axis = random_in_sphere();
+		const float length = glm::length(axis);
+		const quat orientation = length > 0.0f ? glm::angleAxis(3.14159265f * unit(generator), axis / length) : quat(1.0f, 0.0f, 0.0f, 0.0f);
+		starting_conditions.emplace_back(
+			radius * random_in_sphere(),
+			0.1f * random_in_sphere(),
+			orientation,
+			0.5f * random_in_sphere()
+		);
+	}
+	apply_starting_conditions(bodies, starting_conditions);
+	return bodies;
+}
+
+BodyStore make_planetary_scenario(const unsigned int satellite_count, const unsigned int seed) {
+	BodyStore bodies;
+	bodies.reserve(satellite_count + 1);
+	const MeshHandle tetrahedron = bodies.meshes.add(tetrahedron_verts);
+	bodies.add(tetrahedron, planetary_central_density);
+	const float mu = bodies.masses[0];
+
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	vector<std::tuple<vec3, vec3, quat, vec3>> starting_conditions;
+	starting_conditions.reserve(satellite_count + 1);
+	starting_conditions.emplace_back(vec3(0.0f), vec3(0.0f), quat(1.0f, 0.0f, 0.0f, 0.0f), vec3(0.0f));
+	vec3 total_momentum = vec3(0.0f);
+	for (unsigned int i = 0; i < satellite_count; ++i) {
+		bodies.add(tetrahedron, planetary_satellite_density);
+		const float radius = planetary_inner_radius + (planetary_outer_radius - planetary_inner_radius) * unit(generator);
+		const float phase = 6.28318531f * unit(generator);
+		const float inclination = 0.05f * (unit(generator) - 0.5f);
+		const vec3 radial = vec3(std::cos(phase), std::sin(phase) * std::cos(inclination), std::sin(phase) * std::sin(inclination));
+		const vec3 normal = vec3(0.0f, -std::sin(inclination), std::cos(inclination));
+		const vec3 velocity = std::sqrt(mu / radius) * glm::cross(normal, radial);
+		total_momentum += bodies.masses[i + 1] * velocity;
+		starting_conditions.emplace_back(radius * radial, velocity, quat(1.0f, 0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.5f * unit(generator)));
+	}
+	std::get<1>(starting_conditions[0]) = -total_momentum / bodies.masses[0];
+	apply_starting_conditions(bodies, starting_conditions);
+	return bodies;
+}
+
+BodyStore make_scenario(const SimulationOptions& options) {
+	const bool persistent_cache = !options.mass_cache_path.empty();
+	// A missing cache file is expected on the first run, it is written below
+	if (persistent_cache && std::filesystem::exists(options.mass_cache_path)) {
+		mass_property_cache().load(options.mass_cache_path);
+	}
+	BodyStore bodies;
+	switch (options.scenario) {
+	case ScenarioKind::two_body: bodies = make_two_body_scenario(); break;
+	case ScenarioKind::cloud: bodies = make_cloud_scenario(options.body_count, options.seed); break;
+	case ScenarioKind::planetary: bodies = make_planetary_scenario(options.body_count, options.seed); break;
+	}
+	if (options.gravity.mesh_multipole_order > 0) {
+		bodies.meshes.set_multipole_order(options.gravity.mesh_multipole_order);
+	}
+	if (options.gravity.polyhedron_range > 0.0f) {
+		bodies.meshes.set_polyhedron_models(true);
+	}
+	if (persistent_cache) {
+		mass_property_cache().save(options.mass_cache_path);
+	}
+	return bodies;
+}
+
+TracerStore make_scenario_tracers(const SimulationOptions& options, const BodyStore& bodies) {
+	TracerStore tracers;
+	if (options.tracer_count == 0 || bodies.size() == 0) return tracers;
+	tracers.reserve(options.tracer_count);
+	// Seeded apart from the bodies, so adding tracers does not change the scenario
+	std::mt19937 generator(options.seed + 1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	if (options.scenario == ScenarioKind::planetary) {
+		const vec3 center = bodies.positions[0];
+		const vec3 center_velocity = bodies.linear_momenta[0] / bodies.masses[0];
+		const float mu = options.gravity.G * bodies.masses[0];
+		for (unsigned int i = 0; i < options.tracer_count; ++i) {
+			const float radius = planetary_inner_radius + (planetary_outer_radius - planetary_inner_radius) * unit(generator);
+			const float phase = 6.28318531f * unit(generator);
+			const vec3 radial = vec3(std::cos(phase), std::sin(phase), 0.02f * (unit(generator) - 0.5f));
+			const vec3 velocity = std::sqrt(mu / radius) * glm::normalize(glm::cross(vec3(0.0f, 0.0f, 1.0f), radial));
+			tracers.add(center + radius * radial, center_velocity + velocity);
+		}
+		return tracers;
+	}
+
+	float total_mass = 0.0f;
+	vec3 center_of_mass = vec3(0.0f), total_momentum = vec3(0.0f);
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		total_mass += bodies.masses[i];
+		center_of_mass += bodies.masses[i] * bodies.positions[i];
+		total_momentum += bodies.linear_momenta[i];
+	}
+	center_of_mass /= total_mass;
+	float radius = 1.0f;
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		radius = std::max(radius, glm::length(bodies.positions[i] - center_of_mass));
+	}
+	std::uniform_real_distribution<float> symmetric(-1.0f, 1.0f);
+	for (unsigned int i = 0; i < options.tracer_count; ++i) {
+		vec3 point;
+		do {
+			point = vec3(symmetric(generator), symmetric(generator), symmetric(generator));
+		} while (glm::dot(point, point) > 1.0f);
+		tracers.add(center_of_mass + radius * point, total_momentum / total_mass);
+	}
+	return tracers;
+}
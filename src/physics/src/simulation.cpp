@@ -0,0 +1,36 @@
+#include <simulation/simulation.hpp>
+#include <fstream>
+#include <iostream>
+
+using std::cerr, std::string;
+
+void step_simulation(BodyStore& bodies, const GravitySettings& settings, Integrator& integrator, const float delta_time, ThreadPool& thread_pool) {
+	integrator.step(bodies, settings, delta_time, thread_pool);
+}
+
+void step_simulation(BodyStore& bodies, TracerStore& tracers, const GravitySettings& settings, Integrator& integrator, const float delta_time, ThreadPool& thread_pool) {
+	tracers.begin_step(bodies, settings, delta_time, thread_pool);
+	integrator.step(bodies, settings, delta_time, thread_pool);
+	tracers.finish_step(bodies, settings, delta_time, thread_pool);
+}
+
+bool write_state_csv(const BodyStore& bodies, const string& path) {
+	std::ofstream file(path);
+	if (!file) {
+		cerr << "Error at write_state_csv: could not open " << path << "\n";
+		return false;
+	}
+	file << "index,mass,x,y,z,vx,vy,vz,qw,qx,qy,qz,lx,ly,lz\n";
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		const auto& p = bodies.positions[i];
+		const auto v = bodies.linear_momenta[i] / bodies.masses[i];
+		const auto& q = bodies.orientations[i];
+		const auto& l = bodies.angular_momenta[i];
+		file << i << ',' << bodies.masses[i] << ','
+			<< p.x << ',' << p.y << ',' << p.z << ','
+			<< v.x << ',' << v.y << ',' << v.z << ','
+			<< q.w << ',' << q.x << ',' << q.y << ',' << q.z << ','
+			<< l.x << ',' << l.y << ',' << l.z << '\n';
+	}
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,107 @@
+#include <step_control/step_control.hpp>
+#include <algorithm>
+
+using glm::vec3;
+
+// Left over time below this fraction of the interval is rounding, not another step
+constexpr double step_remainder_fraction = 1e-6;
+
+StepController::StepController(const StepControlSettings& settings, const float initial_step) {
+	this->settings = settings;
+	this->step = initial_step;
+}
+
+float StepController::current_step() const {
+	return step;
+}
+
+const StepStatistics& StepController::statistics() const {
+	return stats;
+}
+
+void StepController::save(const BodyStore& bodies) {
+	saved_positions.assign(bodies.positions.begin(), bodies.positions.end());
+	saved_linear_momenta.assign(bodies.linear_momenta.begin(), bodies.linear_momenta.end());
+	saved_angular_momenta.assign(bodies.angular_momenta.begin(), bodies.angular_momenta.end());
+	saved_orientations.assign(bodies.orientations.begin(), bodies.orientations.end());
+	start_accelerations.resize(bodies.size());
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		start_accelerations[i] = bodies.forces[i] / bodies.masses[i];
+	}
+}
+
+void StepController::restore(BodyStore& bodies) const {
+	std::copy(saved_positions.begin(), saved_positions.end(), bodies.positions.begin());
+	std::copy(saved_linear_momenta.begin(), saved_linear_momenta.end(), bodies.linear_momenta.begin());
+	std::copy(saved_angular_momenta.begin(), saved_angular_momenta.end(), bodies.angular_momenta.begin());
+	std::copy(saved_orientations.begin(), saved_orientations.end(), bodies.orientations.begin());
+	bodies.update_auxiliary_variables();
+}
+
+float StepController::step_error(const BodyStore& bodies, const Integrator& integrator) const {
+	const unsigned int n = bodies.size();
+	if (n == 0) return 0.0f;
+	float mean_acceleration = 0.0f;
+	for (unsigned int i = 0; i < n; ++i) {
+		mean_acceleration += glm::length(bodies.forces[i]) / bodies.masses[i];
+	}
+	mean_acceleration /= n;
+	float error = 0.0f;
+	for (unsigned int i = 0; i < n; ++i) {
+		// Kepler pairs and regularized groups follow their own motion
+		if (integrator.analytic(i)) continue;
+		const vec3 start = start_accelerations[i];
+		const vec3 end = bodies.forces[i] / bodies.masses[i];
+		const float scale = std::max({ glm::length(start), glm::length(end), step_acceleration_floor * mean_acceleration });
+		if (scale > 0.0f) error = std::max(error, glm::length(end - start) / (settings.tolerance * scale));
+	}
+	return error;
+}
+
+void StepController::record(const float step_size) {
+	++stats.accepted;
+	stats.simulated_time += step_size;
+	stats.smallest_step = std::min(stats.smallest_step, step_size);
+	stats.largest_step = std::max(stats.largest_step, step_size);
+}
+
+void StepController::advance(BodyStore& bodies, const GravitySettings& gravity, Integrator& integrator, const double duration, ThreadPool& thread_pool) {
+	double remaining = duration;
+	if (!settings.adaptive || integrator.kind() == IntegratorKind::hermite || integrator.kind() == IntegratorKind::wisdom_holman) {
+		while (remaining > step_remainder_fraction * duration) {
+			const float step_size = static_cast<float>(std::min<double>(step, remaining));
+			integrator.step(bodies, gravity, step_size, thread_pool);
+			record(step_size);
+			remaining -= step_size;
+		}
+		return;
+	}
+
+	while (remaining > step_remainder_fraction * duration) {
+		const bool clipped = step >= remaining;
+		const float step_size = clipped ? static_cast<float>(remaining) : step;
+		integrator.ensure_forces(bodies, gravity, thread_pool);
+		save(bodies);
+		integrator.step(bodies, gravity, step_size, thread_pool);
+		integrator.ensure_forces(bodies, gravity, thread_pool);
+
+		// The acceleration change grows linearly with the step
+		const float error = step_error(bodies, integrator);
+		float proposed = error > 0.0f ? step_size * std::clamp(step_safety / error, step_max_shrink, step_max_growth)
+			: step_size * step_max_growth;
+		proposed = std::max(proposed, settings.min_step);
+		if (settings.max_step > 0.0f) proposed = std::min(proposed, settings.max_step);
+
+		if (error > 1.0f && step_size > settings.min_step) {
+			restore(bodies);
+			integrator.reset();
+			++stats.rejected;
+			step = proposed;
+			continue;
+		}
+		record(step_size);
+		remaining -= step_size;
+		// A step shortened to fit the interval says nothing about how long the next one may be, unless it had to shrink
+		if (!clipped || proposed < step_size) step = proposed;
+	}
+}
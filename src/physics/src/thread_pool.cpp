@@ -0,0 +1,86 @@
+#include <thread_pool/thread_pool.hpp>
+#include <algorithm>
+
+unsigned int max_thread_count() {
+	return max_threads_per_core * std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+ThreadPool::ThreadPool(const unsigned int thread_count) {
+	unsigned int count = std::min(thread_count, max_thread_count());
+	if (count == 0) count = std::max(std::thread::hardware_concurrency(), 1u);
+	workers.reserve(count - 1);
+	for (unsigned int i = 1; i < count; ++i) {
+		workers.emplace_back(&ThreadPool::worker_loop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	start_condition.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+unsigned int ThreadPool::size() const {
+	return workers.size() + 1;
+}
+
+void ThreadPool::run(const unsigned int task_count, const std::function<void(unsigned int)>& task) {
+	if (task_count == 0) return;
+	if (workers.empty() || task_count == 1) {
+		for (unsigned int i = 0; i < task_count; ++i) {
+			task(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->current_task = &task;
+		this->task_count = task_count;
+		this->next_task = 0;
+		this->active_workers = workers.size();
+		++generation;
+	}
+	start_condition.notify_all();
+	drain();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done_condition.wait(lock, [this] { return active_workers == 0; });
+	current_task = nullptr;
+}
+
+void ThreadPool::parallel_for(const unsigned int n, const unsigned int block_size, const std::function<void(unsigned int, unsigned int)>& task) {
+	const unsigned int block = std::max(block_size, 1u);
+	const unsigned int block_count = (n + block - 1) / block;
+	run(block_count, [&](const unsigned int index) {
+		const unsigned int begin = index * block;
+		task(begin, std::min(begin + block, n));
+	});
+}
+
+void ThreadPool::worker_loop() {
+	unsigned int seen_generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start_condition.wait(lock, [&] { return stopping || generation != seen_generation; });
+			if (stopping) return;
+			seen_generation = generation;
+		}
+		drain();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--active_workers == 0) done_condition.notify_one();
+		}
+	}
+}
+
+void ThreadPool::drain() {
+	for (unsigned int i = next_task++; i < task_count; i = next_task++) {
+		(*current_task)(i);
+	}
+}
@@ -0,0 +1,145 @@
+#include <tracers/tracers.hpp>
+#include <cmath>
+
+using std::vector;
+using glm::vec3, glm::mat3;
+
+unsigned int TracerStore::size() const {
+	return count;
+}
+
+void TracerStore::reserve(const unsigned int count) {
+	const unsigned int padded = (count + tracer_padding - 1) / tracer_padding * tracer_padding;
+	for (auto* values : { &x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az }) {
+		values->reserve(padded);
+	}
+}
+
+void TracerStore::add(const vec3& position, const vec3& velocity) {
+	// Grow by a whole padding block, so the arrays always hold a multiple of tracer_padding
+	if (count == x.size()) {
+		for (auto* values : { &x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az }) {
+			values->resize(values->size() + tracer_padding, 0.0f);
+		}
+	}
+	x[count] = position.x;
+	y[count] = position.y;
+	z[count] = position.z;
+	vx[count] = velocity.x;
+	vy[count] = velocity.y;
+	vz[count] = velocity.z;
+	++count;
+	accelerations_current = false;
+}
+
+vec3 TracerStore::position(const unsigned int index) const {
+	return vec3(x[index], y[index], z[index]);
+}
+
+vec3 TracerStore::velocity(const unsigned int index) const {
+	return vec3(vx[index], vy[index], vz[index]);
+}
+
+void TracerStore::reset() {
+	accelerations_current = false;
+}
+
+unsigned long long TracerStore::evaluations() const {
+	return evaluation_count;
+}
+
+void TracerStore::evaluate(const BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool) {
+	sources.assign(bodies.positions, bodies.masses, settings.G);
+	const GravitySourceArrays arrays = sources.arrays();
+	const TracerKernel kernel = select_tracer_kernel(settings.simd_level);
+	const unsigned int padded = static_cast<unsigned int>(x.size());
+	thread_pool.parallel_for(padded, tracer_block_size, [&](const unsigned int begin, const unsigned int end) {
+		kernel(arrays, x.data() + begin, y.data() + begin, z.data() + begin, end - begin,
+			ax.data() + begin, ay.data() + begin, az.data() + begin);
+	});
+	evaluation_count += padded;
+	if (settings.polyhedron_range > 0.0f) add_polyhedron_gravity(bodies, settings, thread_pool);
+	accelerations_current = true;
+}
+
+void TracerStore::add_polyhedron_gravity(const BodyStore& bodies, const GravitySettings& settings, ThreadPool& thread_pool) {
+	for (unsigned int b = 0; b < bodies.size(); ++b) {
+		const MeshAsset& mesh = bodies.meshes.get(bodies.shapes[b].mesh);
+		if (mesh.polyhedron.empty()) continue;
+		const vec3 center = bodies.positions[b];
+		const float reach2 = settings.polyhedron_range * mesh.bounding_radius * settings.polyhedron_range * mesh.bounding_radius;
+		near_indices.clear();
+		for (unsigned int i = 0; i < count; ++i) {
+			const vec3 offset = position(i) - center;
+			if (glm::dot(offset, offset) < reach2) near_indices.push_back(i);
+		}
+		if (near_indices.empty()) continue;
+
+		// Gathered in the frame of the body and padded like the tracers. Padding points sit at its center of mass
+		const unsigned int near_count = near_indices.size();
+		const unsigned int padded = (near_count + tracer_padding - 1) / tracer_padding * tracer_padding;
+		for (auto* values : { &local_x, &local_y, &local_z, &local_ax, &local_ay, &local_az }) {
+			values->assign(padded, 0.0f);
+		}
+		const mat3& rotation = bodies.rotation_matrices[b];
+		const mat3 to_local = glm::transpose(rotation);
+		for (unsigned int k = 0; k < near_count; ++k) {
+			const vec3 local = to_local * (position(near_indices[k]) - center);
+			local_x[k] = local.x;
+			local_y[k] = local.y;
+			local_z[k] = local.z;
+		}
+		const float mu_density = settings.G * bodies.shapes[b].density;
+		thread_pool.parallel_for(padded, tracer_block_size, [&](const unsigned int begin, const unsigned int end) {
+			vector<float> scratch;
+			mesh.polyhedron.field(mu_density, local_x.data() + begin, local_y.data() + begin, local_z.data() + begin, end - begin,
+				local_ax.data() + begin, local_ay.data() + begin, local_az.data() + begin, settings.simd_level, scratch);
+		});
+		evaluation_count += padded;
+
+		// Minus the point mass acceleration the tracer kernel gave, with the same clamp
+		const float mu = settings.G * bodies.masses[b];
+		thread_pool.parallel_for(near_count, tracer_block_size, [&](const unsigned int begin, const unsigned int end) {
+			for (unsigned int k = begin; k < end; ++k) {
+				const unsigned int i = near_indices[k];
+				vec3 acceleration = rotation * vec3(local_ax[k], local_ay[k], local_az[k]);
+				const vec3 r = center - position(i);
+				const float r2 = glm::dot(r, r);
+				if (r2 > 0.0f) acceleration -= mu / (r2 < EPSILON ? EPSILON : r2) / std::sqrt(r2) * r;
+				ax[i] += acceleration.x;
+				ay[i] += acceleration.y;
+				az[i] += acceleration.z;
+			}
+		});
+	}
+}
+
+void TracerStore::kick(const float delta_time, ThreadPool& thread_pool) {
+	thread_pool.parallel_for(count, tracer_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			vx[i] += ax[i] * delta_time;
+			vy[i] += ay[i] * delta_time;
+			vz[i] += az[i] * delta_time;
+		}
+	});
+}
+
+void TracerStore::begin_step(const BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool) {
+	if (count == 0) return;
+	if (!accelerations_current) evaluate(bodies, settings, thread_pool);
+	kick(0.5f * delta_time, thread_pool);
+	thread_pool.parallel_for(count, tracer_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			x[i] += vx[i] * delta_time;
+			y[i] += vy[i] * delta_time;
+			z[i] += vz[i] * delta_time;
+		}
+	});
+	accelerations_current = false;
+}
+
+void TracerStore::finish_step(const BodyStore& bodies, const GravitySettings& settings, const float delta_time, ThreadPool& thread_pool) {
+	if (count == 0) return;
+	evaluate(bodies, settings, thread_pool);
+	kick(0.5f * delta_time, thread_pool);
+}
@@ -0,0 +1,125 @@
+#include <wisdom_holman/wisdom_holman.hpp>
+#include <algorithm>
+#include <gravity/gravity.hpp>
+#include <kepler/kepler.hpp>
+
+using glm::vec3;
+
+unsigned long long WisdomHolmanIntegrator::evaluations() const {
+	return evaluation_count;
+}
+
+void WisdomHolmanIntegrator::reset() {
+	forces_current = false;
+}
+
+void WisdomHolmanIntegrator::evaluate_interactions(BodyStore& bodies, const float G, const SimdLevel simd_level, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	// World inertias of the current orientations
+	bodies.update_auxiliary_variables();
+	// The central body is left out of the sources: its pull on the satellites is the Keplerian part of the motion
+	source_masses.assign(bodies.masses.begin(), bodies.masses.end());
+	source_masses[central] = 0.0f;
+	sources.assign(heliocentric_positions, source_masses, G);
+	const GravitySourceArrays arrays = sources.arrays();
+	const GravityKernel kernel = select_gravity_kernel(simd_level);
+	const float central_mu = G * bodies.masses[central];
+
+	interaction_forces.resize(n);
+	interaction_torques.resize(n);
+	thread_pool.parallel_for(n, force_block_size, [&](const unsigned int begin, const unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			const GravityTarget target = make_gravity_target(heliocentric_positions[i], bodies.masses[i], bodies.world_inertias[i], i);
+			vec3 force, torque;
+			kernel(arrays, target, &force.x, &torque.x);
+			// Tidal torque of the central body, which the sources do not include
+			if (i != central) torque += gravity_torque(bodies.world_inertias[i], -heliocentric_positions[i], central_mu);
+			interaction_forces[i] = force;
+			interaction_torques[i] = torque;
+		}
+	});
+	evaluation_count += n;
+	forces_current = true;
+}
+
+void WisdomHolmanIntegrator::kick(BodyStore& bodies, const float delta_time) {
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		if (i != central) barycentric_velocities[i] += interaction_forces[i] / bodies.masses[i] * delta_time;
+		bodies.angular_momenta[i] += interaction_torques[i] * delta_time;
+	}
+}
+
+void WisdomHolmanIntegrator::jump(const BodyStore& bodies, const float delta_time) {
+	vec3 satellite_momentum = vec3(0.0f);
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		if (i != central) satellite_momentum += bodies.masses[i] * barycentric_velocities[i];
+	}
+	const vec3 shift = satellite_momentum / bodies.masses[central] * delta_time;
+	for (unsigned int i = 0; i < bodies.size(); ++i) {
+		if (i != central) heliocentric_positions[i] += shift;
+	}
+}
+
+void WisdomHolmanIntegrator::step(BodyStore& bodies, const float G, const SimdLevel simd_level, const float delta_time, ThreadPool& thread_pool) {
+	const unsigned int n = bodies.size();
+	if (n < 2) {
+		bodies.update_auxiliary_variables();
+		bodies.drift(delta_time);
+		bodies.update_auxiliary_variables();
+		return;
+	}
+	const unsigned int heaviest = static_cast<unsigned int>(std::max_element(bodies.masses.begin(), bodies.masses.end()) - bodies.masses.begin());
+	if (heaviest != central) forces_current = false;
+	central = heaviest;
+
+	// Inertial to democratic heliocentric coordinates
+	float total_mass = 0.0f;
+	vec3 center_of_mass = vec3(0.0f), total_momentum = vec3(0.0f);
+	for (unsigned int i = 0; i < n; ++i) {
+		total_mass += bodies.masses[i];
+		center_of_mass += bodies.masses[i] * bodies.positions[i];
+		total_momentum += bodies.linear_momenta[i];
+	}
+	center_of_mass /= total_mass;
+	const vec3 center_of_mass_velocity = total_momentum / total_mass;
+	heliocentric_positions.resize(n);
+	barycentric_velocities.resize(n);
+	kepler_mus.assign(n, G * bodies.masses[central]);
+	for (unsigned int i = 0; i < n; ++i) {
+		heliocentric_positions[i] = bodies.positions[i] - bodies.positions[central];
+		barycentric_velocities[i] = bodies.linear_momenta[i] / bodies.masses[i] - center_of_mass_velocity;
+	}
+	heliocentric_positions[central] = vec3(0.0f);
+	barycentric_velocities[central] = vec3(0.0f);
+	kepler_mus[central] = 0.0f;
+
+	if (!forces_current) evaluate_interactions(bodies, G, simd_level, thread_pool);
+	kick(bodies, 0.5f * delta_time);
+	jump(bodies, 0.5f * delta_time);
+	kepler_drift(heliocentric_positions, barycentric_velocities, kepler_mus, delta_time, thread_pool);
+	for (unsigned int i = 0; i < n; ++i) {
+		bodies.orientations[i] = rotate_free_body(bodies.orientations[i], bodies.angular_momenta[i],
+			bodies.principal_moments[i], bodies.principal_frames[i], delta_time);
+	}
+	jump(bodies, 0.5f * delta_time);
+	evaluate_interactions(bodies, G, simd_level, thread_pool);
+	kick(bodies, 0.5f * delta_time);
+
+	// Back to inertial coordinates. The center of mass moves in a straight line
+	const vec3 new_center_of_mass = center_of_mass + center_of_mass_velocity * delta_time;
+	vec3 weighted_offset = vec3(0.0f), satellite_momentum = vec3(0.0f);
+	for (unsigned int i = 0; i < n; ++i) {
+		if (i == central) continue;
+		weighted_offset += bodies.masses[i] * heliocentric_positions[i];
+		satellite_momentum += bodies.masses[i] * barycentric_velocities[i];
+	}
+	const vec3 central_position = new_center_of_mass - weighted_offset / total_mass;
+	for (unsigned int i = 0; i < n; ++i) {
+		bodies.positions[i] = central_position + heliocentric_positions[i];
+		bodies.linear_momenta[i] = bodies.masses[i] * (barycentric_velocities[i] + center_of_mass_velocity);
+		bodies.forces[i] = interaction_forces[i];
+		bodies.torques[i] = interaction_torques[i];
+	}
+	bodies.linear_momenta[central] = bodies.masses[central] * center_of_mass_velocity - satellite_momentum;
+	bodies.update_auxiliary_variables();
+}
@@ -0,0 +1,206 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <body_store/body_store.hpp>
+#include <gravity/gravity.hpp>
+#include <mass_properties/mass_properties.hpp>
+#include <options/options.hpp>
+#include <rigid_body/rigid_body.hpp>
+#include <scenario/scenario.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+using std::cout, std::cerr, std::string, std::vector;
+
+struct BenchmarkOptions {
+	unsigned int min_bodies = 10;
+	unsigned int max_bodies = 1000000;
+	// The O(N^2) solvers are skipped above this size
+	unsigned int max_direct_bodies = 20000;
+	unsigned int repeats = 5;
+	unsigned int thread_count = 0;
+	unsigned int seed = 1;
+	GravitySettings gravity;
+	string output_path;
+};
+
+struct BenchmarkResult {
+	string name;
+	unsigned int bodies;
+	double seconds;
+	// Pairwise evaluations performed, 0 when the benchmark has no meaningful interaction count
+	double interactions;
+	// Bytes read and written by the benchmark, assuming every array is streamed once
+	double bytes;
+};
+
+// Keeps the compiler from discarding work whose result is otherwise unused
+volatile float benchmark_sink = 0.0f;
+
+// Estimated traffic per body of the integration loops of BodyStore
+constexpr double auxiliary_bytes_per_body = 4 + 16 + 12 + 12 + 2 * 36 + 12 + 3 * 36 + 12;
+constexpr double state_bytes_per_body = 2 * (12 * 4 + 16) + 12 * 2 + 12 * 2;
+// Every direct interaction reads one source: position and gravitational parameter
+constexpr double direct_bytes_per_interaction = 16;
+
+/// <summary>
+/// Reads "--key value" pairs. Accepted arguments are --min-bodies, --max-bodies, --max-direct-bodies, --repeats,
+/// --threads, --seed, --theta, --simd scalar|sse4.2|avx2|avx512 and --output (JSON path, stdout if absent)
+/// </summary>
+bool parse_benchmark_options(const int argc, char* argv[], BenchmarkOptions& options) {
+	if (argc % 2 == 0) {
+		cerr << "Error at parse_benchmark_options: missing value for " << argv[argc - 1] << "\n";
+		return false;
+	}
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const string key = argv[i];
+		const string value = argv[i + 1];
+		try {
+			if (key == "--min-bodies") options.min_bodies = std::max(1ul, std::stoul(value));
+			else if (key == "--max-bodies") options.max_bodies = std::stoul(value);
+			else if (key == "--max-direct-bodies") options.max_direct_bodies = std::stoul(value);
+			else if (key == "--repeats") options.repeats = std::max(1ul, std::stoul(value));
+			else if (key == "--threads") {
+				// Parsed signed, std::stoul would wrap "-1" around to billions of threads
+				const long thread_count = std::stol(value);
+				if (thread_count < 0 || thread_count > static_cast<long>(max_thread_count())) {
+					cerr << "Error at parse_benchmark_options: thread count must be between 0 and " << max_thread_count() << "\n";
+					return false;
+				}
+				options.thread_count = static_cast<unsigned int>(thread_count);
+			}
+			else if (key == "--seed") options.seed = std::stoul(value);
+			else if (key == "--theta") options.gravity.opening_angle = std::stof(value);
+			else if (key == "--simd") {
+				if (value == "scalar") options.gravity.simd_level = SimdLevel::scalar;
+				else if (value == "sse4.2") options.gravity.simd_level = SimdLevel::sse42;
+				else if (value == "avx2") options.gravity.simd_level = SimdLevel::avx2;
+				else if (value == "avx512") options.gravity.simd_level = SimdLevel::avx512;
+				else {
+					cerr << "Error at parse_benchmark_options: unknown instruction set " << value << "\n";
+					return false;
+				}
+			}
+			else if (key == "--output") options.output_path = value;
+			else {
+				cerr << "Error at parse_benchmark_options: unknown argument " << key << "\n";
+				return false;
+			}
+		}
+		catch (const std::exception&) {
+			cerr << "Error at parse_benchmark_options: invalid value " << value << " for " << key << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Runs setup followed by the timed work once as warm-up and then repeats times, returning the median time of the work
+/// </summary>
+double time_median(const unsigned int repeats, const std::function<void()>& setup, const std::function<void()>& work) {
+	vector<double> samples;
+	for (unsigned int i = 0; i <= repeats; ++i) {
+		setup();
+		const auto start = std::chrono::steady_clock::now();
+		work();
+		const auto end = std::chrono::steady_clock::now();
+		if (i > 0) samples.push_back(std::chrono::duration<double>(end - start).count());
+	}
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+void write_json(std::ostream& out, const BenchmarkOptions& options, const unsigned int threads, const vector<BenchmarkResult>& results) {
+	out << "{\n"
+		<< "  \"simd\": \"" << simd_level_name(options.gravity.simd_level) << "\",\n"
+		<< "  \"threads\": " << threads << ",\n"
+		<< "  \"repeats\": " << options.repeats << ",\n"
+		<< "  \"seed\": " << options.seed << ",\n"
+		<< "  \"theta\": " << options.gravity.opening_angle << ",\n"
+		<< "  \"results\": [\n";
+	for (unsigned int i = 0; i < results.size(); ++i) {
+		const BenchmarkResult& result = results[i];
+		out << "    {\"benchmark\": \"" << result.name << "\", \"bodies\": " << result.bodies
+			<< ", \"seconds\": " << result.seconds
+			<< ", \"bodies_per_second\": " << result.bodies / result.seconds
+			<< ", \"ns_per_interaction\": ";
+		if (result.interactions > 0.0) out << result.seconds * 1e9 / result.interactions;
+		else out << "null";
+		out << ", \"bandwidth_gb_per_second\": ";
+		if (result.bytes > 0.0) out << result.bytes / result.seconds * 1e-9;
+		else out << "null";
+		out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	if (!parse_benchmark_options(argc, argv, options)) {
+		return 1;
+	}
+	ThreadPool thread_pool(options.thread_count);
+	vector<BenchmarkResult> results;
+
+	for (unsigned long long n = options.min_bodies; n <= options.max_bodies; n *= 10) {
+		const unsigned int bodies_count = static_cast<unsigned int>(n);
+		cerr << "Benchmarking " << bodies_count << " bodies\n";
+		const BodyStore scenario = make_cloud_scenario(bodies_count, options.seed);
+		BodyStore bodies = scenario;
+		const auto reset = [&]() { bodies = scenario; };
+		const double pairs = static_cast<double>(bodies_count) * (bodies_count - 1);
+
+		for (const GravitySolver solver : { GravitySolver::direct, GravitySolver::symmetric, GravitySolver::barnes_hut, GravitySolver::fmm, GravitySolver::particle_mesh, GravitySolver::p3m }) {
+			const bool direct = solver == GravitySolver::direct || solver == GravitySolver::symmetric;
+			if (direct && bodies_count > options.max_direct_bodies) continue;
+			GravitySettings settings = options.gravity;
+			settings.solver = solver;
+			const double seconds = time_median(options.repeats, reset, [&]() { accumulate_gravity(bodies, settings, thread_pool); });
+			results.push_back({ string("force/") + solver_name(solver), bodies_count, seconds,
+				direct ? pairs : 0.0, direct ? pairs * direct_bytes_per_interaction : 0.0 });
+		}
+
+		const double auxiliary_seconds = time_median(options.repeats, reset, [&]() { bodies.update_auxiliary_variables(); });
+		results.push_back({ "update_auxiliary_variables", bodies_count, auxiliary_seconds, 0.0, auxiliary_bytes_per_body * bodies_count });
+
+		const double state_seconds = time_median(options.repeats, reset, [&]() { bodies.update_state(0.005f); });
+		results.push_back({ "update_state", bodies_count, state_seconds, 0.0, state_bytes_per_body * bodies_count });
+
+		// Mesh integration itself, bypassing the mass property cache. Capped at the direct limit
+		const unsigned int mass_property_count = std::min(bodies_count, options.max_direct_bodies);
+		const double mass_bytes = static_cast<double>(mass_property_count) * tetrahedron_verts.size() * sizeof(glm::vec3);
+		const double mass_seconds = time_median(options.repeats, []() {}, [&]() {
+			for (unsigned int i = 0; i < mass_property_count; ++i) {
+				benchmark_sink = compute_mesh_properties(tetrahedron_verts).volume;
+			}
+		});
+		results.push_back({ "mass_properties", mass_property_count, mass_seconds, 0.0, mass_bytes });
+
+		// Body construction once the mesh is cached: hashing the vertices and the lookup
+		mass_property_cache().get(tetrahedron_verts);
+		const double cached_seconds = time_median(options.repeats, []() {}, [&]() {
+			for (unsigned int i = 0; i < mass_property_count; ++i) {
+				const RigidBody body(1.0f, tetrahedron_verts);
+				benchmark_sink = body.center_of_mass.mass;
+			}
+		});
+		results.push_back({ "mass_properties_cached", mass_property_count, cached_seconds, 0.0, mass_bytes });
+	}
+
+	if (options.output_path.empty()) {
+		write_json(cout, options, thread_pool.size(), results);
+		return 0;
+	}
+	std::ofstream file(options.output_path);
+	if (!file) {
+		cerr << "Error at main: could not open " << options.output_path << "\n";
+		return 1;
+	}
+	write_json(file, options, thread_pool.size(), results);
+	return 0;
+}